@@ -0,0 +1,136 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Alarms.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Rule table compilation and per-sample evaluation (see Alarms.h).
+*/
+
+#include "Alarms.h"
+
+struct AlarmRule {
+  PGM_P name;
+  AlarmSignal signal;
+  AlarmKind kind;
+  const float* threshold;
+  float hysteresis;
+  uint16_t holdMs;
+};
+
+// ======================= Table (flash) =======================
+#define ALARM_NAME(id, name, ...) static const char id##_NAME[] PROGMEM = name;
+ALARM_TABLE(ALARM_NAME)
+#undef ALARM_NAME
+
+#define ALARM_ROW(id, name, signal, kind, threshold, hyst, hold) \
+  { id##_NAME, signal, kind, &threshold, hyst, hold },
+static const AlarmRule RULES[ALARM_COUNT] PROGMEM = {
+  ALARM_TABLE(ALARM_ROW)
+};
+#undef ALARM_ROW
+
+// ======================= Compiled rules =======================
+// Every rule becomes "x >= trip raises, x < clear clears", where x is the
+// level or rate, negated for BELOW / FALL rules.
+struct CompiledRule {
+  float trip;
+  float clear;
+  uint16_t holdMs;
+  uint8_t input;       // index into the per-sample inputs[] below
+  bool negate;
+  bool active;
+  bool pending;
+  unsigned long since; // condition first seen (hold timer)
+};
+
+static CompiledRule compiled[ALARM_COUNT];
+static uint32_t activeMask = 0;
+static AlarmHandler alarmHandler = nullptr;
+
+// Rate estimation, once per signal per sample
+const float RATE_ALPHA = 0.3;
+static float lastValue[ALARM_SIG_COUNT];
+static float rate[ALARM_SIG_COUNT];
+static unsigned long lastEvalMs = 0;
+static bool haveLast = false;
+
+void alarmsCompile() {
+  for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+    AlarmRule r;
+    memcpy_P(&r, &RULES[i], sizeof(r));
+    bool isRate = r.kind == ALARM_RISE_RATE || r.kind == ALARM_FALL_RATE;
+    bool negate = r.kind == ALARM_BELOW || r.kind == ALARM_FALL_RATE;
+    float threshold = *r.threshold;
+    float trip = (negate && !isRate) ? -threshold : threshold; // FALL threshold is already a magnitude
+
+    CompiledRule& c = compiled[i];
+    c.trip = trip;
+    c.clear = trip - r.hysteresis;
+    c.holdMs = r.holdMs;
+    c.input = r.signal + (isRate ? ALARM_SIG_COUNT : 0);
+    c.negate = negate;
+  }
+}
+
+void alarmsBegin(AlarmHandler handler) {
+  alarmHandler = handler;
+  alarmsCompile();
+}
+
+void alarmsEvaluate(unsigned long now, float voltage, float current, float soc) {
+  // inputs[0..2] = levels, inputs[3..5] = smoothed rates
+  float inputs[ALARM_SIG_COUNT * 2] = { voltage, current, soc };
+
+  float dt = (now - lastEvalMs) / 1000.0;
+  for (uint8_t s = 0; s < ALARM_SIG_COUNT; s++) {
+    if (haveLast && dt > 0 && !isnan(inputs[s]) && !isnan(lastValue[s])) {
+      rate[s] = RATE_ALPHA * ((inputs[s] - lastValue[s]) / dt) + (1.0 - RATE_ALPHA) * rate[s];
+    }
+    lastValue[s] = inputs[s];
+    inputs[ALARM_SIG_COUNT + s] = isnan(inputs[s]) ? NAN : rate[s];
+  }
+  lastEvalMs = now;
+  haveLast = true;
+
+  for (uint8_t i = 0; i < ALARM_COUNT; i++) {
+    CompiledRule& c = compiled[i];
+    float x = inputs[c.input];
+    if (isnan(x)) continue;
+    if (c.negate) x = -x;
+
+    if (!c.active) {
+      if (x < c.trip) {
+        c.pending = false;
+        continue;
+      }
+      if (!c.pending) {
+        c.pending = true;
+        c.since = now;
+      }
+      if (now - c.since < c.holdMs) continue;
+      c.active = true;
+      c.pending = false;
+      activeMask |= (1UL << i);
+      if (alarmHandler) alarmHandler((AlarmId)i, true);
+    } else if (x < c.clear) {
+      c.active = false;
+      activeMask &= ~(1UL << i);
+      if (alarmHandler) alarmHandler((AlarmId)i, false);
+    }
+  }
+}
+
+bool alarmActive(AlarmId id) {
+  return activeMask & (1UL << id);
+}
+
+uint32_t alarmsActiveMask() {
+  return activeMask;
+}
+
+const __FlashStringHelper* alarmName(AlarmId id) {
+  if (id >= ALARM_COUNT) return F("?");
+  return FPSTR((PGM_P)pgm_read_ptr(&RULES[id].name));
+}
@@ -0,0 +1,76 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Alarms.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Alarms.cpp.
+   Threshold alarm engine. Each alarm is one row of ALARM_TABLE: the
+   signal it watches, a level or rate-of-change threshold, hysteresis
+   and a hold time. alarmsCompile() turns the rows into flat trip/clear
+   levels (settings such as min/max voltage are read once, not per
+   sample), and alarmsEvaluate() runs every rule on every sensor sample
+   at a fixed cost of one compare pair per rule.
+
+   Exposed Functions:
+   - alarmsBegin(handler)   → compile the table, set the raise/clear callback
+   - alarmsCompile()        → re-read thresholds (called when a setting changes)
+   - alarmsEvaluate()       → one sample (called from sampleSensors())
+   - alarmActive(), alarmsActiveMask(), alarmName()
+
+   Notes:
+   - A rule raises once its condition has held for holdMs and clears as
+     soon as the value is back past threshold ∓ hysteresis
+   - Rates are in units per second, smoothed over a few samples
+   - NaN inputs (sensor missing) leave that signal's alarms as they are
+   - The handler runs inside the sampler: it must only set flags or queue work
+*/
+
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <Arduino.h>
+
+extern float minVoltageThreshold;
+extern float maxVoltageThreshold;
+
+enum AlarmSignal : uint8_t { ALARM_SIG_VOLTAGE, ALARM_SIG_CURRENT, ALARM_SIG_SOC, ALARM_SIG_COUNT };
+
+enum AlarmKind : uint8_t {
+  ALARM_ABOVE,       // value >= threshold
+  ALARM_BELOW,       // value <= threshold
+  ALARM_RISE_RATE,   // d(value)/dt >= threshold
+  ALARM_FALL_RATE    // d(value)/dt <= -threshold
+};
+
+const float ALARM_SOC_LOW_PCT = 40.0;
+const float ALARM_SOC_FULL_PCT = 100.0;
+const float ALARM_SAG_V_PER_S = 1.0;
+
+// ===== Rules =====
+// X(id, name, signal, kind, threshold, hysteresis, holdMs)
+#define ALARM_TABLE(X) \
+  X(ALARM_VOLTAGE_LOW,  "Volt Low",  ALARM_SIG_VOLTAGE, ALARM_BELOW,     minVoltageThreshold, 0.2, 2000) \
+  X(ALARM_VOLTAGE_HIGH, "Volt High", ALARM_SIG_VOLTAGE, ALARM_ABOVE,     maxVoltageThreshold, 0.2, 2000) \
+  X(ALARM_VOLTAGE_SAG,  "Volt Sag",  ALARM_SIG_VOLTAGE, ALARM_FALL_RATE, ALARM_SAG_V_PER_S,   0.5, 300)  \
+  X(ALARM_SOC_LOW,      "SOC Low",   ALARM_SIG_SOC,     ALARM_BELOW,     ALARM_SOC_LOW_PCT,   5.0, 0)    \
+  X(ALARM_SOC_FULL,     "SOC Full",  ALARM_SIG_SOC,     ALARM_ABOVE,     ALARM_SOC_FULL_PCT,  5.0, 0)
+
+#define ALARM_ENUM_ENTRY(id, ...) id,
+enum AlarmId : uint8_t {
+  ALARM_TABLE(ALARM_ENUM_ENTRY)
+  ALARM_COUNT
+};
+#undef ALARM_ENUM_ENTRY
+
+typedef void (*AlarmHandler)(AlarmId id, bool active);
+
+void alarmsBegin(AlarmHandler handler);
+void alarmsCompile();
+void alarmsEvaluate(unsigned long now, float voltage, float current, float soc);
+bool alarmActive(AlarmId id);
+uint32_t alarmsActiveMask();   // bit n = AlarmId n
+const __FlashStringHelper* alarmName(AlarmId id);
+
+#endif // ALARMS_H
@@ -9,49 +9,81 @@
    Provides REST API endpoints and AP-mode setup pages.
 
    Features:
-   - /live_data   → Returns real-time telemetry (voltage, current, SOC, power, RSSI, mode, IP)
+   - /live_data   → Returns real-time telemetry (voltage, current, SOC, power, RSSI, mode, IP, alarms)
    - /serial_log  → Returns recent logs (uptime + RTC timestamp)
-   - /settings    → GET for reading, POST for updating (values persisted in EEPROM)
+   - /settings    → GET for reading, POST for updating (values persisted in EEPROM;
+                    the POST body is parsed as it streams in, see SettingsParser)
    - /wifi_config → HTML form + JSON API for provisioning WiFi credentials
    - /ap_qr, /ap_details → AP setup pages (QR code, network details)
    - /sta_ip      → Returns station IP or NOT_CONNECTED
    - /reboot      → Reboots ESP
+   - /i2c_stats   → Per-device I2C bus transactions / utilization
+   - /net_status  → WiFi state machine + connectivity probe stats
+   - /time_status → Time source, NTP offset/slew, DS3231 drift
+   - /sched       → Scheduler tasks: runs, deadline misses, budget overruns
+   - /perf        → Latency profiler: count/avg/p50/p99/max per subsystem (?reset=1 clears)
+   - /heap        → Free heap, largest block, fragmentation + watermarks (per-site allocs with HEAP_DEBUG)
+   - /stalls      → Last loop stalls (> 1 s) with the marker that was running, kept in RTC memory
+   - /capture     → POST arms an 860 SPS burst capture, GET downloads it (binary, see Capture.h);
+                    ?slot=N downloads triggered capture N instead
+   - /trigger     → POST arms / disarms the single-shot triggered capture (see Trigger.h)
+   - /captures    → Trigger state + list of triggered capture slots
+   - /bench       → Microbenchmarks, Google Benchmark JSON (ENABLE_BENCH builds only)
+   - /sim         → Battery simulator report: SOC error, EEPROM wear, loop timing (BATTERY_SIM only)
    - AP/STA route setup functions
 
    Notes:
-   - Uses DS3231 RTC for timestamps
-   - Logs all actions with uptime + RTC to circular buffer
+   - Timestamps come from TimeSync (DS3231 + NTP-disciplined software clock)
+   - Logs all actions with uptime + RTC to a fixed circular buffer (no heap use)
    - WiFi credentials persisted in AT24C32 EEPROM
 */
 
 #include "AppServer.h"
 #include "EEPROMUtils.h"
+#include "I2CBus.h"
+#include "NetworkManager.h"
+#include "TimeSync.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "HeapMonitor.h"
+#include "Bench.h"
+#include "BatterySim.h"
+#include "StallWatch.h"
+#include "MemoryConfig.h"
+#include "StringTable.h"
+#include "Settings.h"
+#include "JsonWriter.h"
+#include "Alarms.h"
+#include "Capture.h"
+#include "Trigger.h"
+#include "Extremes.h"
+#include "Histogram.h"
+#include "Forecast.h"
 #include <ArduinoJson.h>
 #include <ESP8266WiFi.h>
 #include <ESP8266WebServer.h>
 #include <time.h>
+#include <stdarg.h>
 #include <RTClib.h>
-extern RTC_DS3231 rtc;
 
-#define MAX_LOG_LINES 50
-String serialLogBuffer[MAX_LOG_LINES];
+const uint16_t MAX_LOG_LINES = MEM.logLines;   // sized by the memory profile
+const uint16_t LOG_LINE_LEN = MEM.logLineLen;   // longer lines are truncated
+static char serialLogBuffer[MAX_LOG_LINES][LOG_LINE_LEN];  // fixed ring: logging never touches the heap
 int logIndex = 0;
 
-extern bool rtc_present;
-void addSerialLog(const String& message) {
-  String timePart;
-  if (rtc_present) {
-    DateTime now = rtc.now(); // Already in IST from NTP sync
-    char buf[30];
+void addSerialLog(const char* message) {
+  HEAP_TRACE("addSerialLog");
+  char timePart[26];
+  DateTime now;
+  if (timeSyncNow(&now)) { // IST, monotonic (see TimeSync.cpp)
     int hour12 = now.hour() % 12;
     if (hour12 == 0) hour12 = 12;
     const char* ampm = (now.hour() >= 12) ? "PM" : "AM";
-    sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d %s",
-            now.year(), now.month(), now.day(),
-            hour12, now.minute(), now.second(), ampm);
-    timePart = String(buf);
+    snprintf_P(timePart, sizeof(timePart), PSTR("%04d-%02d-%02d %02d:%02d:%02d %s"),
+             now.year(), now.month(), now.day(),
+             hour12, now.minute(), now.second(), ampm);
   } else {
-    timePart = "RTC-N/A";
+    strcpy_P(timePart, PSTR("RTC-N/A"));
   }
 
   unsigned long seconds = millis() / 1000;
@@ -62,65 +94,32 @@ void addSerialLog(const String& message) {
   int minutes = seconds / 60;
   seconds %= 60;
 
-  char uptimeBuf[20];
-  sprintf(uptimeBuf, "%02dd:%02dh:%02dm:%02ds", days, hours, minutes, seconds);
-
-  String logLine = "[" + String(uptimeBuf) + "] [" + timePart + "] " + message;
-  serialLogBuffer[logIndex] = logLine;
+  char* logLine = serialLogBuffer[logIndex];
+  snprintf_P(logLine, LOG_LINE_LEN, PSTR("[%02dd:%02dh:%02dm:%02lus] [%s] %s"),
+           days, hours, minutes, seconds, timePart, message);
   logIndex = (logIndex + 1) % MAX_LOG_LINES;
   Serial.println(logLine);
 }
 
-void syncTimeFromNTPtoRTC() {
-  if (WiFi.status() != WL_CONNECTED) {
-    addSerialLog("❌ WiFi not connected. Cannot sync time.");
-    return;
-  }
-
-  configTime("IST-5:30",
-    "0.in.pool.ntp.org",
-    "1.in.pool.ntp.org",
-    "pool.ntp.org"
-  );
-
-  Serial.print("Waiting for NTP time sync");
-
-  time_t now = time(nullptr);
-  unsigned long startMs = millis();
-
-  while (now < 946684800 && millis() - startMs < 10000) {
-    delay(500);
-    Serial.print(".");
-    now = time(nullptr);
-  }
-  Serial.println();
-
-  if (now >= 946684800) {
-    struct tm timeinfo;
-    if (!localtime_r(&now, &timeinfo)) {
-      addSerialLog("❌ Failed to convert time.");
-      return;
-    }
-
-    DateTime ntpTime(
-      timeinfo.tm_year + 1900,
-      timeinfo.tm_mon + 1,
-      timeinfo.tm_mday,
-      timeinfo.tm_hour,
-      timeinfo.tm_min,
-      timeinfo.tm_sec
-    );
-
-    rtc.adjust(ntpTime);
+void addSerialLog(const String& message) {
+  addSerialLog(message.c_str());
+}
 
-    char formatted[40];
-    strftime(formatted, sizeof(formatted), "%Y-%m-%d %I:%M:%S %p", &timeinfo);
-    addSerialLog("✅ RTC updated via NTP (IST): " + String(formatted));
-  } else {
-    addSerialLog("❌ NTP sync failed. RTC not updated.");
-  }
+void addSerialLog(const __FlashStringHelper* message) {
+  char buf[LOG_LINE_LEN];
+  strncpy_P(buf, (PGM_P)message, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+  addSerialLog(buf);
 }
 
+void addSerialLogf_P(PGM_P fmt, ...) {
+  char message[LOG_LINE_LEN];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf_P(message, sizeof(message), fmt, args);
+  va_end(args);
+  addSerialLog(message);
+}
 
 // Server
 ESP8266WebServer server(80);
@@ -130,27 +129,12 @@ extern float currentVoltage;
 extern float filteredCurrent;
 extern float currentPower;
 extern float soc;
-extern float batteryCapacityAh;
-extern float voltageOffset;
-extern float currentOffset;
-extern float mVperAmp;
 extern float chargingCurrentThreshold;
 extern float dischargingCurrentThreshold;
-extern float totalCoulombs;
-extern unsigned long lastActiveStateChange;
-extern float currentDeadzoneThreshold;
 
 
 const uint16_t ADDR_WIFI_SSID = 500;
 const uint16_t ADDR_WIFI_PASS = 564;
-const uint16_t ADDR_BATTERY_CAPACITY = 20;
-const uint16_t ADDR_VOLTAGE_OFFSET = 30;
-const uint16_t ADDR_CURRENT_OFFSET = 40;
-const uint16_t ADDR_MV_PER_AMP = 50;
-const uint16_t ADDR_CHARGING_THRESHOLD = 200;
-const uint16_t ADDR_DISCHARGING_THRESHOLD = 210;
-const uint16_t ADDR_SOC = 140; // Same as in menubased.ino
-const uint16_t ADDR_CURRENT_DEADZONE = 220; // float → uses 4 bytes: 220–223
 
 
 char savedSsid[32] = "";
@@ -165,38 +149,539 @@ void handleNotFound();
 
 void handleSettingsGet();
 void handleSettingsPost();
+void handleSettingsPostBody();
+void handleCapturesGet();
+void handleHistogram();
+void handleSerialLog();
 // ---------------------------------------------------------------------------
 
 // ========================= Routes ============================
 
+// X(key, value, decimals): /live_data members, in order
+#define LIVE_DATA_FIELDS(X) \
+  X("voltage",  currentVoltage,       3) \
+  X("current",  filteredCurrent,      3) \
+  X("soc",      soc,                  2) \
+  X("power",    currentPower,         2) \
+  X("runtime",  forecastFormatRuntime(runtime, sizeof(runtime), "N/A"), 0) \
+  X("runtime_min", forecastRuntimeMinutes(), 0) \
+  X("status",   batteryStatusText(),  0) \
+  X("rssi",     WiFi.RSSI(),          0) \
+  X("internet", networkIsOnline(),    0) \
+  X("mode",     mode,                 0) \
+  X("ip",       ip,                   0) \
+  X("alarms",   alarmsActiveMask(),   0) \
+  X("v_min",    ext.voltage.lo,       3) \
+  X("v_max",    ext.voltage.hi,       3) \
+  X("v_pp",     extremesPeakToPeak(ext.voltage), 3) \
+  X("i_min",    ext.current.lo,       3) \
+  X("i_max",    ext.current.hi,       3) \
+  X("i_pp",     extremesPeakToPeak(ext.current), 3) \
+  X("p_min",    ext.power.lo,         2) \
+  X("p_max",    ext.power.hi,         2) \
+  X("p_pp",     extremesPeakToPeak(ext.power),   2)
+
+size_t writeLiveDataJson(char* buf, size_t size, const char* mode, const char* ip,
+                         const Extremes& ext) {
+  char runtime[12];
+  JsonWriter json(buf, size);
+  JSON_WRITE(LIVE_DATA_FIELDS);
+  json.finish();
+  return json.overflowed() ? 0 : json.length();
+}
+
+static const char* liveDataMode() {
+  switch (WiFi.getMode()) {
+    case WIFI_AP:     return "AP";
+    case WIFI_STA:    return "STA";
+    case WIFI_AP_STA: return WiFi.status() == WL_CONNECTED ? "STA" : "AP";
+    default:          return "NONE";
+  }
+}
+
+// IPAddress::toString() would allocate a String per request
+static void formatIp(const IPAddress& addr, char* out, size_t size) {
+  snprintf_P(out, size, PSTR("%u.%u.%u.%u"), addr[0], addr[1], addr[2], addr[3]);
+}
+
+static void sendJson(const char* body, size_t len) {
+  if (!len) { // buffer too small for the fixed shape: a bug, not a client error
+    server.send_P(500, MIME_TEXT_PLAIN, PSTR("Response too large"));
+    return;
+  }
+  server.send(200, "application/json", body, len);
+}
+
 void handleLiveData() {
+  char ip[16];
+  formatIp(WiFi.getMode() == WIFI_AP ? WiFi.softAPIP() : WiFi.localIP(), ip, sizeof(ip));
+  char out[384];
+  sendJson(out, writeLiveDataJson(out, sizeof(out), liveDataMode(), ip,
+                                  extremesTake(EXTREMES_LIVE_DATA)));
+}
+
+void handleI2CStats() {
+  StaticJsonDocument<768> doc;
+  for (int d = 0; d < I2C_DEV_COUNT; d++) {
+    const I2CDeviceStats& st = i2cDeviceStats((I2CDevice)d);
+    JsonVariant dev = doc[i2cDeviceName((I2CDevice)d)];
+    dev["transactions"] = st.transactions;
+    dev["busy_ms"] = st.busyUs / 1000;
+    dev["max_us"] = st.maxUs;
+    dev["utilization_pct"] = st.utilizationPct;
+    dev["errors"] = st.errors;
+    dev["last_error"] = st.lastError;
+    dev["available"] = i2cDeviceAvailable((I2CDevice)d);
+  }
+  doc["eeprom_pending"] = i2cEepromWritePending();
+  doc["bus_clears"] = i2cBusClearCount();
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handleNetStatus() {
+  StaticJsonDocument<384> doc;
+  const NetProbeStats& st = networkProbeStats();
+  doc["state"] = networkStateName(networkState());
+  doc["internet"] = networkIsOnline();
+  doc["probes"] = st.probes;
+  doc["probe_failures"] = st.failures;
+  doc["last_probe_ms"] = st.lastProbeMs;
+  doc["next_probe_in_ms"] = st.nextProbeInMs;
+
+  const NetConnectStats& cs = networkConnectStats();
+  doc["join_ms"] = cs.lastJoinMs;
+  doc["join_path"] = networkFastPathName(cs.path);
+  doc["join_fell_back"] = cs.fellBack;
+  doc["static_ip"] = networkStaticIpEnabled();
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handleTimeStatus() {
+  StaticJsonDocument<384> doc;
+  const TimeSyncStatus& st = timeSyncStatus();
+  DateTime now;
+  if (timeSyncNow(&now)) {
+    char buf[24];
+    sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d",
+            now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
+    doc["time"] = buf;
+  } else {
+    doc["time"] = nullptr;
+  }
+  doc["source"] = timeSourceName(st.source);
+  doc["ntp_samples"] = st.ntpSamples;
+  if (st.ntpSamples) doc["last_ntp_age_s"] = st.lastNtpAgeS;
+  doc["last_offset_ms"] = st.lastOffsetMs;
+  doc["slew_remaining_ms"] = st.slewRemainingMs;
+  doc["steps"] = st.steps;
+  doc["holds"] = st.holds;
+  doc["holding"] = st.holding;
+  doc["rtc_error_s"] = st.rtcErrorS;
+  doc["rtc_adjusts"] = st.rtcAdjusts;
+  if (st.rtcDriftValid) doc["rtc_drift_ppm"] = st.rtcDriftPpm;
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handleSchedStats() {
+  DynamicJsonDocument doc(MEM.statsJsonBytes); // too big for the stack
+  doc["passes"] = schedulerPasses();
+  JsonArray arr = doc.createNestedArray("tasks");
+  for (uint8_t i = 0; i < schedulerTaskCount(); i++) {
+    const SchedTask& t = schedulerTask(i);
+    JsonObject o = arr.createNestedObject();
+    o["name"] = t.name;
+    o["priority"] = schedulerPriorityName(t.priority);
+    o["period_ms"] = t.periodMs;
+    o["deadline_ms"] = t.deadlineMs;
+    o["budget_us"] = t.budgetUs;
+    o["runs"] = t.stats.runs;
+    o["deadline_misses"] = t.stats.deadlineMisses;
+    o["over_budget"] = t.stats.overBudget;
+    o["deferrals"] = t.stats.deferrals;
+    o["max_late_ms"] = t.stats.maxLateMs;
+    o["max_run_us"] = t.stats.maxRunUs;
+    o["last_run_us"] = t.stats.lastRunUs;
+  }
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handlePerfStats() {
+  if (server.arg("reset") == "1") {
+    perfReset();
+    addSerialLog(F("⏱️ Profiler counters reset"));
+  }
+
+  DynamicJsonDocument doc(MEM.statsJsonBytes);
+  doc["cpu_mhz"] = ESP.getCpuFreqMHz();
+  JsonArray arr = doc.createNestedArray("probes");
+  for (uint8_t i = 0; i < PERF_PROBE_COUNT; i++) {
+    PerfProbe p = (PerfProbe)i;
+    const PerfStats& st = perfStats(p);
+    JsonObject o = arr.createNestedObject();
+    o["name"] = perfProbeName(p);
+    o["count"] = st.count;
+    o["avg_us"] = st.count ? (uint32_t)(st.totalUs / st.count) : 0;
+    o["p50_us"] = perfPercentileUs(p, 50);
+    o["p99_us"] = perfPercentileUs(p, 99);
+    o["max_us"] = st.maxUs;
+  }
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handleHeapStats() {
+  if (server.arg("reset") == "1") {
+    heapMonitorReset();
+    addSerialLog(F("🧹 Heap watermarks reset"));
+  }
+  heapMonitorSample();
+  const HeapStats& h = heapStats();
+
+  DynamicJsonDocument doc(MEM.statsJsonBytes);
+  doc["free"] = h.freeBytes;
+  doc["max_block"] = h.maxBlock;
+  doc["frag_pct"] = h.fragPct;
+  doc["min_free"] = h.minFreeBytes;
+  doc["min_max_block"] = h.minMaxBlock;
+  doc["max_frag_pct"] = h.maxFragPct;
+  doc["since_s"] = (millis() - h.sinceMs) / 1000;
+  doc["debug"] = (bool)HEAP_DEBUG;
+  doc["profile"] = MEM.name;
+  doc["headroom_target"] = MEM.heapHeadroom;
+  doc["headroom_ok"] = h.minFreeBytes >= MEM.heapHeadroom;
+
+#if HEAP_DEBUG
+  uint32_t elapsedMin = (millis() - h.sinceMs) / 60000;
+  if (elapsedMin == 0) elapsedMin = 1;
+  doc["allocs_total"] = heapAllocCount();
+  JsonArray arr = doc.createNestedArray("sites");
+  for (const HeapSite* site = heapSiteFirst(); site; site = site->next) {
+    JsonObject o = arr.createNestedObject();
+    o["name"] = site->name;
+    o["calls"] = site->calls;
+    o["allocs"] = site->allocs;
+    o["allocs_per_min"] = site->allocs / elapsedMin;
+  }
+#endif
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+#if ENABLE_BENCH
+// ===================== Benchmarks =====================
+// Serialization into a stack buffer so only the JSON work is measured.
+// The *_arduinojson variants build the same bodies the way the handlers
+// used to (document + serializeJson) as the baseline for JsonWriter.
+static void benchLiveDataJson() {
+  char out[384];
+  writeLiveDataJson(out, sizeof(out), "STA", "192.168.1.50", extremesPeek(EXTREMES_LIVE_DATA));
+}
+
+static void benchLiveDataArduinoJson() {
   StaticJsonDocument<256> doc;
+  char out[256];
   doc["voltage"] = currentVoltage;
   doc["current"] = filteredCurrent;
   doc["soc"] = soc;
   doc["power"] = currentPower;
   doc["runtime"] = "N/A";
-  doc["status"] = (filteredCurrent > chargingCurrentThreshold) ? "Charging" :
-                  ((filteredCurrent < -dischargingCurrentThreshold) ? "Discharging" : "Idle");
+  doc["status"] = batteryStatusText();
   doc["rssi"] = WiFi.RSSI();
+  doc["internet"] = networkIsOnline();
+  doc["mode"] = "STA";
+  doc["ip"] = "192.168.1.50";
+  serializeJson(doc, out, sizeof(out));
+}
 
-  // ✅ Add mode field
-  if (WiFi.getMode() == WIFI_AP) {
-    doc["mode"] = "AP";
-  } else if (WiFi.getMode() == WIFI_STA) {
-    doc["mode"] = "STA";
-  } else if (WiFi.getMode() == WIFI_AP_STA) {
-    if (WiFi.status() == WL_CONNECTED) doc["mode"] = "STA";
-    else doc["mode"] = "AP";
-  } else {
-    doc["mode"] = "NONE";
+static void benchSettingsJson() {
+  char out[384];
+  writeSettingsJson(out, sizeof(out));
+}
+
+static void benchSettingsArduinoJson() {
+  StaticJsonDocument<512> doc;
+  char out[512];
+  settingsToJson(doc);
+  serializeJson(doc, out, sizeof(out));
+}
+
+static volatile bool benchParseValid;   // keeps finish() from being optimized away
+
+// Parse + validation of handleSettingsPost() (applying would write EEPROM every call)
+static void benchSettingsParse() {
+  static const char body[] =
+    "{\"capacity_ah\":100,\"voltage_offset\":0.05,\"current_offset\":0,"
+    "\"mv_per_amp\":1.25,\"charge_threshold\":0.2,\"discharge_threshold\":0.2,"
+    "\"soc\":80.5,\"current_deadzone\":0.15}";
+  SettingsParser parser;
+  parser.begin(sizeof(body) - 1);
+  parser.feed(body, sizeof(body) - 1);
+  benchParseValid = parser.finish();
+}
+
+void registerServerBenchmarks() {
+  benchRegister("live_data_json", benchLiveDataJson);
+  benchRegister("live_data_arduinojson", benchLiveDataArduinoJson);
+  benchRegister("settings_json", benchSettingsJson);
+  benchRegister("settings_arduinojson", benchSettingsArduinoJson);
+  benchRegister("settings_post_parse", benchSettingsParse);
+}
+
+// Google Benchmark JSON layout; ?filter=<substring> runs a subset
+void handleBench() {
+  STALL_MARK("bench");
+  String filter = server.arg("filter");
+  addSerialLog(F("⏱️ Running benchmarks (loop blocked)"));
+
+  DynamicJsonDocument doc(2048);
+  JsonObject ctx = doc.createNestedObject("context");
+  ctx["cpu_mhz"] = ESP.getCpuFreqMHz();
+  ctx["heap_debug"] = (bool)HEAP_DEBUG;
+  JsonArray arr = doc.createNestedArray("benchmarks");
+  for (uint8_t i = 0; i < benchCount(); i++) {
+    if (filter.length() && !strstr(benchName(i), filter.c_str())) continue;
+    BenchResult r;
+    if (!benchRun(i, &r)) continue;
+    JsonObject o = arr.createNestedObject();
+    o["name"] = r.name;
+    o["iterations"] = r.iterations;
+    o["real_time"] = r.nsPerOp;
+    o["cpu_time"] = r.nsPerOp;
+    o["time_unit"] = "ns";
+    if (HEAP_DEBUG) o["allocs_per_op"] = r.allocsPerOp;
+    o["heap_delta"] = r.heapDelta;
   }
 
-  // ✅ Add IP address
-  if (WiFi.getMode() == WIFI_AP) {
-    doc["ip"] = WiFi.softAPIP().toString();
-  } else {
-    doc["ip"] = WiFi.localIP().toString();
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+#endif
+
+#if BATTERY_SIM
+void handleSimReport() {
+  const SimReport& r = simReport();
+  StaticJsonDocument<640> doc;
+  doc["virtual_s"] = r.virtualSeconds;
+  doc["virtual_days"] = r.virtualSeconds / 86400.0;
+  doc["speedup"] = r.speedup;
+  doc["true_soc"] = r.trueSoc;
+  doc["est_soc"] = soc;
+  doc["soc_err"] = r.socError;
+  doc["soc_err_max"] = r.socErrorMaxAbs;
+  doc["soc_err_rms"] = r.socErrorRms;
+  doc["idle_recals"] = r.idleRecals;
+  doc["daily_resets"] = r.dailyResets;
+  doc["eeprom_writes"] = r.eepromWrites;
+  doc["eeprom_hot_page"] = r.eepromHotPage;
+  doc["eeprom_hot_page_writes"] = r.eepromHotPageWrites;
+  doc["eeprom_life_years"] = r.eepromLifeYears;
+  doc["loop_p99_us"] = perfPercentileUs(PERF_LOOP, 99);
+  doc["loop_max_us"] = perfStats(PERF_LOOP).maxUs;
+  doc["sample_p99_us"] = perfPercentileUs(PERF_SAMPLING, 99);
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+#endif
+
+// X(key, value, decimals): burst capture status
+#define CAPTURE_STATUS_FIELDS(X) \
+  X("state",         captureStateName(captureState()), 0) \
+  X("window_ms",     (unsigned int)h.windowMs,          0) \
+  X("count",         (unsigned int)h.count,             0) \
+  X("duration_us",   (unsigned long)h.durationUs,       0) \
+  X("capacity",      (unsigned int)captureCapacity(),   0) \
+  X("sample_rate",   CAPTURE_SAMPLE_RATE_HZ,            0)
+
+static void sendCaptureStatus(int code) {
+  const CaptureHeader& h = captureHeader();
+  char out[160];
+  JsonWriter json(out, sizeof(out));
+  JSON_WRITE(CAPTURE_STATUS_FIELDS);
+  json.finish();
+  server.send(code, "application/json", out, json.length());
+}
+
+// POST /capture?window_ms=500&voltage_every=1 → runs on the next sampler pass
+void handleCapturePost() {
+  uint16_t maxWindowMs = captureMaxWindowMs();   // buffer of this memory profile
+  long windowMs = server.hasArg("window_ms") ? server.arg("window_ms").toInt() : min<long>(500, maxWindowMs);
+  long voltageEvery = server.hasArg("voltage_every") ? server.arg("voltage_every").toInt() : 1;
+  CaptureState st = captureState();
+  if (st == CAPTURE_REQUESTED || st == CAPTURE_RUNNING) {
+    server.send_P(409, MIME_TEXT_PLAIN, PSTR("Capture in progress"));
+    return;
+  }
+  if (windowMs < 1 || windowMs > maxWindowMs || voltageEvery < 1 || voltageEvery > 255 ||
+      !captureRequest((uint16_t)windowMs, (uint8_t)voltageEvery)) {
+    char msg[64];
+    snprintf_P(msg, sizeof(msg), PSTR("window_ms must be 1..%u, voltage_every 1..255"), maxWindowMs);
+    server.send(400, MIME_TEXT_PLAIN, msg);
+    return;
+  }
+  addSerialLogf_P(PSTR("📈 Burst capture armed: %ld ms"), windowMs);
+  sendCaptureStatus(202);
+}
+
+// Header + records as one response, no copy
+static void sendCaptureBlob(const CaptureHeader& h, const void* samples) {
+  size_t samplesLen = (size_t)h.count * h.sampleBytes;
+  server.setContentLength(sizeof(h) + samplesLen);
+  server.sendHeader("Content-Disposition", "attachment; filename=\"capture.bin\"");
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char*)&h, sizeof(h));
+  server.sendContent((const char*)samples, samplesLen);
+}
+
+// GET /capture → burst blob; ?slot=N → triggered slot N (0 = newest); ?info=1 → status JSON
+void handleCaptureGet() {
+  if (server.hasArg("slot")) {
+    long slot = server.arg("slot").toInt();
+    const CaptureHeader* h = (slot >= 0 && slot < 256) ? triggerSlotHeader((uint8_t)slot) : nullptr;
+    if (!h) {
+      server.send_P(404, MIME_TEXT_PLAIN, PSTR("No such capture slot"));
+      return;
+    }
+    sendCaptureBlob(*h, triggerSlotSamples((uint8_t)slot));
+    return;
+  }
+  if (server.arg("info") == "1") {
+    sendCaptureStatus(200);
+    return;
+  }
+  CaptureState st = captureState();
+  if (st == CAPTURE_REQUESTED || st == CAPTURE_RUNNING) {
+    server.send_P(409, MIME_TEXT_PLAIN, PSTR("Capture in progress"));
+    return;
+  }
+  if (st != CAPTURE_DONE) {
+    server.send_P(404, MIME_TEXT_PLAIN, PSTR("No capture"));
+    return;
+  }
+  sendCaptureBlob(captureHeader(), captureSamples());
+}
+
+// POST /trigger?type=step|sag|didt&level=<A, V or A/s>&pre=32, or ?type=off
+void handleTriggerPost() {
+  String typeArg = server.arg("type");
+  if (typeArg == "off") {
+    triggerDisarm();
+    addSerialLog(F("🎯 Trigger disarmed"));
+    handleCapturesGet();
+    return;
+  }
+
+  TriggerType type = triggerTypeFromName(typeArg.c_str());
+  long pre = server.hasArg("pre") ? server.arg("pre").toInt() : TRIGGER_SLOT_SAMPLES / 4;
+  if (type == TRIGGER_TYPE_COUNT || !server.hasArg("level") || pre < 0 || pre >= TRIGGER_SLOT_SAMPLES) {
+    server.send_P(400, MIME_TEXT_PLAIN, PSTR("type must be step, sag, didt or off; level required; pre 0..127"));
+    return;
+  }
+  float level = server.arg("level").toFloat();
+  if (type != TRIGGER_VOLTAGE_SAG && level <= 0) {
+    server.send_P(400, MIME_TEXT_PLAIN, PSTR("level must be > 0"));
+    return;
+  }
+  if (!triggerArm(type, level, (uint8_t)pre)) {
+    server.send_P(409, MIME_TEXT_PLAIN, PSTR("Previous capture still filling"));
+    return;
+  }
+  addSerialLogf_P(PSTR("🎯 Trigger armed: %s %.3f, %ld pre-trigger samples"), typeArg.c_str(), level, pre);
+  handleCapturesGet();
+}
+
+// Trigger state + slot list, newest first
+void handleCapturesGet() {
+  StaticJsonDocument<1024> doc;
+  doc["armed"] = triggerArmed();
+  doc["filling"] = triggerActive() && !triggerArmed();
+  doc["type"] = triggerTypeName(triggerType());
+  doc["level"] = triggerLevel();
+  doc["pre"] = triggerPreSamples();
+  doc["slot_samples"] = TRIGGER_SLOT_SAMPLES;
+  JsonArray arr = doc.createNestedArray("slots");
+  for (uint8_t i = 0; i < triggerSlotCount(); i++) {
+    const CaptureHeader* h = triggerSlotHeader(i);
+    JsonObject o = arr.createNestedObject();
+    o["slot"] = i;
+    o["seq"] = triggerSlotSeq(i);
+    o["trigger"] = triggerTypeName(h->trigger);
+    o["time"] = h->startUnix;
+    o["count"] = h->count;
+    o["pre"] = h->preSamples;
+    o["duration_us"] = h->durationUs;
+  }
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handleHistogram() {
+  if (server.arg("reset") == "1") {
+    histogramReset(timeSyncUnixtime());
+    addSerialLog(F("🧹 Load histogram reset"));
+  }
+
+  const HistogramCounts& c = histogramCounts();
+  DynamicJsonDocument doc(MEM.statsJsonBytes);
+  doc["unit"] = "s";
+  doc["since"] = histogramSinceUnix();
+  doc["saved"] = histogramSavedUnix();
+  doc["min_a"] = HISTOGRAM_MIN_CURRENT_A;
+  doc["bins_per_octave"] = HISTOGRAM_BINS_PER_OCTAVE;
+  doc["idle"] = c.idle;
+  JsonArray discharge = doc.createNestedArray("discharge");
+  JsonArray charge = doc.createNestedArray("charge");
+  for (uint8_t i = 0; i < HISTOGRAM_CURRENT_BINS; i++) {
+    discharge.add(c.discharge[i]);
+    charge.add(c.charge[i]);
+  }
+  doc["soc_step"] = 100 / HISTOGRAM_SOC_BINS;
+  JsonArray socBins = doc.createNestedArray("soc");
+  for (uint8_t i = 0; i < HISTOGRAM_SOC_BINS; i++) socBins.add(c.soc[i]);
+
+  String jsonStr;
+  serializeJson(doc, jsonStr);
+  server.send(200, "application/json", jsonStr);
+}
+
+void handleStalls() {
+  if (server.arg("clear") == "1") {
+    stallClear();
+    addSerialLog(F("🧹 Stall records cleared"));
+  }
+
+  DynamicJsonDocument doc(MEM.statsJsonBytes);
+  doc["threshold_ms"] = STALL_THRESHOLD_MS;
+  JsonArray arr = doc.createNestedArray("stalls");
+  for (uint8_t i = 0; i < stallRecordCount(); i++) {
+    const StallRecord& r = stallRecord(i);
+    JsonObject o = arr.createNestedObject();
+    o["where"] = r.name;
+    o["duration_ms"] = r.durationMs;
+    o["uptime_s"] = r.uptimeS;
+    if (r.unixTime) o["time"] = r.unixTime;
+    o["previous_boot"] = (bool)(r.flags & STALL_FROM_PREVIOUS_BOOT);
+    o["ended_in_reset"] = (bool)(r.flags & STALL_ENDED_IN_RESET);
   }
 
   String jsonStr;
@@ -211,58 +696,70 @@ void handleServerClient() {
 // AP Mode server routes
 void setupServerRoutes_AP(const String& apIP, const String& apSsid, const String& apPass);
 
-void handleAPMenu(const String& apIP, const String& apSsid, const String& apPass) {
-  String html;
-  html += "<!DOCTYPE html><html><head><title>AP Mode Menu</title>";
-  html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-  html += "<style>";
-  html += "body{font-family: Arial; text-align:center; background-color:#f4f4f4;}";
-  html += "h2{color:#333;}";
-  html += "button{padding:10px 20px; margin:10px; font-size:16px;}";
-  html += ".card{background:white; padding:15px; margin:15px; border-radius:10px; box-shadow:0 2px 5px rgba(0,0,0,0.2);}";
-  html += "</style></head><body>";
-
-  html += "<h2>📶 AP Mode - Setup</h2>";
-  html += "<div class='card'>";
-  html += "<p><b>SSID:</b> " + apSsid + "</p>";
-  html += "<p><b>Password:</b> " + apPass + "</p>";
-  html += "<p><b>IP:</b> " + apIP + "</p>";
-  html += "</div>";
+// Static page parts live in flash; only the small dynamic fields go through
+// a stack buffer, and the response is streamed so no page-sized String is built.
+static void beginHtmlResponse() {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/html", "");
+}
 
-  html += "<p>Select an option below:</p>";
-  html += "<a href='/ap_details'><button>1 AP Details</button></a><br>";
-  html += "<a href='/ap_qr'><button>2 QR Code</button></a>";
+static void sendApFields(const char* ipLabel, const String& apIP, const String& apSsid, const String& apPass) {
+  char buf[192];
+  snprintf(buf, sizeof(buf),
+           "<p><b>SSID:</b> %s</p><p><b>Password:</b> %s</p><p><b>%s:</b> %s</p>",
+           apSsid.c_str(), apPass.c_str(), ipLabel, apIP.c_str());
+  server.sendContent(buf);
+}
 
-  html += "</body></html>";
-  server.send(200, "text/html", html);
+void handleAPMenu(const String& apIP, const String& apSsid, const String& apPass) {
+  beginHtmlResponse();
+  server.sendContent_P(PSTR(
+    "<!DOCTYPE html><html><head><title>AP Mode Menu</title>"
+    "<meta name='viewport' content='width=device-width, initial-scale=1'>"
+    "<style>"
+    "body{font-family: Arial; text-align:center; background-color:#f4f4f4;}"
+    "h2{color:#333;}"
+    "button{padding:10px 20px; margin:10px; font-size:16px;}"
+    ".card{background:white; padding:15px; margin:15px; border-radius:10px; box-shadow:0 2px 5px rgba(0,0,0,0.2);}"
+    "</style></head><body>"
+    "<h2>📶 AP Mode - Setup</h2>"
+    "<div class='card'>"));
+  sendApFields("IP", apIP, apSsid, apPass);
+  server.sendContent_P(PSTR(
+    "</div>"
+    "<p>Select an option below:</p>"
+    "<a href='/ap_details'><button>1 AP Details</button></a><br>"
+    "<a href='/ap_qr'><button>2 QR Code</button></a>"
+    "</body></html>"));
+  server.sendContent("");
 }
 
 
 void handleAPDetails(const String& apIP, const String& apSsid, const String& apPass) {
-  String html = "<html><head><title>AP Details</title></head><body style='font-family: Arial; text-align:center;'>";
-  html += "<h2>AP Details</h2>";
-  html += "<p><b>SSID:</b> " + apSsid + "</p>";
-  html += "<p><b>Password:</b> " + apPass + "</p>";
-  html += "<p><b>IP Address:</b> " + apIP + "</p>";
-  html += "<a href='/'><button>Back</button></a>";
-  html += "</body></html>";
-  server.send(200, "text/html", html);
+  beginHtmlResponse();
+  server.sendContent_P(PSTR(
+    "<html><head><title>AP Details</title></head><body style='font-family: Arial; text-align:center;'>"
+    "<h2>AP Details</h2>"));
+  sendApFields("IP Address", apIP, apSsid, apPass);
+  server.sendContent_P(PSTR("<a href='/'><button>Back</button></a></body></html>"));
+  server.sendContent("");
 }
 
 void handleAPQR(const String& apIP) {
   // QR now contains the WiFi config page link
-  String qrData = "http://" + apIP + "/wifi_config";
-  String qrUrl = "https://api.qrserver.com/v1/create-qr-code/?size=200x200&data=" + qrData;
-
-  String html = "<html><head><title>AP QR Code</title></head>"
-                "<body style='font-family: Arial; text-align:center;'>";
-  html += "<h2>Scan to Configure ESP WiFi</h2>";
-  html += "<img src='" + qrUrl + "' alt='QR Code'><br>";
-  html += "<p>URL: " + qrData + "</p>";
-  html += "<a href='/'><button>Back</button></a>";
-  html += "</body></html>";
-  
-  server.send(200, "text/html", html);
+  char buf[256];
+  beginHtmlResponse();
+  server.sendContent_P(PSTR(
+    "<html><head><title>AP QR Code</title></head>"
+    "<body style='font-family: Arial; text-align:center;'>"
+    "<h2>Scan to Configure ESP WiFi</h2>"));
+  snprintf(buf, sizeof(buf),
+           "<img src='https://api.qrserver.com/v1/create-qr-code/?size=200x200&data=http://%s/wifi_config' alt='QR Code'><br>"
+           "<p>URL: http://%s/wifi_config</p>",
+           apIP.c_str(), apIP.c_str());
+  server.sendContent(buf);
+  server.sendContent_P(PSTR("<a href='/'><button>Back</button></a></body></html>"));
+  server.sendContent("");
 }
 
 
@@ -276,13 +773,14 @@ void setupServerRoutes_AP(const String& apIP, const String& apSsid, const String
     if (WiFi.status() == WL_CONNECTED) {
       server.send(200, "text/plain", WiFi.localIP().toString());
     } else {
-      server.send(200, "text/plain", "NOT_CONNECTED");
+      server.send_P(200, MIME_TEXT_PLAIN, PSTR("NOT_CONNECTED"));
     }
   });
 
   server.on("/reboot", HTTP_POST, []() {
-    server.send(200, "text/plain", "Rebooting...");
-    addSerialLog("Reboot command received via API.");
+    server.send_P(200, MIME_TEXT_PLAIN, PSTR("Rebooting..."));
+    addSerialLog(F("Reboot command received via API."));
+    i2cFlushEepromWrites();
     delay(500);
     ESP.restart();
   });
@@ -302,37 +800,37 @@ void setupServerRoutes_AP(const String& apIP, const String& apSsid, const String
   server.on("/wifi_config", HTTP_POST, handleWiFiConfig);
 
   // === Live Data in AP mode (now shows real readings) ===
-  server.on("/live_data", HTTP_GET, [apSsid, apIP]() {
-    StaticJsonDocument<256> doc;
-    doc["voltage"] = currentVoltage;
-    doc["current"] = filteredCurrent;
-    doc["soc"] = soc;
-    doc["power"] = currentPower;
-    doc["runtime"] = "N/A";
-    doc["status"] = (filteredCurrent > chargingCurrentThreshold) ? "Charging" :
-                    ((filteredCurrent < -dischargingCurrentThreshold) ? "Discharging" : "Idle");
-    doc["rssi"] = WiFi.RSSI();
-    doc["mode"] = "AP";
-    doc["ip"] = apIP;
-    String jsonStr;
-    serializeJson(doc, jsonStr);
-    server.send(200, "application/json", jsonStr);
+  server.on("/live_data", HTTP_GET, [apIP]() {
+    char out[384];
+    sendJson(out, writeLiveDataJson(out, sizeof(out), "AP", apIP.c_str(),
+                                    extremesTake(EXTREMES_LIVE_DATA)));
   });
 
+  server.on("/i2c_stats", HTTP_GET, handleI2CStats);
+  server.on("/net_status", HTTP_GET, handleNetStatus);
+  server.on("/time_status", HTTP_GET, handleTimeStatus);
+  server.on("/sched", HTTP_GET, handleSchedStats);
+  server.on("/perf", HTTP_GET, handlePerfStats);
+  server.on("/heap", HTTP_GET, handleHeapStats);
+  server.on("/stalls", HTTP_GET, handleStalls);
+  server.on("/capture", HTTP_GET, handleCaptureGet);
+  server.on("/capture", HTTP_POST, handleCapturePost);
+  server.on("/captures", HTTP_GET, handleCapturesGet);
+  server.on("/histogram", HTTP_GET, handleHistogram);
+  server.on("/trigger", HTTP_POST, handleTriggerPost);
+#if ENABLE_BENCH
+  server.on("/bench", HTTP_GET, handleBench);
+#endif
+#if BATTERY_SIM
+  server.on("/sim", HTTP_GET, handleSimReport);
+#endif
+
   // ✅ Serial log in AP mode
-  server.on("/serial_log", HTTP_GET, []() {
-    String logContent;
-    int idx = logIndex;
-    for (int i = 0; i < MAX_LOG_LINES; i++) {
-      logContent += serialLogBuffer[idx] + "\n";
-      idx = (idx + 1) % MAX_LOG_LINES;
-    }
-    server.send(200, "text/plain", logContent);
-  });
+  server.on("/serial_log", HTTP_GET, handleSerialLog);
 
   // ✅ Unified settings endpoint for AP mode
   server.on("/settings", HTTP_GET, handleSettingsGet);
-  server.on("/settings", HTTP_POST, handleSettingsPost);
+  server.on("/settings", HTTP_POST, handleSettingsPost, handleSettingsPostBody);
 
   // === 404 Handler ===
   server.onNotFound(handleNotFound);
@@ -340,85 +838,72 @@ void setupServerRoutes_AP(const String& apIP, const String& apSsid, const String
 
 
 
+size_t writeSettingsJson(char* buf, size_t size) {
+  JsonWriter json(buf, size);
+  settingsWriteJson(json); // one member per SETTINGS_TABLE row
+  json.finish();
+  return json.overflowed() ? 0 : json.length();
+}
+
 void handleSettingsGet() {
-  StaticJsonDocument<256> doc;
-  doc["capacity_ah"] = batteryCapacityAh;
-  doc["voltage_offset"] = voltageOffset;
-  doc["current_offset"] = currentOffset;
-  doc["mv_per_amp"] = mVperAmp;
-  doc["charge_threshold"] = chargingCurrentThreshold;
-  doc["discharge_threshold"] = dischargingCurrentThreshold;
-  doc["soc"] = soc;
-  doc["current_deadzone"] = currentDeadzoneThreshold;
+  char out[384];
+  sendJson(out, writeSettingsJson(out, sizeof(out)));
+}
 
 
-  String jsonStr;
-  serializeJson(doc, jsonStr);
-  server.send(200, "application/json", jsonStr);
+static SettingsParser settingsParser;
+
+// Raw body chunks (ESP8266WebServer hands non-form bodies to the upload
+// callback as they are read), so the body never lands in server.arg("plain")
+void handleSettingsPostBody() {
+  HTTPRaw& raw = server.raw();
+  if (raw.status == RAW_START) {
+    settingsParser.reset();   // drop whatever an earlier request left behind
+    settingsParser.begin(server.clientContentLength());
+  } else if (raw.status == RAW_WRITE) {
+    settingsParser.feed((const char*)raw.buf, raw.currentSize);
+  } else if (raw.status == RAW_ABORTED) {
+    // Client went away mid-body: handleSettingsPost() will not run, so
+    // the next form-encoded POST must not see a half-parsed request
+    settingsParser.reset();
+  }
 }
 
-
 void handleSettingsPost() {
-  if (!server.hasArg("plain")) {
-    server.send(400, "text/plain", "Body missing");
-    return;
+  if (!settingsParser.started()) {
+    // Form-encoded bodies skip the raw callback and arrive as "plain"
+    if (!server.hasArg("plain")) {
+      server.send_P(400, MIME_TEXT_PLAIN, PSTR("Body missing"));
+      return;
+    }
+    const String& body = server.arg("plain");
+    settingsParser.begin(body.length());
+    settingsParser.feed(body.c_str(), body.length());
   }
 
-  // Debug log to see exactly what was sent
-  addSerialLog("Incoming settings JSON: " + server.arg("plain"));
-
-  StaticJsonDocument<512> doc;
-  if (deserializeJson(doc, server.arg("plain"))) {
-    server.send(400, "text/plain", "Invalid JSON");
+  if (!settingsParser.finish()) {
+    addSerialLogf_P(PSTR("⚠️ Settings rejected: %s"), settingsParser.error());
+    server.send(400, "text/plain", settingsParser.error());
+    settingsParser.reset();
     return;
   }
 
-  if (doc.containsKey("current_deadzone")) {
-    currentDeadzoneThreshold = doc["current_deadzone"].as<float>();
-    writeFloat(ADDR_CURRENT_DEADZONE, currentDeadzoneThreshold);
-    addSerialLog("💾 Writing to DS3231 EEPROM @ " + String(ADDR_CURRENT_DEADZONE) + " -> " + String(currentDeadzoneThreshold, 4));
+  settingsParser.apply();
+  addSerialLogf_P(PSTR("Settings updated via API (%u keys)."), settingsParser.count());
+  settingsParser.reset();
+  server.send_P(200, MIME_TEXT_PLAIN, PSTR("Settings updated and saved to EEPROM."));
 }
 
-  if (doc.containsKey("capacity_ah")) {
-    batteryCapacityAh = doc["capacity_ah"].as<float>();
-    writeFloat(ADDR_BATTERY_CAPACITY, batteryCapacityAh);
-  }
-  if (doc.containsKey("voltage_offset")) {
-    voltageOffset = doc["voltage_offset"].as<float>();
-    writeFloat(ADDR_VOLTAGE_OFFSET, voltageOffset);
-  }
-  if (doc.containsKey("current_offset")) {
-    currentOffset = doc["current_offset"].as<float>();
-    writeFloat(ADDR_CURRENT_OFFSET, currentOffset);
-  }
-  if (doc.containsKey("mv_per_amp")) {
-    mVperAmp = doc["mv_per_amp"].as<float>();
-    writeFloat(ADDR_MV_PER_AMP, mVperAmp);
-  }
-  if (doc.containsKey("charge_threshold")) {
-    chargingCurrentThreshold = doc["charge_threshold"].as<float>();
-    writeFloat(ADDR_CHARGING_THRESHOLD, chargingCurrentThreshold);
-  }
-  if (doc.containsKey("discharge_threshold")) {
-    dischargingCurrentThreshold = doc["discharge_threshold"].as<float>();
-    writeFloat(ADDR_DISCHARGING_THRESHOLD, dischargingCurrentThreshold);
-  }
-
- // Always handle SOC, keeping old value if not sent
-  if (!doc.containsKey("soc")) {
-      doc["soc"] = soc; // keep old value
-  }
-  soc = doc["soc"].as<float>();
-  if (soc < 0) soc = 0;
-  if (soc > 100) soc = 100;
-  totalCoulombs = (soc / 100.0) * batteryCapacityAh * 3600.0;
-  writeFloat(ADDR_SOC, soc);
-  addSerialLog("SOC updated via /settings API to " + String(soc) + "%");
-
-  lastActiveStateChange = millis(); // ✅ reset idle timer so voltage SOC won't override immediately
+// X(key, value, decimals): /wifi_config POST reply
+#define WIFI_CONFIG_FIELDS(X) \
+  X("status", status, 0) \
+  X("sta_ip", staIp,  0)
 
-  addSerialLog("Settings updated via API.");
-  server.send(200, "text/plain", "Settings updated and saved to EEPROM.");
+static size_t writeWiFiConfigJson(char* buf, size_t size, const char* status, const char* staIp) {
+  JsonWriter json(buf, size);
+  JSON_WRITE(WIFI_CONFIG_FIELDS);
+  json.finish();
+  return json.overflowed() ? 0 : json.length();
 }
 
 /*
@@ -428,26 +913,48 @@ void handleSettingsPost() {
        the response, it waits briefly and then restarts the ESP.
 */
 void handleWiFiConfig() {
+    STALL_MARK("wifi_config"); // waits for the STA join before replying
     if (!server.hasArg("plain")) {
-        server.send(400, "text/plain", "Body missing");
+        server.send_P(400, MIME_TEXT_PLAIN, PSTR("Body missing"));
         return;
     }
 
-    StaticJsonDocument<256> req;
+    StaticJsonDocument<384> req;
     if (deserializeJson(req, server.arg("plain"))) {
-        server.send(400, "text/plain", "Invalid JSON");
+        server.send_P(400, MIME_TEXT_PLAIN, PSTR("Invalid JSON"));
         return;
     }
 
     const char* newSsid = req["ssid"];
     const char* newPass = req["password"];
     if (newSsid && newPass) {
+        // Optional static IP: "static_ip" + "gateway" [+ "subnet", "dns"]; "" = DHCP
+        if (req.containsKey("static_ip")) {
+            const char* staticIp = req["static_ip"];
+            if (!staticIp || staticIp[0] == '\0') {
+                networkClearStaticIp();
+            } else {
+                IPAddress ip, gateway, subnet(255, 255, 255, 0), dns;
+                const char* gatewayStr = req["gateway"];
+                const char* subnetStr = req["subnet"];
+                const char* dnsStr = req["dns"];
+                if (!ip.fromString(staticIp) || !gatewayStr || !gateway.fromString(gatewayStr) ||
+                    (subnetStr && !subnet.fromString(subnetStr))) {
+                    server.send_P(400, MIME_TEXT_PLAIN, PSTR("Invalid static IP settings"));
+                    return;
+                }
+                if (!dnsStr || !dns.fromString(dnsStr)) dns = gateway;
+                networkSetStaticIp(ip, gateway, subnet, dns);
+                addSerialLogf_P(PSTR("Static IP set: %s"), ip.toString().c_str());
+            }
+        }
+
         // Save credentials to EEPROM (or whatever storage)
         saveWiFiCredentials(newSsid, newPass);
-        addSerialLog("WiFi config updated via API: SSID=" + String(newSsid));
+        addSerialLogf_P(PSTR("WiFi config updated via API: SSID=%s"), newSsid);
 
         // Tell the client we started connecting (we will reply with final JSON below)
-        addSerialLog("Attempting STA connect while keeping AP up (WIFI_AP_STA)");
+        addSerialLog(F("Attempting STA connect while keeping AP up (WIFI_AP_STA)"));
 
         // Keep AP alive while trying to join the router
         WiFi.mode(WIFI_AP_STA);
@@ -468,7 +975,7 @@ void handleWiFiConfig() {
             if (WiFi.status() == WL_CONNECTED) {
                 assignedIp = WiFi.localIP();
                 connected = true;
-                addSerialLog("STA connected — IP: " + assignedIp.toString());
+                addSerialLogf_P(PSTR("STA connected — IP: %s"), assignedIp.toString().c_str());
                 break;
             }
             delay(10); // shorter wait
@@ -476,55 +983,53 @@ void handleWiFiConfig() {
         }
 
         if (!connected) {
-            addSerialLog("STA did not connect within timeout.");
+            addSerialLog(F("STA did not connect within timeout."));
         }
 
         // Build JSON response containing the STA IP (or NOT_CONNECTED)
-        StaticJsonDocument<256> resp;
+        const char* status = "NOT_CONNECTED";
+        char staIp[16] = "";
         if (connected && assignedIp != IPAddress(0,0,0,0)) {
-            resp["status"] = "OK";
-            resp["sta_ip"] = assignedIp.toString();
-        } else {
-            resp["status"] = "NOT_CONNECTED";
-            resp["sta_ip"] = "";
+            status = "OK";
+            formatIp(assignedIp, staIp, sizeof(staIp));
         }
-        String out;
-        serializeJson(resp, out);
-
-        // Send JSON response back to app (app should read this before we reboot)
-        server.send(200, "application/json", out);
+        char out[64];
+        sendJson(out, writeWiFiConfigJson(out, sizeof(out), status, staIp));
 
         // Give the client a moment to receive the response (adjustable)
         delay(1200);
 
         // Optionally log and restart to ensure clean state (you may choose to skip reboot if connected)
-        addSerialLog("Rebooting now to apply network changes.");
+        addSerialLog(F("Rebooting now to apply network changes."));
+        i2cFlushEepromWrites(); // make sure queued credentials hit the EEPROM
         delay(300); // tiny extra wait
         ESP.restart();
     } else {
-        server.send(400, "text/plain", "Missing ssid or password");
+        server.send_P(400, MIME_TEXT_PLAIN, PSTR("Missing ssid or password"));
     }
 }
 
 
+// Streamed line by line (chunked) instead of concatenating ~7 KB into one String
 void handleSerialLog() {
-  String logContent;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send_P(200, MIME_TEXT_PLAIN, PSTR(""));
   int idx = logIndex;
   for (int i = 0; i < MAX_LOG_LINES; i++) {
-    logContent += serialLogBuffer[idx] + "\n";
+    server.sendContent(serialLogBuffer[idx]);
+    server.sendContent("\n", 1);
     idx = (idx + 1) % MAX_LOG_LINES;
   }
-  server.send(200, "text/plain", logContent);
+  server.sendContent("");
 }
 
 void handleNotFound() {
-  server.send(404, "text/plain", "Not Found");
+  server.send_P(404, MIME_TEXT_PLAIN, PSTR("Not Found"));
 }
 
 // ===================== HTML WiFi Config =====================
 
-void handleWiFiConfigPage() {
-  String html = R"rawliteral(
+static const char WIFI_CONFIG_PAGE[] PROGMEM = R"rawliteral(
     <html>
     <head><title>WiFi Setup</title></head>
     <body style="font-family: Arial; text-align:center;">
@@ -534,6 +1039,10 @@ void handleWiFiConfigPage() {
         <input type="text" id="ssid" required><br><br>
         <label>Password:</label><br>
         <input type="password" id="password" required><br><br>
+        <label>Static IP (optional, blank = DHCP):</label><br>
+        <input type="text" id="static_ip"><br><br>
+        <label>Gateway:</label><br>
+        <input type="text" id="gateway"><br><br>
         <input type="submit" value="Save WiFi">
       </form>
       <p id="status"></p>
@@ -542,10 +1051,13 @@ void handleWiFiConfigPage() {
           e.preventDefault();
           var ssid = document.getElementById('ssid').value;
           var pass = document.getElementById('password').value;
+          var body = {ssid: ssid, password: pass,
+                      static_ip: document.getElementById('static_ip').value};
+          if (body.static_ip) body.gateway = document.getElementById('gateway').value;
           fetch('/wifi_config', {
             method: 'POST',
             headers: {'Content-Type': 'application/json'},
-            body: JSON.stringify({ssid: ssid, password: pass})
+            body: JSON.stringify(body)
           }).then(r => r.json()).then(j => {
             // show friendly text for browser users; app will parse JSON too
             if (j.status === 'OK') {
@@ -561,49 +1073,62 @@ void handleWiFiConfigPage() {
     </body>
     </html>
   )rawliteral";
-  server.send(200, "text/html", html);
+
+void handleWiFiConfigPage() {
+  server.send_P(200, MIME_TEXT_HTML, WIFI_CONFIG_PAGE);
 }
 
 // ========================= Init ============================
 
 void setupServerRoutes() {
   server.on("/", HTTP_GET, []() {
-    server.send(200, "text/plain", "ESP Battery Monitor");
+    server.send_P(200, MIME_TEXT_PLAIN, PSTR("ESP Battery Monitor"));
   });
 
   server.on("/sta_ip", HTTP_GET, []() {
     if (WiFi.status() == WL_CONNECTED) {
       server.send(200, "text/plain", WiFi.localIP().toString());
     } else {
-      server.send(200, "text/plain", "NOT_CONNECTED");
+      server.send_P(200, MIME_TEXT_PLAIN, PSTR("NOT_CONNECTED"));
     }
   });
 
   server.on("/reboot", HTTP_POST, []() {
-    server.send(200, "text/plain", "Rebooting...");
-    addSerialLog("Reboot command received via API.");
+    server.send_P(200, MIME_TEXT_PLAIN, PSTR("Rebooting..."));
+    addSerialLog(F("Reboot command received via API."));
+    i2cFlushEepromWrites();
     delay(500);
     ESP.restart();
   });
 
   server.on("/live_data", HTTP_GET, handleLiveData);
+  server.on("/i2c_stats", HTTP_GET, handleI2CStats);
+  server.on("/net_status", HTTP_GET, handleNetStatus);
+  server.on("/time_status", HTTP_GET, handleTimeStatus);
+  server.on("/sched", HTTP_GET, handleSchedStats);
+  server.on("/perf", HTTP_GET, handlePerfStats);
+  server.on("/heap", HTTP_GET, handleHeapStats);
+  server.on("/stalls", HTTP_GET, handleStalls);
+  server.on("/capture", HTTP_GET, handleCaptureGet);
+  server.on("/capture", HTTP_POST, handleCapturePost);
+  server.on("/captures", HTTP_GET, handleCapturesGet);
+  server.on("/histogram", HTTP_GET, handleHistogram);
+  server.on("/trigger", HTTP_POST, handleTriggerPost);
+#if ENABLE_BENCH
+  server.on("/bench", HTTP_GET, handleBench);
+#endif
+#if BATTERY_SIM
+  server.on("/sim", HTTP_GET, handleSimReport);
+#endif
 
   // ✅ Unified settings handling for SOC + all other settings
   server.on("/settings", HTTP_GET, handleSettingsGet);
-  server.on("/settings", HTTP_POST, handleSettingsPost);
+  server.on("/settings", HTTP_POST, handleSettingsPost, handleSettingsPostBody);
 
   server.on("/wifi_config", HTTP_GET, handleWiFiConfigPage);
   server.on("/wifi_config", HTTP_POST, handleWiFiConfig);
 
-  server.on("/serial_log", HTTP_GET, []() {
-    String logContent;
-    int idx = logIndex;
-    for (int i = 0; i < MAX_LOG_LINES; i++) {
-      logContent += serialLogBuffer[idx] + "\n";
-      idx = (idx + 1) % MAX_LOG_LINES;
-    }
-    server.send(200, "text/plain", logContent);
-  });
+  server.on("/serial_log", HTTP_GET, handleSerialLog);
 
   server.onNotFound(handleNotFound);
 }
@@ -618,6 +1143,7 @@ void loadWiFiCredentials() {
 void saveWiFiCredentials(const char* ssid, const char* pass) {
   writeString(ADDR_WIFI_SSID, ssid);
   writeString(ADDR_WIFI_PASS, pass);
+  networkForgetFastConnect(); // cached BSSID/lease belong to the old network
 }
 
 // ================== System Logging API =====================
@@ -625,27 +1151,27 @@ void saveWiFiCredentials(const char* ssid, const char* pass) {
 void logSystemStatus() {
   unsigned long uptime = millis() / 1000;
   int rssi = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : -999;
-  int freeHeap = ESP.getFreeHeap();
 
-  addSerialLog("Uptime: " + String(uptime) + "s");
-  addSerialLog("Free heap memory: " + String(freeHeap) + " bytes");
+  heapMonitorSample();
+  const HeapStats& heap = heapStats();
+
+  addSerialLogf_P(PSTR("Uptime: %lus"), uptime);
+  addSerialLogf_P(PSTR("Heap: %lu B free, largest block %lu B, frag %u%% (min free %lu B)"),
+                (unsigned long)heap.freeBytes, (unsigned long)heap.maxBlock,
+                heap.fragPct, (unsigned long)heap.minFreeBytes);
 
   if (rssi != -999) {
-    addSerialLog("WiFi RSSI: " + String(rssi) + " dBm");
+    addSerialLogf_P(PSTR("WiFi RSSI: %d dBm"), rssi);
   }
 }
 
+const char* batteryStatusText() {
+  if (filteredCurrent > chargingCurrentThreshold) return "Charging";
+  if (filteredCurrent < -dischargingCurrentThreshold) return "Discharging";
+  return "Idle";
+}
+
 void logSensorStatus() {
-  String status = (filteredCurrent > chargingCurrentThreshold)
-                      ? "Charging"
-                      : ((filteredCurrent < -dischargingCurrentThreshold)
-                             ? "Discharging"
-                             : "Idle");
-
-  String msg = "Voltage: " + String(currentVoltage) + " V, " +
-               "Current: " + String(filteredCurrent) + " A, " +
-               "Power: " + String(currentPower) + " W, " +
-               "SOC: " + String(soc) + "%, Status: " + status;
-
-  addSerialLog(msg);
+  addSerialLogf_P(PSTR("Voltage: %.2f V, Current: %.2f A, Power: %.2f W, SOC: %.2f%%, Status: %s"),
+                currentVoltage, filteredCurrent, currentPower, soc, batteryStatusText());
 }
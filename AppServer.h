@@ -13,9 +13,9 @@
    - setupServerRoutes() / setupServerRoutes_AP()
    - handleServerClient()
    - loadWiFiCredentials() / saveWiFiCredentials()
-   - syncTimeFromNTPtoRTC()
    - logSystemStatus(), logSensorStatus()
-   - addSerialLog()
+   - addSerialLog(), addSerialLogf_P()
+   - batteryStatusText()
 
    Exposed Globals:
    - ESP8266WebServer server
@@ -26,6 +26,8 @@
 #define APP_SERVER_H
 
 #include <ESP8266WebServer.h>
+#include <ArduinoJson.h>
+#include "Extremes.h"
 
 // Stored WiFi credentials (in AppServer.cpp)
 extern char savedSsid[32];
@@ -42,11 +44,20 @@ void setupServerRoutes_AP(const String& apIP, const String& apSsid, const String
 void handleServerClient();
 void loadWiFiCredentials();
 void saveWiFiCredentials(const char* ssid, const char* pass);
-void syncTimeFromNTPtoRTC();
+
+// JSON bodies shared by the handlers and the benchmarks (0 = buffer too small)
+size_t writeLiveDataJson(char* buf, size_t size, const char* mode, const char* ip,
+                         const Extremes& ext);
+size_t writeSettingsJson(char* buf, size_t size);
+void registerServerBenchmarks(); // ENABLE_BENCH builds only
 
 // Logging / status
 void logSystemStatus();
 void logSensorStatus();
+void addSerialLog(const char* message);
 void addSerialLog(const String& message);
+void addSerialLog(const __FlashStringHelper* message);               // addSerialLog(F("..."))
+void addSerialLogf_P(PGM_P fmt, ...) __attribute__((format(printf, 1, 2))); // addSerialLogf_P(PSTR("..."), ...)
+const char* batteryStatusText(); // "Charging" / "Discharging" / "Idle"
 
 #endif // APP_SERVER_H
@@ -17,7 +17,7 @@
    - Wi-Fi AP + STA provisioning
    - RTC (DS3231) timekeeping with NTP sync
    - REST endpoints for app integration:
-       • /live_data   - JSON live values
+       • /live_data   - JSON live values (incl. active alarms)
        • /serial_log  - recent logs
        • /settings    - get/set config + SOC
        • /wifi_config - Wi-Fi credentials
@@ -40,11 +40,31 @@
 #include "qrcode.h"
 #include "EEPROMUtils.h"
 #include "AppServer.h"
-#include <ESP8266HTTPClient.h> 
+#include "History.h"
+#include "I2CBus.h"
+#include "NetworkManager.h"
+#include "TimeSync.h"
+#include "Scheduler.h"
+#include "Profiler.h"
+#include "HeapMonitor.h"
+#include "Bench.h"
+#include "BatterySim.h"
+#include "StallWatch.h"
+#include "MemoryConfig.h"
+#include "StringTable.h"
+#include "Settings.h"
+#include "Alarms.h"
+#include "Capture.h"
+#include "Trigger.h"
+#include "Extremes.h"
+#include "Histogram.h"
+#include "Forecast.h"
 
 #define BLYNK_TEMPLATE_ID "" //Your Template ID
 #define BLYNK_TEMPLATE_NAME "Smart Battery Monitor"
 #define BLYNK_AUTH_TOKEN "" //Your Auth Token
+#define BLYNK_MAX_READBYTES MEM_BLYNK_READBYTES   // sized by the memory profile
+#define BLYNK_MAX_SENDBYTES MEM_BLYNK_SENDBYTES
 
 #include <ESP8266WiFi.h>
 #include <BlynkSimpleEsp8266.h>
@@ -56,10 +76,12 @@
 // ======================= OLED Display =======================
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+// Keep the bus at Fast-mode after each flush (library default drops to 100 kHz)
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, I2C_FAST_MODE_HZ, I2C_FAST_MODE_HZ);
 
 // ==== Function Prototypes ====
 void startAPMode();
+void startAPFallback();
 void showAPMenuOLED();
 void displayAPDetails(const String& apIP);
 void displayAPQRCode(const String& apIP);
@@ -72,28 +94,18 @@ RTC_DS3231 rtc;
 
 // ======================= EEPROM (AT24C32 on DS3231 module) =======================
 const uint8_t EEPROM_ADDR = 0x57;
+// User settings (capacity, thresholds, calibration, SOC, ...) own their
+// offsets in SETTINGS_TABLE (Settings.h); the rest is firmware state.
 const uint16_t ADDR_ZERO_ADC = 0;
 const uint16_t ADDR_COULOMBS = 10;
-const uint16_t ADDR_BATTERY_CAPACITY = 20;
-const uint16_t ADDR_VOLTAGE_OFFSET = 30;
-const uint16_t ADDR_CURRENT_OFFSET = 40;
-const uint16_t ADDR_MV_PER_AMP = 50;
-const uint16_t ADDR_VOLTAGE_THRESHOLD_MIN = 60;
-const uint16_t ADDR_VOLTAGE_THRESHOLD_MAX = 70;
-const uint16_t ADDR_BATTERY_TYPE = 80;
-const uint16_t ADDR_SCREEN_TIMEOUT = 90;
 const uint16_t ADDR_STATS_CYCLE_COUNT = 100;
 const uint16_t ADDR_STATS_TOTAL_ENERGY_IN = 110;
 const uint16_t ADDR_STATS_TOTAL_ENERGY_OUT = 120;
 const uint16_t ADDR_CALIBRATION_SAVED = 130;
-const uint16_t ADDR_SOC = 140;
 const uint16_t ADDR_SOC_SAVED_FLAG = 150;
 const uint16_t ADDR_CHARGING_SECONDS = 160;
 const uint16_t ADDR_DISCHARGING_SECONDS = 170;
 const uint16_t ADDR_IDLE_SECONDS = 180;
-const uint16_t ADDR_CHARGING_THRESHOLD = 200;
-const uint16_t ADDR_DISCHARGING_THRESHOLD = 210;
-const uint16_t ADDR_CURRENT_DEADZONE = 220;
 
 // --- WiFi first-boot skip flag (stored as float 0.0/1.0 to reuse existing helpers)
 const uint16_t ADDR_WIFI_SKIP_F = 230;   // free slot; not used by current addresses
@@ -112,7 +124,8 @@ enum EventType {
     EVENT_VOLTAGE_LOW = 4,
     EVENT_START_CHARGING = 5,
     EVENT_START_DISCHARGING = 6,
-    EVENT_IDLE = 7
+    EVENT_IDLE = 7,
+    EVENT_VOLTAGE_SAG = 8
 };
 
 // ======================= Menu State Variables =======================
@@ -128,11 +141,7 @@ enum MenuState {
 	
 	// Configuration Submenu States
 	STATE_BATTERY_SETTINGS_MENU,
-	STATE_SET_CAPACITY,
-	STATE_SET_VOLTAGE_THRESHOLDS_MIN,
-	STATE_SET_VOLTAGE_THRESHOLDS_MAX,
-	STATE_SET_BATTERY_TYPE,
-	STATE_SET_SCREEN_TIMEOUT,
+	STATE_EDIT_SETTING,          // generic editor for the setting in editSetting
 	STATE_RESET_SOC,
 
 	// Calibration Submenu States
@@ -140,20 +149,16 @@ enum MenuState {
 	STATE_VOLTAGE_CAL_MENU,
 	STATE_SAVE_LOAD_CAL_MENU,
 	STATE_AUTO_ZERO_CURRENT,
-	STATE_MANUAL_ZERO_OFFSET,
-	STATE_SET_MV_PER_AMP,
-	STATE_ADJUST_VOLTAGE_OFFSET,
 	STATE_CALIBRATE_KNOWN_VOLTAGE,
 	STATE_SAVE_CALIBRATION,
 	STATE_LOAD_CALIBRATION,
 	STATE_RESET_CALIBRATION,
-	STATE_SET_CHARGING_THRESHOLD,
-	STATE_SET_DISCHARGING_THRESHOLD,
 	
 	// Statistics Submenu States
 	STATE_VIEW_CYCLE_COUNT,
 	STATE_VIEW_TOTAL_ENERGY,
 	STATE_VIEW_RUNTIME_HISTORY,
+	STATE_VIEW_TRENDS,
 	STATE_RESET_STATS,
 	
 	// System Info Submenu States
@@ -161,6 +166,7 @@ enum MenuState {
 	STATE_VIEW_SENSOR_STATUS,
 	STATE_VIEW_MEMORY_USAGE,
 	STATE_VIEW_UPTIME,
+	STATE_VIEW_PERF,
 	STATE_ABOUT_MENU,
 
 	// General States
@@ -180,19 +186,16 @@ MenuHistory menuHistory[MAX_HISTORY_DEPTH];
 int historyIndex = -1;
 
 void logEvent(EventType type) {
-    DateTime now = rtc.now();
-    uint32_t timestamp = now.unixtime();
+    uint32_t timestamp = timeSyncUnixtime();
     uint16_t addr = EVENT_LOG_START_ADDR + (eventLogIndex % MAX_LOGS) * LOG_ENTRY_SIZE;
-    Wire.beginTransmission(EEPROM_ADDR);
-    Wire.write((uint8_t)(addr >> 8));
-    Wire.write((uint8_t)(addr & 0xFF));
-    Wire.write((uint8_t)type);
-    Wire.write((uint8_t)(timestamp >> 24));
-    Wire.write((uint8_t)(timestamp >> 16));
-    Wire.write((uint8_t)(timestamp >> 8));
-    Wire.write((uint8_t)(timestamp));
-    Wire.endTransmission();
-    delay(10);
+    uint8_t entry[LOG_ENTRY_SIZE] = {
+        (uint8_t)type,
+        (uint8_t)(timestamp >> 24),
+        (uint8_t)(timestamp >> 16),
+        (uint8_t)(timestamp >> 8),
+        (uint8_t)(timestamp)
+    };
+    writeBytes(addr, entry, LOG_ENTRY_SIZE); // queued, no bus stall
 
     eventLogIndex++;
     if (eventLogIndex >= MAX_LOGS) eventLogIndex = 0;
@@ -218,12 +221,16 @@ int selectedMenuIndex = 0;
 int menuScrollOffset = 0;
 const int visibleMenuItems = 4;
 float tempFloatValue = 0.0;
-int tempIntValue = 0;
+SettingId editSetting = SETTING_NONE;      // row being edited in STATE_EDIT_SETTING
+SettingId editNextSetting = SETTING_NONE;  // edited next (min → max voltage)
+char settingMessage[32];
 const char* tempMessage = "";
 unsigned long lastButtonPressTime = 0;
 const unsigned long debounceDelay = 200;
 int saverX = 0, saverY = 0;
 int saverDX = 1, saverDY = 1;
+int trendMetric = HIST_METRIC_VOLTAGE;
+int trendSpan = HIST_SPAN_HOUR;
 
 // === CONFIGURABLE & VARIABLE ===
 const char* FIRMWARE_VERSION = "1.2.3";
@@ -303,104 +310,90 @@ static float filteredPower = 0.0;
 unsigned long messageDisplayStartTime = 0;
 const unsigned long messageDuration = 2000;
 
-//internet checker
-bool internetConnected = false;         // Global flag
-unsigned long lastInternetCheck = 0;
-const unsigned long INTERNET_CHECK_INTERVAL = 15UL * 60UL * 1000UL;  // 15 min
-
-// ======================= Menu Item Arrays =======================
-const char* mainMenuOptions[] = {
-	"Live Data View",
-	"Configuration",
-	"Calibration",
-	"Statistics",
-	"System Info",
-	"Github",
-  "Activate AP Mode"
-};
-const int numMainMenuItems = sizeof(mainMenuOptions) / sizeof(mainMenuOptions[0]);
-
-const char* configMenuOptions[] = {
-	"Battery Settings",
-	"Set screen timeout",
-	"Back"
-};
-const int numConfigMenuItems = sizeof(configMenuOptions) / sizeof(configMenuOptions[0]);
-
-const char* batterySettingsOptions[] = {
-	"Set battery capacity (Ah)",
-	"Set voltage thresholds (min/max)",
-	"Select battery type",
-	"Reset SOC to 100%",
-	"Back"
-};
-const int numBatterySettingsItems = sizeof(batterySettingsOptions) / sizeof(batterySettingsOptions[0]);
-const char* batteryTypes[] = {
-	"Li-ion",
-	"Lead Acid",
-	"Li-Po"
-};
-const char* calibrationMenuOptions[] = {
-	"Current Sensor Calibration",
-	"Voltage Calibration",
-	"Save/Load Calibration",
-	"Back"
-};
-const int numCalibrationMenuItems = sizeof(calibrationMenuOptions) / sizeof(calibrationMenuOptions[0]);
-
-const char* currentSensorCalOptions[] = {
-	"Auto-zero current sensor",
-	"Manual zero offset",
-	"Set Charge Curr",
-  "Set Discharge Curr",
-	"Set mV per Amp value",
-	"Back"
-};
-const int numCurrentSensorCalItems = sizeof(currentSensorCalOptions) / sizeof(currentSensorCalOptions[0]);
-
-const char* voltageCalOptions[] = {
-	"Adjust voltage reading offset",
-	"Calibrate with known voltage source",
-	"Back"
-};
-const int numVoltageCalItems = sizeof(voltageCalOptions) / sizeof(voltageCalOptions[0]);
-
-const char* saveLoadCalOptions[] = {
-	"Save to EEPROM",
-	"Load from EEPROM",
-	"Reset to defaults",
-	"Back"
-};
-const int numSaveLoadCalItems = sizeof(saveLoadCalOptions) / sizeof(saveLoadCalOptions[0]);
-
-const char* statsMenuOptions[] = {
-	"Cycle Count",
-	"Total Energy (Wh)",
-	"Runtime History",
-	"Reset Statistics",
-	"Back"
-};
+//internet checker (state lives in NetworkManager)
+bool internetConnected = false;         // Global flag, mirrors networkIsOnline()
+
+// ======================= Menu Item Tables =======================
+// Kept in flash (see StringTable.h); items are "\0"-terminated
+FLASH_STRING_TABLE(mainMenuOptions,
+	"Live Data View\0"
+	"Configuration\0"
+	"Calibration\0"
+	"Statistics\0"
+	"System Info\0"
+	"Github\0"
+	"Activate AP Mode\0");
+const int numMainMenuItems = mainMenuOptions.count;
+
+FLASH_STRING_TABLE(configMenuOptions,
+	"Battery Settings\0"
+	"Set screen timeout\0"
+	"Back\0");
+const int numConfigMenuItems = configMenuOptions.count;
+
+FLASH_STRING_TABLE(batterySettingsOptions,
+	"Set battery capacity (Ah)\0"
+	"Set voltage thresholds (min/max)\0"
+	"Select battery type\0"
+	"Reset SOC to 100%\0"
+	"Back\0");
+const int numBatterySettingsItems = batterySettingsOptions.count;
+FLASH_STRING_TABLE(calibrationMenuOptions,
+	"Current Sensor Calibration\0"
+	"Voltage Calibration\0"
+	"Save/Load Calibration\0"
+	"Back\0");
+const int numCalibrationMenuItems = calibrationMenuOptions.count;
+
+FLASH_STRING_TABLE(currentSensorCalOptions,
+	"Auto-zero current sensor\0"
+	"Manual zero offset\0"
+	"Set Charge Curr\0"
+	"Set Discharge Curr\0"
+	"Set mV per Amp value\0"
+	"Back\0");
+const int numCurrentSensorCalItems = currentSensorCalOptions.count;
+
+FLASH_STRING_TABLE(voltageCalOptions,
+	"Adjust voltage reading offset\0"
+	"Calibrate with known voltage source\0"
+	"Back\0");
+const int numVoltageCalItems = voltageCalOptions.count;
+
+FLASH_STRING_TABLE(saveLoadCalOptions,
+	"Save to EEPROM\0"
+	"Load from EEPROM\0"
+	"Reset to defaults\0"
+	"Back\0");
+const int numSaveLoadCalItems = saveLoadCalOptions.count;
+
+FLASH_STRING_TABLE(statsMenuOptions,
+	"Cycle Count\0"
+	"Total Energy (Wh)\0"
+	"Runtime History\0"
+	"Trend Graphs\0"
+	"Reset Statistics\0"
+	"Back\0");
 
 // Manual AP Mode submenu
 int apModeMenuIndex = 0;
-const char* apModeMenuOptions[] = {
-  "Start AP Mode",
-  "Stop AP Mode",
-  "Back"
-};
-const int apModeMenuCount = sizeof(apModeMenuOptions) / sizeof(apModeMenuOptions[0]);
-
-const int numStatsMenuItems = sizeof(statsMenuOptions) / sizeof(statsMenuOptions[0]);
-
-const char* systemInfoOptions[] = {
-	"Firmware Version",
-	"Sensor Status",
-	"Memory Usage",
-	"Uptime",
-	"About",
-	"Back"
-};
-const int numSystemInfoItems = sizeof(systemInfoOptions) / sizeof(systemInfoOptions[0]);
+FLASH_STRING_TABLE(apModeMenuOptions,
+  "Start AP Mode\0"
+  "Stop AP Mode\0"
+  "Back\0");
+const int apModeMenuCount = apModeMenuOptions.count;
+
+const int numStatsMenuItems = statsMenuOptions.count;
+
+FLASH_STRING_TABLE(systemInfoOptions,
+	"Firmware Version\0"
+	"Sensor Status\0"
+	"Memory Usage\0"
+	"Uptime\0"
+	"Performance\0"
+	"About\0"
+	"Back\0");
+const int numSystemInfoItems = systemInfoOptions.count;
 
 // ======================= Update all sensor data non-blocking =======================
 // ==== WCS1600 Config (same as standalone code) ====
@@ -409,7 +402,20 @@ const int numSystemInfoItems = sizeof(systemInfoOptions) / sizeof(systemInfoOpti
 #define MEASUREMENT_ITERATIONS 100
 #define WCS1600_SENSITIVITY_mV_PER_A 22.0
 
-float zeroOffset_mV = 2600.0; // Will be recalibrated in setup()
+float zeroOffset_mV = 2600.0; // Provisional value from setup(), refined in updateSensors()
+
+// ==== Fast boot ====
+// setup() only takes a handful of samples for a provisional zero offset;
+// the offset is then refined from the first sample blocks while normal
+// measurement is already running (no load is assumed during boot, as before).
+#define ZERO_PROVISIONAL_SAMPLES 8
+#define ZERO_SETTLE_MS 2000          // ignore blocks while the WCS1600 warms up
+#define ZERO_REFINE_MS 10000         // refinement window after boot
+#define BOOT_SPLASH_MS 1500          // 0 = no welcome screen
+unsigned long zeroRefineStartMs = 0;
+float zeroRefineSum_mV = 0.0;
+uint16_t zeroRefineBlocks = 0;
+unsigned long bootSplashUntilMs = 0;
 
 // Persistent variables for non-blocking ADC averaging
 static uint16_t adcSampleCount = 0;
@@ -452,16 +458,256 @@ float getSocFromVoltage(float voltage) {
     return 0.0;
 }
 
-void updateSensors() {
-    unsigned long now = millis();
+// ======================= Battery clock =======================
+// Time base for battery bookkeeping (SOC integration, idle correction,
+// periodic saves, daily reset): the real clock, or the virtual one in
+// BATTERY_SIM builds. UI timing always stays on millis().
+unsigned long batteryMillis() {
+#if BATTERY_SIM
+    return simMillis();
+#else
+    return millis();
+#endif
+}
+
+bool batteryNow(DateTime* out) {
+#if BATTERY_SIM
+    simNow(out);
+    return true;
+#else
+    return timeSyncNow(out);
+#endif
+}
+
+void setBatteryInterval(unsigned long periodMs, void (*fn)()) {
+#if BATTERY_SIM
+    simSetInterval(periodMs, fn);
+#else
+    timer.setInterval(periodMs, fn);
+#endif
+}
+
+// ======================= Checked sensor reads =======================
+// Register-level reads with timeouts and error reporting, used instead of
+// the Adafruit helpers (ADS1115's readADC_SingleEnded() spins forever if
+// the chip stops answering).
+#define ADS1115_I2C_ADDR 0x48
+#define ADS1115_REG_CONVERSION 0x00
+#define ADS1115_REG_CONFIG 0x01
+#define ADS1115_OS_SINGLE 0x8000        // start / conversion done
+#define ADS1115_MUX_SINGLE_0 0x4000
+#define ADS1115_PGA_4_096V 0x0200       // matches ads.setGain(GAIN_ONE)
+#define ADS1115_MODE_SINGLE 0x0100
+#define ADS1115_MODE_CONTINUOUS 0x0000
+#define ADS1115_DR_128SPS 0x0080
+#define ADS1115_DR_860SPS 0x00E0
+#define ADS1115_COMP_DISABLE 0x0003
+#define ADS1115_CONVERSION_TIMEOUT_MS 20
+#define INA219_I2C_ADDR 0x40
+#define INA219_REG_BUSVOLTAGE 0x02
+
+bool adsReadSingleEnded(uint8_t channel, int16_t* out) {
+#if BATTERY_SIM
+    *out = (int16_t)(simSensorMillivolts() / (ads.computeVolts(1) * 1000.0));
+    return true;
+#endif
+    if (!i2cDeviceAvailable(I2C_DEV_ADS1115)) return false;
+    I2CTransaction t(I2C_DEV_ADS1115);
+
+    uint16_t config = ADS1115_OS_SINGLE | (ADS1115_MUX_SINGLE_0 + (channel << 12)) |
+                      ADS1115_PGA_4_096V | ADS1115_MODE_SINGLE |
+                      ADS1115_DR_128SPS | ADS1115_COMP_DISABLE;
+    if (!i2cWriteReg16(I2C_DEV_ADS1115, ADS1115_I2C_ADDR, ADS1115_REG_CONFIG, config)) return false;
+
+    unsigned long start = millis();
+    uint16_t status = 0;
+    while (true) {
+        if (!i2cReadReg16(I2C_DEV_ADS1115, ADS1115_I2C_ADDR, ADS1115_REG_CONFIG, &status)) return false;
+        if (status & ADS1115_OS_SINGLE) break; // conversion finished
+        if (millis() - start > ADS1115_CONVERSION_TIMEOUT_MS) {
+            i2cReportResult(I2C_DEV_ADS1115, false);
+            return false;
+        }
+        delayMicroseconds(500);
+    }
+
+    uint16_t raw;
+    if (!i2cReadReg16(I2C_DEV_ADS1115, ADS1115_I2C_ADDR, ADS1115_REG_CONVERSION, &raw)) return false;
+    *out = (int16_t)raw;
+    return true;
+}
+
+// Burst capture: free-running conversions, read back with adsReadConversion()
+bool adsStartContinuous(uint8_t channel) {
+#if BATTERY_SIM
+    return true;
+#endif
+    if (!i2cDeviceAvailable(I2C_DEV_ADS1115)) return false;
+    I2CTransaction t(I2C_DEV_ADS1115);
+    uint16_t config = (ADS1115_MUX_SINGLE_0 + (channel << 12)) | ADS1115_PGA_4_096V |
+                      ADS1115_MODE_CONTINUOUS | ADS1115_DR_860SPS | ADS1115_COMP_DISABLE;
+    return i2cWriteReg16(I2C_DEV_ADS1115, ADS1115_I2C_ADDR, ADS1115_REG_CONFIG, config);
+}
+
+bool adsReadConversion(int16_t* out) {
+#if BATTERY_SIM
+    *out = (int16_t)(simSensorMillivolts() / (ads.computeVolts(1) * 1000.0));
+    return true;
+#endif
+    I2CTransaction t(I2C_DEV_ADS1115);
+    uint16_t raw;
+    if (!i2cReadReg16(I2C_DEV_ADS1115, ADS1115_I2C_ADDR, ADS1115_REG_CONVERSION, &raw)) return false;
+    *out = (int16_t)raw;
+    return true;
+}
+
+// Bus voltage register >> 3, LSB = 4 mV
+bool inaReadBusRaw(uint16_t* out) {
+#if BATTERY_SIM
+    *out = (uint16_t)(simBusVoltage() / 0.004f);
+    return true;
+#endif
+    if (!i2cDeviceAvailable(I2C_DEV_INA219)) return false;
+    I2CTransaction t(I2C_DEV_INA219);
+    uint16_t raw;
+    if (!i2cReadReg16(I2C_DEV_INA219, INA219_I2C_ADDR, INA219_REG_BUSVOLTAGE, &raw)) return false;
+    *out = raw >> 3;
+    return true;
+}
+
+bool inaReadBusVoltage(float* volts) {
+    uint16_t raw;
+    if (!inaReadBusRaw(&raw)) return false;
+    *volts = raw * 0.004f;
+    return true;
+}
+
+// Re-init hooks run by the I2C arbiter when a quarantined device answers again
+bool reinitINA219() {
+    ina219_present = ina219.begin();
+    if (ina219_present) ina219.setCalibration_32V_2A();
+    return ina219_present;
+}
+
+bool reinitADS1115() {
+    ads1115_present = ads.begin();
+    if (ads1115_present) ads.setGain(GAIN_ONE);
+    return ads1115_present;
+}
+
+bool reinitRTC() {
+    rtc_present = rtc.begin();
+    return rtc_present;
+}
+
+// Fold one boot-time sample block into the zero-current offset
+void refineZeroOffset(float blockMean_mV) {
+    unsigned long elapsed = millis() - zeroRefineStartMs;
+    if (elapsed >= ZERO_SETTLE_MS) {
+        zeroRefineSum_mV += blockMean_mV;
+        zeroRefineBlocks++;
+        zeroOffset_mV = zeroRefineSum_mV / zeroRefineBlocks;
+    }
+    if (elapsed >= ZERO_REFINE_MS) {
+        isSensorStable = true;
+        addSerialLogf_P(PSTR("Zero current offset refined: %.3f mV (%d blocks)"),
+                      zeroOffset_mV, (int)zeroRefineBlocks);
+    }
+}
+
+// One averaged ADC block → current (WCS1600 math + dead zone)
+static void applyCurrentSample(float sensor_mV) {
+    float diff_mV = sensor_mV - zeroOffset_mV;
+    currentCurrent = (diff_mV / WCS1600_SENSITIVITY_mV_PER_A) +
+                    (CORRECTION_VALUE_mA / 1000.0);
+
+    // Dead zone for both charging (+) and discharging (-)
+    if (currentCurrent > -currentDeadzoneThreshold && currentCurrent < currentDeadzoneThreshold) {
+        currentCurrent = 0.0;
+    }
+    filteredCurrent = currentCurrent;
+}
+
+// One bus voltage reading → filtered voltage, power, history, alarms
+static void applyVoltageSample(float rawVoltage, unsigned long now) {
+    float voltageAlpha = 0.3;
+    filteredVoltage = voltageAlpha * rawVoltage + (1.0 - voltageAlpha) * filteredVoltage;
+    currentVoltage = filteredVoltage + voltageOffset;
+
+    // --- Power calculation ---
+    float rawPower = currentVoltage * currentCurrent;
+    float powerAlpha = 0.25;
+    filteredPower = powerAlpha * rawPower + (1.0 - powerAlpha) * filteredPower;
+    currentPower = currentVoltage * currentCurrent;
+    lastSensorUpdate = now;
+
+    // Feed the on-device history (trend graphs)
+    historyAddSample(currentVoltage, filteredCurrent, soc);
+
+    // Threshold alarms and the load profile, every sample (voltage rules pause while the INA219 is down)
+    if (isSensorStable) {
+        alarmsEvaluate(now, ina219_present ? currentVoltage : NAN, filteredCurrent, soc);
+        histogramAddSample(filteredCurrent, soc, now);
+    }
+}
+
+// One raw ADC read → min/max of the open reporting intervals and history bucket
+// (no averaging and no dead zone, so short peaks and sags are kept)
+static void trackRawSample(float sensor_mV, float voltage) {
+    float amps = (sensor_mV - zeroOffset_mV) / WCS1600_SENSITIVITY_mV_PER_A +
+                 (CORRECTION_VALUE_mA / 1000.0);
+    extremesAddSample(voltage, amps);
+    historyAddRawSample(voltage, amps);
+}
+
+// Closed 1-minute history bucket → runtime forecast: learn, then re-project
+static void onHistoryBucketClosed(HistorySpan span, const HistoryBucket& b) {
+    if (span != HIST_SPAN_HOUR || !b.valid) return;
+    DateTime now;
+    if (!batteryNow(&now)) return; // weekday / hour unknown until the clock is set
+    DateTime minuteMid(now.unixtime() - 30); // the bucket covers the minute that just ended
+    forecastAddMinute(minuteMid.dayOfTheWeek(), minuteMid.hour(), b.current_cA / 100.0f);
+    forecastUpdate(now.dayOfTheWeek(), now.hour(), now.minute(), soc, batteryCapacityAh);
+}
+
+// Sampling half of updateSensors(): returns false while the ADC window is still filling
+static bool sampleSensors(unsigned long now) {
+    // Mirror the arbiter's view so a quarantined sensor is skipped
+    ads1115_present = i2cDeviceAvailable(I2C_DEV_ADS1115);
+    ina219_present = i2cDeviceAvailable(I2C_DEV_INA219);
+
+    // --- No current sensor: report 0 A, keep voltage/SOC running ---
+    if (!adcReady && !ads1115_present) {
+        adcSampleSum = 0;
+        adcSampleCount = 0;
+        currentCurrent = 0.0;
+        filteredCurrent = 0.0;
+        adcReady = true;
+    }
 
     // --- Non-blocking ADC sample collection ---
     if (!adcReady) {
-        int16_t adcReading = ads.readADC_SingleEnded(SENSOR_CHANNEL);
+        int16_t adcReading;
+        if (!adsReadSingleEnded(SENSOR_CHANNEL, &adcReading)) {
+            return false; // error counted by the arbiter; retry next pass
+        }
         float mV = ads.computeVolts(adcReading) * 1000.0; // Convert to mV
         adcSampleSum += mV;
         adcSampleCount++;
 
+        // Every raw read, paired with a fresh bus voltage: interval / bucket
+        // extremes and the triggered capture share the one INA219 read
+        bool capturing = triggerActive();
+        if (isSensorStable || capturing) {
+            uint16_t voltageRaw;
+            bool voltageOk = inaReadBusRaw(&voltageRaw);
+            if (isSensorStable) trackRawSample(mV, voltageOk ? voltageRaw * 0.004f + voltageOffset : NAN);
+            if (capturing) {
+                if (!voltageOk) voltageRaw = (uint16_t)(filteredVoltage / 0.004f);
+                triggerAddSample(adcReading, voltageRaw, micros());
+            }
+        }
+
         yield();
 
         if (adcSampleCount >= MEASUREMENT_ITERATIONS) {
@@ -470,37 +716,27 @@ void updateSensors() {
             adcSampleCount = 0;
             adcReady = true;
 
-            // --- Apply WCS1600 accurate math ---
-            float diff_mV = sensor_mV - zeroOffset_mV;
-            currentCurrent = (diff_mV / WCS1600_SENSITIVITY_mV_PER_A) +
-                            (CORRECTION_VALUE_mA / 1000.0);
-
-            // Dead zone for both charging (+) and discharging (-)
-            if (currentCurrent > -currentDeadzoneThreshold && currentCurrent < currentDeadzoneThreshold) {
-                currentCurrent = 0.0;
-            }
-            filteredCurrent = currentCurrent;
+            if (!isSensorStable) refineZeroOffset(sensor_mV);
+            applyCurrentSample(sensor_mV);
         }
-        return; // Wait for enough samples before continuing
+        return false; // Wait for enough samples before continuing
     }
 
     if (now - lastSensorUpdate > sensorUpdateInterval) {
         adcReady = false; // Restart sampling for next cycle
 
         // --- Voltage measurement ---
-        float voltageAlpha = 0.3;
-        float rawVoltage = ina219.getBusVoltage_V();
-        filteredVoltage = voltageAlpha * rawVoltage + (1.0 - voltageAlpha) * filteredVoltage;
-        currentVoltage = filteredVoltage + voltageOffset;
-
-        // --- Power calculation ---
-        float rawPower = currentVoltage * currentCurrent;
-        float powerAlpha = 0.25;
-        filteredPower = powerAlpha * rawPower + (1.0 - powerAlpha) * filteredPower;
-        currentPower = currentVoltage * currentCurrent;
-        lastSensorUpdate = now;
+        float rawVoltage;
+        if (!inaReadBusVoltage(&rawVoltage)) {
+            rawVoltage = filteredVoltage; // hold last value while INA219 is down
+        }
+        applyVoltageSample(rawVoltage, now);
     }
+    return true;
+}
 
+// Integration half of updateSensors(): coulomb counting, energy and idle SOC correction
+static void updateSocAndEnergy(unsigned long now) {
     // --- SOC and energy tracking logic ---
     float dt = (now - lastUpdate) / 1000.0;
     lastUpdate = now;
@@ -537,13 +773,15 @@ void updateSensors() {
 
         soc = newSOC;
         totalCoulombs = (soc / 100.0) * maxC;
-        writeFloat(ADDR_SOC, soc);
+        settingsSave(SETTING_SOC);
 
         // Highlighted log with icon + old→new SOC
-        addSerialLog("⚡ [Hybrid SOC] Recalibration after idle: " 
-                      + String(oldSOC, 2) + "% → " 
-                      + String(newSOC, 2) + "%  (V=" + String(currentVoltage, 3) + ")");
+        addSerialLogf_P(PSTR("⚡ [Hybrid SOC] Recalibration after idle: %.2f%% → %.2f%%  (V=%.3f)"),
+                      oldSOC, newSOC, currentVoltage);
         idleSOCUsed = true;
+#if BATTERY_SIM
+        simCountIdleRecal();
+#endif
         }
       }
     } 
@@ -557,27 +795,108 @@ void updateSensors() {
     }
 }
 
-char lastValidBackupTimeStr[6] = "--:--";  // or "00:00" initially
-void updateBlynkBackupTime() {
-  float remainingCapacityAh = totalCoulombs / 3600.0;
+// ======================= Burst / triggered capture =======================
+// Raw ADS1115 counts and INA219 bus register → amps / volts, for the blob headers
+void fillCaptureScales(CaptureScales* sc) {
+    float mVperCount = ads.computeVolts(1) * 1000.0;
+    sc->currentScale = mVperCount / WCS1600_SENSITIVITY_mV_PER_A;
+    sc->currentOffset = (CORRECTION_VALUE_mA / 1000.0) - zeroOffset_mV / WCS1600_SENSITIVITY_mV_PER_A;
+    sc->voltageScale = 0.004;
+    sc->voltageOffset = voltageOffset;
+}
 
-  if (filteredCurrent < -dischargingCurrentThreshold) {
-    // Actively discharging → calculate live backup time
-    float dischargingCurrent = abs(filteredCurrent);
+// ADS1115 free-running at 860 SPS, read on a micros() schedule (the
+// ALERT/RDY pin is not wired). Blocks the loop for the window; every
+// sensorUpdateInterval the samples so far go through the normal current,
+// voltage and SOC path, so integration carries on from the same data.
+static void runBurstCapture() {
+    STALL_MARK("capture");
+    const uint32_t periodUs = 1000000UL / CAPTURE_SAMPLE_RATE_HZ;
+    const float mVperCount = ads.computeVolts(1) * 1000.0;
+    const uint8_t voltageEvery = captureVoltageEvery();
+
+    captureStart(timeSyncUnixtime());
+    if (!adsStartContinuous(SENSOR_CHANNEL)) {
+        captureAbort();
+        return;
+    }
 
-    // Prevent divide by zero or very small
-    if (dischargingCurrent < 0.05) dischargingCurrent = 0.05;
+    uint16_t voltageRaw = (uint16_t)(filteredVoltage / 0.004f);
+    bool voltageOk = inaReadBusRaw(&voltageRaw);
+    float blockSum_mV = 0;
+    uint16_t blockCount = 0;
+    unsigned long blockStart = batteryMillis();
+
+    uint32_t startUs = micros();
+    uint32_t windowUs = captureWindowMs() * 1000UL;
+    uint32_t nextUs = startUs + periodUs; // first conversion is ready one period in
+    bool readFailed = false;
+    // Window is capped below the stall threshold (captureMaxWindowMs()), so
+    // busy-waiting between conversions never starves WiFi for long
+    for (uint16_t n = 0; micros() - startUs < windowUs; n++) {
+        while ((int32_t)(micros() - nextUs) < 0) { }
+        nextUs += periodUs;
+
+        int16_t raw;
+        if (!adsReadConversion(&raw)) {
+            readFailed = true;
+            break;
+        }
+        if (n % voltageEvery == 0) voltageOk = inaReadBusRaw(&voltageRaw) || voltageOk;
+        if (!captureAdd(raw, voltageRaw)) break; // buffer full
+
+        float mV = raw * mVperCount;
+        if (isSensorStable) trackRawSample(mV, voltageOk ? voltageRaw * 0.004f + voltageOffset : NAN);
+        blockSum_mV += mV;
+        blockCount++;
+        unsigned long now = batteryMillis();
+        if (now - blockStart >= sensorUpdateInterval) {
+            applyCurrentSample(blockSum_mV / blockCount);
+            applyVoltageSample(voltageOk ? voltageRaw * 0.004f : filteredVoltage, now);
+            updateSocAndEnergy(now);
+            blockSum_mV = 0;
+            blockCount = 0;
+            blockStart = now;
+            ESP.wdtFeed(); // no yield(): WiFi work would punch holes in the capture
+        }
+    }
+    if (readFailed) {
+        captureAbort();   // a truncated blob would look like a complete one
+    } else {
+        captureFinish(micros() - startUs);
+    }
 
-    float totalBackupMinutes = (remainingCapacityAh / dischargingCurrent) * 60.0;
-    if (totalBackupMinutes > 5999) totalBackupMinutes = 5999;
+    if (blockCount) {
+        unsigned long now = batteryMillis();
+        applyCurrentSample(blockSum_mV / blockCount);
+        applyVoltageSample(voltageOk ? voltageRaw * 0.004f : filteredVoltage, now);
+        updateSocAndEnergy(now);
+    }
 
-    int hours = floor(totalBackupMinutes / 60);
-    int minutes = floor(fmod(totalBackupMinutes, 60));
+    // Back to single-shot averaging (the next single-shot config stops the free run)
+    adcSampleSum = 0;
+    adcSampleCount = 0;
+    adcReady = false;
+}
 
-    sprintf(lastValidBackupTimeStr, "%02d:%02d", hours, minutes);
-  }
-  // Always send the last known valid backup time
-  Blynk.virtualWrite(V8, lastValidBackupTimeStr);
+void updateSensors() {
+    if (captureRequested()) {
+        runBurstCapture();
+        return;
+    }
+    unsigned long now = batteryMillis();
+    {
+        PERF_SCOPE(PERF_SAMPLING);
+        if (!sampleSensors(now)) return;
+    }
+    PERF_SCOPE(PERF_SOC);
+    updateSocAndEnergy(now);
+}
+
+// V8: forecast time to empty (Forecast.h), "--:--" until there is data
+void updateBlynkBackupTime() {
+  char text[12];
+  Blynk.virtualWrite(V8, forecastFormatRuntime(text, sizeof(text), "--:--"));
 }
 
 void updateBlynkChargingTime() {
@@ -616,16 +935,16 @@ void updateBlynkChargingTime() {
 }
 
 
-// ======================= Format hh:mm:ss string =======================
-String formatTime(unsigned long totalSeconds) {
+// ======================= Format dd:hh:mm:ss string =======================
+// Writes into the caller's buffer (24 bytes is always enough)
+char* formatTime(unsigned long totalSeconds, char* buf, size_t len) {
     unsigned long seconds = totalSeconds % 60;
     unsigned long minutes = (totalSeconds / 60) % 60;
     unsigned long hours = (totalSeconds / 3600) % 24;
     unsigned long days = totalSeconds / 86400;
 
-    char buf[30];
-    sprintf(buf, "%02lud:%02luh:%02lum:%02lus", days, hours, minutes, seconds);
-    return String(buf);
+    snprintf(buf, len, "%02lud:%02luh:%02lum:%02lus", days, hours, minutes, seconds);
+    return buf;
 }
 
 // ======================= Recalibration Functions =======================
@@ -634,14 +953,14 @@ void drawProgressBar(int progress) {
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(0, 0);
-    display.println("Calibration in progress...");
+    display.println(F("Calibration in progress..."));
     int barWidth = map(progress, 0, 100, 0, SCREEN_WIDTH - 4);
     display.drawRoundRect(0, 20, SCREEN_WIDTH - 1, 10, 2, SSD1306_WHITE);
     display.fillRoundRect(2, 22, barWidth, 6, 2, SSD1306_WHITE);
     display.setCursor(50, 40);
     display.print(progress);
-    display.print("%");
-    display.display();
+    display.print(F("%"));
+    i2cFlushDisplayNow();
 }
 
 void showAPRunningScreen(const String& apIP, const char* ssidLabel) {
@@ -649,15 +968,15 @@ void showAPRunningScreen(const String& apIP, const char* ssidLabel) {
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
-  display.println("AP Mode Active");
-  display.println("----------------");
-  display.print("SSID: "); display.println(ssidLabel);
-  display.print("PASS: "); display.println(AP_PASS);
-  display.print("IP:   "); display.println(apIP);
+  display.println(F("AP Mode Active"));
+  display.println(F("----------------"));
+  display.print(F("SSID: ")); display.println(ssidLabel);
+  display.print(F("PASS: ")); display.println(AP_PASS);
+  display.print(F("IP:   ")); display.println(apIP);
   display.println();
-  display.println("Use app at:");
-  display.println("http://<IP>/wifi_config");
-  display.display();
+  display.println(F("Use app at:"));
+  display.println(F("http://<IP>/wifi_config"));
+  i2cFlushDisplayNow();
 }
 
 
@@ -669,7 +988,9 @@ void recalibrateZeroADC() {
 		int32_t adcSum = 0;
 		const int tempSamples = 20;
 		for (int j = 0; j < tempSamples; j++) {
-			adcSum += ads.readADC_SingleEnded(0);
+			int16_t reading = 0;
+			adsReadSingleEnded(0, &reading);
+			adcSum += reading;
 			delayMicroseconds(300);
 		}
 		float avgADC = adcSum / (float)tempSamples;
@@ -684,13 +1005,19 @@ void recalibrateZeroADC() {
     messageDisplayStartTime = millis();
 }
 
-void calibrateVoltageWithKnownSource(float knownVoltage) {
-	float measuredVoltage = ina219.getBusVoltage_V() + voltageOffset;
-	voltageOffset += knownVoltage - measuredVoltage;
-	writeFloat(ADDR_VOLTAGE_OFFSET, voltageOffset);
-    currentMenuState = STATE_MESSAGE;
-    tempMessage = "Voltage calibration updated.";
-    messageDisplayStartTime = millis();
+// Returns false (with tempMessage set to the reason) if nothing was changed
+bool calibrateVoltageWithKnownSource(float knownVoltage) {
+	float busVoltage;
+	if (!inaReadBusVoltage(&busVoltage)) {
+		tempMessage = "INA219 not responding.";
+		return false;
+	}
+	float measuredVoltage = busVoltage + voltageOffset;
+	if (!settingsSet(SETTING_VOLTAGE_OFFSET, voltageOffset + knownVoltage - measuredVoltage)) {
+		tempMessage = "Offset out of range.";
+		return false;
+	}
+	return true;
 }
 
 // ======================= Statistics Functions =======================
@@ -707,50 +1034,40 @@ void resetStatistics() {
 }
 
 // ======================= Save/Load/Reset Calibration =======================
+const SettingId calibrationSettings[] = {
+  SETTING_VOLTAGE_OFFSET, SETTING_CURRENT_OFFSET, SETTING_MV_PER_AMP,
+  SETTING_CHARGE_THRESHOLD, SETTING_DISCHARGE_THRESHOLD
+};
+
 void saveCalibration() {
 	writeFloat(ADDR_ZERO_ADC, ZERO_CURRENT_ADC);
-	writeFloat(ADDR_VOLTAGE_OFFSET, voltageOffset);
-	writeFloat(ADDR_CURRENT_OFFSET, currentOffset);
-	writeFloat(ADDR_MV_PER_AMP, mVperAmp);
+	for (SettingId id : calibrationSettings) settingsSave(id);
 	writeInt(ADDR_CALIBRATION_SAVED, 1);
-	writeFloat(ADDR_CHARGING_THRESHOLD, chargingCurrentThreshold);
-  writeFloat(ADDR_DISCHARGING_THRESHOLD, dischargingCurrentThreshold);
     currentMenuState = STATE_MESSAGE;
     tempMessage = "Calibration Saved.";
     messageDisplayStartTime = millis();
 }
 
 void loadCalibration() {
+	if (!i2cDeviceAvailable(I2C_DEV_EEPROM)) {
+		// Reads would come back erased and replace the live values with defaults
+		currentMenuState = STATE_MESSAGE;
+		tempMessage = "EEPROM not responding.";
+		messageDisplayStartTime = millis();
+		return;
+	}
 	readFloat(ADDR_ZERO_ADC, &ZERO_CURRENT_ADC);
-	voltageOffset = readFloat(ADDR_VOLTAGE_OFFSET);
-	currentOffset = readFloat(ADDR_CURRENT_OFFSET);
-	mVperAmp = readFloat(ADDR_MV_PER_AMP);
+	for (SettingId id : calibrationSettings) settingsLoad(id); // invalid → default
     currentMenuState = STATE_MESSAGE;
     tempMessage = "Calibration Loaded.";
     messageDisplayStartTime = millis();
-		chargingCurrentThreshold = readFloat(ADDR_CHARGING_THRESHOLD);
-		dischargingCurrentThreshold = readFloat(ADDR_DISCHARGING_THRESHOLD);
-
-		if (chargingCurrentThreshold <= 0.0 || chargingCurrentThreshold > 10.0)
-			chargingCurrentThreshold = 0.6;
-
-		if (dischargingCurrentThreshold <= 0.0 || dischargingCurrentThreshold > 10.0)
-			dischargingCurrentThreshold = 1.0;
 }
 
 void resetCalibrationDefaults() {
   ZERO_CURRENT_ADC = -1;
-  voltageOffset = 0.0;
-  currentOffset = 0.0;
-  mVperAmp = 22;
 
-  // ✅ Reset charging/discharging thresholds to defaults
-  chargingCurrentThreshold = 0.6;
-  dischargingCurrentThreshold = 1.0;
-
-  // ✅ Save them to EEPROM
-  writeFloat(ADDR_CHARGING_THRESHOLD, chargingCurrentThreshold);
-  writeFloat(ADDR_DISCHARGING_THRESHOLD, dischargingCurrentThreshold);
+  // ✅ Offsets, mV/A and charge/discharge thresholds back to their table defaults (saved)
+  for (SettingId id : calibrationSettings) settingsResetToDefault(id);
 
   writeInt(ADDR_CALIBRATION_SAVED, 0);
   currentMenuState = STATE_MESSAGE;
@@ -765,24 +1082,33 @@ void drawMainScreen() {
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
-  display.print("Voltage V: "); display.print(currentVoltage, 2); display.print(" V");
-  display.setCursor(0, 12); display.print("Current I: "); display.print(filteredCurrent, 2); display.print(" A");
-  display.setCursor(0, 24); display.print("SoC: ");
+  display.print(F("Voltage V: ")); display.print(currentVoltage, 2); display.print(F(" V"));
+  display.setCursor(0, 12); display.print(F("Current I: ")); display.print(filteredCurrent, 2); display.print(F(" A"));
+  display.setCursor(0, 24); display.print(F("SoC: "));
   display.print(soc, 1);
-  display.print(" %");
-  display.setCursor(0, 36); display.print("Power: "); display.print(currentPower, 2); display.print(" W");
-  display.setCursor(0, 48); display.print("Status: ");
+  display.print(F(" %"));
+  display.setCursor(0, 36); display.print(F("Power: ")); display.print(currentPower, 2); display.print(F(" W"));
+  display.setCursor(0, 48); display.print(F("Status: "));
   if (filteredCurrent > chargingCurrentThreshold) {
-  display.print("Charging");
+  display.print(F("Charging"));
 	} else if (filteredCurrent < -dischargingCurrentThreshold) {
-		display.print("Discharging");
+		display.print(F("Discharging"));
 	} else {
-		display.print("Idle");
+		display.print(F("Idle"));
 	}
-  display.display();
+  uint32_t alarms = alarmsActiveMask();
+  if (alarms) { // first active alarm on the bottom row
+    uint8_t id = 0;
+    while (!(alarms & (1UL << id))) id++;
+    display.setCursor(0, 56);
+    display.print(F("! "));
+    display.print(alarmName((AlarmId)id));
+  }
+  i2cRequestDisplayFlush();
 }
 
-void drawMenu(const char* title, const char** items, int numItems, int selected, int offset) {
+void drawMenu(const __FlashStringHelper* title, const StringTable& items, int selected, int offset) {
+	int numItems = items.count;
 	display.clearDisplay();
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
@@ -809,7 +1135,7 @@ void drawMenu(const char* title, const char** items, int numItems, int selected,
 			display.setTextColor(SSD1306_WHITE);
 		}
 		display.setCursor(4, yPos);
-		display.print(items[itemIndex]);
+		display.print(strTableItem(items, itemIndex));
 	}
 
 	if (numItems > visibleMenuItems) {
@@ -820,10 +1146,10 @@ void drawMenu(const char* title, const char** items, int numItems, int selected,
 		int thumbY = 16 + (int)round((float)offset / (numItems - visibleMenuItems) * (scrollbarHeight - thumbHeight));
 		display.fillRect(scrollbarX, thumbY, 3, thumbHeight, SSD1306_WHITE);
 	}
-	display.display();
+	i2cRequestDisplayFlush();
 }
 
-void drawValueScreen(const char* title, float value, int precision, float step) {
+void drawValueScreen(const __FlashStringHelper* title, float value, int precision, float step, const __FlashStringHelper* units) {
 	display.clearDisplay();
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
@@ -838,17 +1164,19 @@ void drawValueScreen(const char* title, float value, int precision, float step)
 	display.setTextSize(2);
 	display.setCursor(0, 32);
 	display.print(value, precision);
-
 	display.setTextSize(1);
+	display.print(F(" "));
+	display.print(units);
+
 	display.setCursor(0, 50);
-	display.print("Step: ");
+	display.print(F("Step: "));
 	display.print(step, precision);
 	display.setCursor(100, 50);
-	display.print("OK");
-	display.display();
+	display.print(F("OK"));
+	i2cRequestDisplayFlush();
 }
 
-void drawMessageScreen(const char* title, const char* message) {
+void drawMessageScreen(const __FlashStringHelper* title, const char* message) {
 	display.clearDisplay();
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
@@ -861,7 +1189,64 @@ void drawMessageScreen(const char* title, const char* message) {
 	display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
 	display.setCursor(0, 20);
 	display.println(message);
-	display.display();
+	i2cRequestDisplayFlush();
+}
+
+// ======================= Settings editor =======================
+// One editor for every SETTINGS_TABLE row: label, units, step, range and
+// decimals come from the table; enumerated rows show their choice list.
+void beginSettingEdit(SettingId id, SettingId next) {
+	editSetting = id;
+	editNextSetting = next;
+	tempFloatValue = settingsGet(id);
+	currentMenuState = STATE_EDIT_SETTING;
+}
+
+void drawSettingEditor() {
+	SettingDef d = settingsDef(editSetting);
+	const StringTable* choices = settingsChoices(editSetting);
+	if (choices) {
+		drawMenu(FPSTR(d.label), *choices, (int)tempFloatValue, 0);
+	} else {
+		drawValueScreen(FPSTR(d.label), tempFloatValue, d.decimals, d.step, FPSTR(d.units));
+	}
+}
+
+void processSettingEditor() {
+	SettingDef d = settingsDef(editSetting);
+	float lo = settingsMinFor(editSetting);
+	// Choice lists scroll like menus: UP moves to the previous entry
+	float up = settingsChoices(editSetting) ? -d.step : d.step;
+
+	if (buttonUpPressed) {
+		tempFloatValue = constrain(tempFloatValue + up, lo, d.maxValue);
+		lastButtonPressTime = millis();
+	}
+	if (buttonDownPressed) {
+		tempFloatValue = constrain(tempFloatValue - up, lo, d.maxValue);
+		lastButtonPressTime = millis();
+	}
+	if (buttonSelectPressed) {
+		settingsSet(editSetting, tempFloatValue);
+		if (editNextSetting != SETTING_NONE) {
+			beginSettingEdit(editNextSetting, SETTING_NONE);
+		} else {
+			popHistory();
+			strncpy_P(settingMessage, d.label, sizeof(settingMessage) - 8);
+			settingMessage[sizeof(settingMessage) - 8] = '\0';
+			strcat_P(settingMessage, PSTR(" saved."));
+			currentMenuState = STATE_MESSAGE;
+			tempMessage = settingMessage;
+			messageDisplayStartTime = millis();
+		}
+		lastButtonPressTime = millis();
+	}
+	if (buttonBackPressed) {
+		popHistory();
+		currentMenuState = menuHistory[historyIndex].state;
+		selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
+		lastButtonPressTime = millis();
+	}
 }
 
 void drawSystemInfoScreen() {
@@ -869,24 +1254,24 @@ void drawSystemInfoScreen() {
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
 	display.setCursor(0, 0);
-	display.println("System Info");
+	display.println(F("System Info"));
 	display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
 	display.setCursor(0, 16);
-	display.print("Firmware: ");
+	display.print(F("Firmware: "));
 	display.println(FIRMWARE_VERSION);
 
 	display.setCursor(0, 28);
-	display.print("INA219: ");
-	display.println(ina219_present ? "OK" : "ERR");
+	display.print(F("INA219: "));
+	display.println(i2cDeviceAvailable(I2C_DEV_INA219) ? "OK" : "ERR");
 	display.setCursor(0, 40);
-	display.print("ADS1115: ");
-	display.println(ads1115_present ? "OK" : "ERR");
+	display.print(F("ADS1115: "));
+	display.println(i2cDeviceAvailable(I2C_DEV_ADS1115) ? "OK" : "ERR");
 	
 	display.setCursor(0, 52);
-	display.print("RTC: ");
-	display.println(rtc_present ? "OK" : "ERR");
+	display.print(F("RTC: "));
+	display.println(i2cDeviceAvailable(I2C_DEV_RTC) ? "OK" : "ERR");
 
-	display.display();
+	i2cRequestDisplayFlush();
 }
 
 void drawMemoryUsageScreen() {
@@ -894,26 +1279,52 @@ void drawMemoryUsageScreen() {
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
 	display.setCursor(0, 0);
-	display.println("Memory Usage");
+	display.println(F("Memory Usage"));
 	display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
+
+	heapMonitorSample();
+	const HeapStats& heap = heapStats();
+	char line[24];
+	snprintf(line, sizeof(line), "Free:  %lu B", (unsigned long)heap.freeBytes);
 	display.setCursor(0, 16);
+	display.print(line);
+	snprintf(line, sizeof(line), "Block: %lu B", (unsigned long)heap.maxBlock);
+	display.setCursor(0, 26);
+	display.print(line);
+	snprintf(line, sizeof(line), "Frag:  %u%% (max %u%%)", heap.fragPct, heap.maxFragPct);
+	display.setCursor(0, 36);
+	display.print(line);
+	snprintf(line, sizeof(line), "Min free: %lu B", (unsigned long)heap.minFreeBytes);
+	display.setCursor(0, 46);
+	display.print(line);
+
+	i2cRequestDisplayFlush();
+}
 
-	uint32_t freeHeap = ESP.getFreeHeap();
-	if (freeHeap < 1024) {
-		display.print("Free RAM: ");
-		display.print(freeHeap);
-		display.println(" B");
-	} else if (freeHeap < 1024 * 1024) {
-		display.print("Free RAM: ");
-		display.print(freeHeap / 1024.0, 2);
-		display.println(" KB");
-	} else {
-		display.print("Free RAM: ");
-		display.print(freeHeap / 1024.0 / 1024.0, 2);
-		display.println(" MB");
+// Profiler summary: p99 and worst case per subsystem, UP/DOWN to scroll
+const int PERF_ROWS_VISIBLE = 5;
+int perfScrollOffset = 0;
+
+void drawPerfScreen() {
+	display.clearDisplay();
+	display.setTextSize(1);
+	display.setTextColor(SSD1306_WHITE);
+	display.setCursor(0, 0);
+	display.println(F("Latency p99/max us"));
+	display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
+
+	char line[24];
+	for (int row = 0; row < PERF_ROWS_VISIBLE; row++) {
+		int i = perfScrollOffset + row;
+		if (i >= PERF_PROBE_COUNT) break;
+		PerfProbe p = (PerfProbe)i;
+		snprintf(line, sizeof(line), "%-8s%6lu %6lu", perfProbeName(p),
+		         (unsigned long)perfPercentileUs(p, 99), (unsigned long)perfStats(p).maxUs);
+		display.setCursor(0, 16 + row * 9);
+		display.print(line);
 	}
 
-	display.display();
+	i2cRequestDisplayFlush();
 }
 
 void drawUptimeScreen() {
@@ -921,18 +1332,19 @@ void drawUptimeScreen() {
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
 	display.setCursor(0, 0);
-	display.println("Uptime");
+	display.println(F("Uptime"));
 	display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
 	display.setCursor(0, 20);
-	display.println(formatTime(uptimeSeconds));
-	display.display();
+	char uptimeStr[24];
+	display.println(formatTime(uptimeSeconds, uptimeStr, sizeof(uptimeStr)));
+	i2cRequestDisplayFlush();
 }
 
 void drawAboutScreen() {
   display.clearDisplay();
 
   // Title: About (centered at top)
-  const char* heading = "About";
+  const __FlashStringHelper* heading = F("About");
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   int16_t x1, y1;
@@ -946,24 +1358,25 @@ void drawAboutScreen() {
 
   // Line 1: "Smart Battery"
   display.setTextSize(1);
-  display.getTextBounds("Smart Battery", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("Smart Battery"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 24);
-  display.println("Smart Battery");
+  display.println(F("Smart Battery"));
 
   // Line 2: "Monitor"
-  display.getTextBounds("Monitor", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("Monitor"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 36);
-  display.println("Monitor");
+  display.println(F("Monitor"));
 
   // Line 3: "By Akshit Singh"
-  display.getTextBounds("By Akshit Singh", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("By Akshit Singh"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 52);
-  display.println("By Akshit Singh");
+  display.println(F("By Akshit Singh"));
 
-  display.display();
+  i2cRequestDisplayFlush();
 }
 
 void drawQRCodeScreen() {
+  STALL_MARK("qr_screen"); // waits up to 15 s for a button
   display.clearDisplay();
 
   const char* githubUrl = "github.com/akshit-singhh";
@@ -987,7 +1400,7 @@ void drawQRCodeScreen() {
     }
   }
 
-  display.display();
+  i2cFlushDisplayNow();
 
   // Wait up to 15 seconds or exit on BACK or SELECT button press
   // Wait until buttons are released BEFORE starting timeout
@@ -1008,7 +1421,8 @@ while (millis() - startTime < 15000) {
 }
 
 void checkAndResetDailyEnergy() {
-  DateTime now = rtc.now();
+  DateTime now;
+  if (!batteryNow(&now)) return;
   int currentDay = now.day();
 
   if (lastRecordedDay == -1) {
@@ -1019,8 +1433,12 @@ void checkAndResetDailyEnergy() {
     totalEnergyInWh = 0.0;
     totalEnergyOutWh = 0.0;
     lastRecordedDay = currentDay;
+    histogramSave(now.unixtime());  // once a day, changed bins only
 
-    Serial.println("✅ Energy stats reset for new day.");
+    Serial.println(F("✅ Energy stats reset for new day."));
+#if BATTERY_SIM
+    simCountDailyReset();
+#endif
   }
 }
 
@@ -1029,32 +1447,29 @@ void drawRuntimeHistoryScreen() {
 	display.setTextSize(1);
 	display.setTextColor(SSD1306_WHITE);
 	display.setCursor(0, 0);
-	display.println("Runtime History");
+	display.println(F("Runtime History"));
 	display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
 	for (int i = 0; i < 4; i++) {
 		int logIndex = (eventLogIndex + MAX_LOGS - 1 - logViewOffset - i + MAX_LOGS) % MAX_LOGS;
 		uint16_t addr = EVENT_LOG_START_ADDR + logIndex * LOG_ENTRY_SIZE;
-		Wire.beginTransmission(EEPROM_ADDR);
-		Wire.write((uint8_t)(addr >> 8));
-		Wire.write((uint8_t)(addr & 0xFF));
-		Wire.endTransmission();
-		Wire.requestFrom(EEPROM_ADDR, LOG_ENTRY_SIZE);
-		if (Wire.available() < 5) continue;
-		uint8_t type = Wire.read();
+		uint8_t entry[LOG_ENTRY_SIZE];
+		readBytes(addr, entry, LOG_ENTRY_SIZE);
+		uint8_t type = entry[0];
 		uint32_t timestamp = 0;
-		for (int j = 0; j < 4; j++) {
-			timestamp = (timestamp << 8) | Wire.read();
+		for (int j = 1; j < LOG_ENTRY_SIZE; j++) {
+			timestamp = (timestamp << 8) | entry[j];
 		}
 		DateTime dt(timestamp);
 		char timeStr[10];
 		sprintf(timeStr, "[%02d:%02d]", dt.hour(), dt.minute());
-		String msg;
+		const char* msg;
 		switch (type) {
 			case EVENT_SOC_FULL: msg = "SOC: 100%"; break;
 			case EVENT_SOC_LOW: msg = "SOC <=40%"; break;
 			case EVENT_VOLTAGE_HIGH: msg = "Volt High"; break;
 			case EVENT_VOLTAGE_LOW: msg = "Volt Low";
 			break;
+			case EVENT_VOLTAGE_SAG: msg = "Volt Sag"; break;
 			case EVENT_START_CHARGING: msg = "Charging start"; break;
 			case EVENT_START_DISCHARGING: msg = "Discharging start"; break;
 			case EVENT_IDLE: msg = "Idle start"; break;
@@ -1062,21 +1477,96 @@ void drawRuntimeHistoryScreen() {
 		}
 		display.setCursor(0, 16 + i * 12);
 		display.print(timeStr);
-		display.print(" ");
+		display.print(F(" "));
 		display.println(msg);
 	}
-	display.display();
+	i2cRequestDisplayFlush();
+}
+
+// Trend graph: UP/DOWN = metric, SELECT = span (1h / 24h / 7d)
+// Columns come precomputed from History.cpp; this only blits them.
+void drawTrendScreen(HistoryMetric metric, HistorySpan span) {
+	const int plotTop = 13;
+	const int colWidth = 2;
+
+	display.clearDisplay();
+	display.setTextSize(1);
+	display.setTextColor(SSD1306_WHITE);
+	display.setCursor(0, 0);
+	display.print(historyMetricLabel(metric));
+	display.print(F(" "));
+	display.print(historySpanLabel(span));
+
+	const TrendGraph& g = historyGraph(span, metric);
+	const HistoryBucket* latest = historyBucketAt(span, 0);
+	display.setCursor(80, 0);
+	if (latest) {
+		display.print(historyBucketValue(*latest, metric), metric == HIST_METRIC_SOC ? 0 : 1);
+	} else {
+		display.print(F("--"));
+	}
+	display.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
+
+	int size = historySpanSize(span);
+	int count = historyBucketCount(span);
+	int head = historyRingHead(span);
+	int baseY = plotTop + HISTORY_GRAPH_HEIGHT - 1;
+	bool signedMetric = (metric == HIST_METRIC_CURRENT || metric == HIST_METRIC_ENERGY);
+	bool barGraph = (metric == HIST_METRIC_ENERGY);
+	bool whiskers = (metric == HIST_METRIC_VOLTAGE || metric == HIST_METRIC_CURRENT);
+
+	if (signedMetric) {
+		int zeroY = baseY - g.zeroRow;
+		for (int x = 0; x < size * colWidth; x += 4) display.drawPixel(x, zeroY, SSD1306_WHITE);
+	}
+
+	int prevX = -1, prevY = -1;
+	for (int k = 0; k < count; k++) {
+		int slot = (head + size - count + k) % size;
+		uint8_t row = g.col[slot];
+		int x = (size - count + k) * colWidth;
+		if (row == HISTORY_COLUMN_EMPTY) {
+			prevX = -1;
+			continue;
+		}
+		int y = baseY - row;
+		if (whiskers) { // bucket min..max behind the average line
+			Extremes e = historyBucketExtremes(*historyBucketAt(span, count - 1 - k));
+			const MinMax& m = (metric == HIST_METRIC_VOLTAGE) ? e.voltage : e.current;
+			if (extremesValid(m)) {
+				uint8_t hi = historyGraphRow(g, m.hi);
+				display.drawFastVLine(x, baseY - hi, hi - historyGraphRow(g, m.lo) + 1, SSD1306_WHITE);
+			}
+		}
+		if (barGraph) {
+			int zeroY = baseY - g.zeroRow;
+			int top = min(y, zeroY);
+			display.fillRect(x, top, colWidth - 1, abs(y - zeroY) + 1, SSD1306_WHITE);
+		} else if (prevX >= 0) {
+			display.drawLine(prevX, prevY, x, y, SSD1306_WHITE);
+		} else {
+			display.drawPixel(x, y, SSD1306_WHITE);
+		}
+		prevX = x;
+		prevY = y;
+	}
+
+	if (count == 0) {
+		display.setCursor(16, 32);
+		display.print(F("Collecting data..."));
+	}
+	i2cRequestDisplayFlush();
 }
 
 void drawAPModeMenu() {
-    drawMenu("AP Mode Menu", apModeMenuOptions, apModeMenuCount, selectedMenuIndex, menuScrollOffset);
+    drawMenu(F("AP Mode Menu"), apModeMenuOptions, selectedMenuIndex, menuScrollOffset);
 }
 
 
 void drawScreenSaver() {
 	display.clearDisplay();
 	display.drawCircle(saverX, saverY, 5, SSD1306_WHITE);
-	display.display();
+	i2cRequestDisplayFlush();
 	saverX += saverDX;
 	saverY += saverDY;
 	if (saverX >= SCREEN_WIDTH - 5 || saverX <= 5) {
@@ -1087,78 +1577,28 @@ void drawScreenSaver() {
 	}
 }
 //Boot ProgressBar
-void showBootProgressBar() {
-  unsigned long startMillis = millis();
-  unsigned long duration = 2000;
-  int step = 0;
-
-  while (millis() - startMillis < duration) {
-    int progress = map(millis() - startMillis, 0, duration, 0, 100);
-
-    // Gradual background loading
-    if (step == 0 && millis() - startMillis > 100) {
-      readFloat(ADDR_BATTERY_CAPACITY, &batteryCapacityAh);
-      step++;
-    } else if (step == 1 && millis() - startMillis > 300) {
-      minVoltageThreshold = readFloat(ADDR_VOLTAGE_THRESHOLD_MIN);
-      maxVoltageThreshold = readFloat(ADDR_VOLTAGE_THRESHOLD_MAX);
-      step++;
-    } else if (step == 2 && millis() - startMillis > 500) {
-      readInt(ADDR_SCREEN_TIMEOUT, &screenTimeout);
-      readInt(ADDR_STATS_CYCLE_COUNT, &cycleCount);
-      step++;
-    } else if (step == 3 && millis() - startMillis > 800) {
-      totalEnergyInWh = readFloat(ADDR_STATS_TOTAL_ENERGY_IN);
-      totalEnergyOutWh = readFloat(ADDR_STATS_TOTAL_ENERGY_OUT);
-      step++;
-    } else if (step == 4 && millis() - startMillis > 1100) {
-      chargingSeconds = readInt(ADDR_CHARGING_SECONDS);
-      dischargingSeconds = readInt(ADDR_DISCHARGING_SECONDS);
-      idleSeconds = readInt(ADDR_IDLE_SECONDS);
-      step++;
-    } else if (step == 2 && millis() - startMillis > 500) {
-    readInt(ADDR_SCREEN_TIMEOUT, &screenTimeout);
-    readInt(ADDR_STATS_CYCLE_COUNT, &cycleCount);
-    readFloat(ADDR_CURRENT_DEADZONE, &currentDeadzoneThreshold); // ← new
-    step++;
-    }else if (step == 5 && millis() - startMillis > 1400) {
+// All persisted settings in one pass (a few ms on the AT24C32)
+void loadSettingsFromEEPROM() {
+  settingsLoadAll(); // every SETTINGS_TABLE row, out-of-range → default
+  readInt(ADDR_STATS_CYCLE_COUNT, &cycleCount);
+  readFloat(ADDR_STATS_TOTAL_ENERGY_IN, &totalEnergyInWh);
+  readFloat(ADDR_STATS_TOTAL_ENERGY_OUT, &totalEnergyOutWh);
+  readInt(ADDR_CHARGING_SECONDS, &chargingSeconds);
+  readInt(ADDR_DISCHARGING_SECONDS, &dischargingSeconds);
+  readInt(ADDR_IDLE_SECONDS, &idleSeconds);
+
   if (readInt(ADDR_CALIBRATION_SAVED) == 1) {
-    loadCalibration();
+    readFloat(ADDR_ZERO_ADC, &ZERO_CURRENT_ADC);
   }
-  step++;
-} else if (step == 6 && millis() - startMillis > 1700) {
+
   uint32_t socFlag;
-readInt(ADDR_SOC_SAVED_FLAG, &socFlag);
-if (socFlag == 1) {
-    readFloat(ADDR_SOC, &soc);
-    totalCoulombs = readFloat(ADDR_COULOMBS);  // ← Restores totalCoulombs too
-  } else {
+  readInt(ADDR_SOC_SAVED_FLAG, &socFlag);
+  if (socFlag != 1) {
     soc = 100.0;
-    totalCoulombs = batteryCapacityAh * 3600.0;
-    writeFloat(ADDR_SOC, soc);
-    writeFloat(ADDR_COULOMBS, totalCoulombs);  // ← Initializes if first boot
+    settingsSave(SETTING_SOC);
     writeInt(ADDR_SOC_SAVED_FLAG, 1);
   }
-  step++;
-}
-    // Draw boot progress bar
-    int barWidth = map(progress, 0, 100, 0, SCREEN_WIDTH - 4);
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(30, 0);
-    display.println("Booting...");
-
-    display.drawRoundRect(0, 20, SCREEN_WIDTH - 1, 10, 3, SSD1306_WHITE);
-    display.fillRoundRect(2, 22, barWidth, 6, 3, SSD1306_WHITE);
-
-    display.setCursor(50, 40);
-    display.print(progress);
-    display.print("%");
-    display.display();
-
-    delay(10);  // smooth animation
-  }
+  totalCoulombs = (soc / 100.0) * batteryCapacityAh * 3600.0;
 }
 
 void showWelcomeScreen() {
@@ -1173,75 +1613,95 @@ void showWelcomeScreen() {
   display.setTextSize(1);
   int16_t x1, y1;
   uint16_t w, h;
-  display.getTextBounds("Welcome to", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("Welcome to"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 8);
-  display.println("Welcome to");
+  display.println(F("Welcome to"));
 
   // Line 2: "Smart Battery"
   display.setTextSize(1);
-  display.getTextBounds("Smart Battery", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("Smart Battery"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 24);
-  display.println("Smart Battery");
+  display.println(F("Smart Battery"));
 
   // Line 3: "Monitor"
-  display.getTextBounds("Monitor", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("Monitor"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 36);
-  display.println("Monitor");
+  display.println(F("Monitor"));
 
   // Line 4: "By Akshit Singh"
   display.setTextSize(1);
-  display.getTextBounds("By Akshit Singh", 0, 0, &x1, &y1, &w, &h);
+  display.getTextBounds(F("By Akshit Singh"), 0, 0, &x1, &y1, &w, &h);
   display.setCursor((SCREEN_WIDTH - w) / 2, 52);
-  display.println("By Akshit Singh");
+  display.println(F("By Akshit Singh"));
 
-  display.display();
-  delay(3000);
+  // Stays up until loop() starts drawing (see bootSplashUntilMs)
+  i2cFlushDisplayNow();
 }
 
 void saveSocToEEPROM() {
-  writeFloat(ADDR_SOC, soc);
+  settingsSave(SETTING_SOC);
   writeFloat(ADDR_COULOMBS, totalCoulombs);  // ← Save together
-  Serial.print("Saved SOC: ");
+  Serial.print(F("Saved SOC: "));
   Serial.print(soc);
-  Serial.print(" | Coulombs: ");
+  Serial.print(F(" | Coulombs: "));
   Serial.println(totalCoulombs);
 }
 
 void saveEnergyStatsToEEPROM() {
   writeFloat(ADDR_STATS_TOTAL_ENERGY_IN, totalEnergyInWh);
   writeFloat(ADDR_STATS_TOTAL_ENERGY_OUT, totalEnergyOutWh);
-  Serial.println("Energy stats saved to EEPROM.");
+  Serial.println(F("Energy stats saved to EEPROM."));
 }
-String getTimeUntilMidnight() {
-  DateTime now = rtc.now();
+// hh:mm:ss until the daily energy reset, written into buf (9+ bytes)
+char* getTimeUntilMidnight(char* buf, size_t len) {
+  DateTime now;
+  if (!batteryNow(&now)) {
+    snprintf(buf, len, "--:--:--");
+    return buf;
+  }
   int secondsLeft = (23 - now.hour()) * 3600 + (59 - now.minute()) * 60 + (60 - now.second());
 
   int hours = secondsLeft / 3600;
   int minutes = (secondsLeft % 3600) / 60;
   int seconds = secondsLeft % 60;
 
-  char buffer[16];
-  sprintf(buffer, "%02d:%02d:%02d", hours, minutes, seconds);
-  return String(buffer);
+  snprintf(buf, len, "%02d:%02d:%02d", hours, minutes, seconds);
+  return buf;
 }
 
-void startAPMode() {
+// Setup AP + /wifi_config routes; returns the AP's IP
+static String startSetupAccessPoint() {
   WiFi.mode(WIFI_AP);
   WiFi.softAP(AP_SSID, AP_PASS);
   String apIP = WiFi.softAPIP().toString();
 
-  Serial.println("AP Mode started");
-  Serial.print("SSID: "); Serial.println(AP_SSID);
-  Serial.print("Password: "); Serial.println(AP_PASS);
-  Serial.print("IP Address: "); Serial.println(apIP);
-
-  addSerialLog("Access Point started. SSID: " + String(AP_SSID) +
-               ", PASS: " + String(AP_PASS) +
-               ", IP: " + apIP);
-
   // ✅ Make sure /wifi_config and other AP routes are available
   setupServerRoutes_AP(apIP, AP_SSID, AP_PASS);
   server.begin();
+  return apIP;
+}
+
+// Fallback after a failed join (runs in the network task): start the setup
+// AP and return, so sampling and coulomb counting keep going. A saved
+// /wifi_config reboots into STA as usual.
+void startAPFallback() {
+  String apIP = startSetupAccessPoint();
+  addSerialLogf_P(PSTR("Access Point started (background). SSID: %s, PASS: %s, IP: %s"),
+                  AP_SSID, AP_PASS, apIP.c_str());
+}
+
+// Modal first-boot setup (setup() only, no credentials yet)
+void startAPMode() {
+  STALL_MARK("start_ap");
+  String apIP = startSetupAccessPoint();
+
+  Serial.println(F("AP Mode started"));
+  Serial.print(F("SSID: ")); Serial.println(AP_SSID);
+  Serial.print(F("Password: ")); Serial.println(AP_PASS);
+  Serial.print(F("IP Address: ")); Serial.println(apIP);
+
+  addSerialLogf_P(PSTR("Access Point started. SSID: %s, PASS: %s, IP: %s"),
+                  AP_SSID, AP_PASS, apIP.c_str());
 
   unsigned long lastMenuUpdate = 0;
   int apMenuIndex = 0; // now 0=AP Details, 1=QR Code, 2=Skip setup
@@ -1275,7 +1735,7 @@ void startAPMode() {
         wifiSetupSkipped = true; // set global flag
         WiFi.softAPdisconnect(true);
         WiFi.mode(WIFI_OFF);
-        addSerialLog("User skipped WiFi setup. Running offline.");
+        addSerialLog(F("User skipped WiFi setup. Running offline."));
         return; // Exit AP mode and return to normal run
       }
       delay(200);
@@ -1291,14 +1751,14 @@ void showAPStatusScreen(const String &title, const String &ssid, const String &p
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
   display.println(title);
-  display.println("----------------");
-  display.print("SSID: ");
+  display.println(F("----------------"));
+  display.print(F("SSID: "));
   display.println(ssid);
-  display.print("PASS: ");
+  display.print(F("PASS: "));
   display.println(pass);
-  display.print("IP: ");
+  display.print(F("IP: "));
   display.println(ip);
-  display.display();
+  i2cFlushDisplayNow();
 
   // Wait until user presses BACK
   while (true) {
@@ -1319,78 +1779,118 @@ void showAPStatusScreen(const String &title, const String &ssid, const String &p
 #define AP_SSID_MENU   "Battery Monitor AP"  // NEW: distinguish from first boot AP
 
 
-void connectWiFi() {
-  loadWiFiCredentials(); // Loads savedSsid and savedPass
+// ======================= Alarms =======================
+// Runs inside the sampler: EEPROM event and log line are queued, the
+// OLED picks the alarm up on its next frame, Blynk on the next blynk pass.
+bool blynkAlarmPending = false;
+
+void onAlarm(AlarmId id, bool active) {
+  char name[16];
+  strncpy_P(name, (PGM_P)alarmName(id), sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+
+  if (active) {
+    switch (id) {
+      case ALARM_VOLTAGE_LOW:  logEvent(EVENT_VOLTAGE_LOW); break;
+      case ALARM_VOLTAGE_HIGH: logEvent(EVENT_VOLTAGE_HIGH); break;
+      case ALARM_VOLTAGE_SAG:  logEvent(EVENT_VOLTAGE_SAG); break;
+      case ALARM_SOC_LOW:      logEvent(EVENT_SOC_LOW); break;
+      case ALARM_SOC_FULL:     logEvent(EVENT_SOC_FULL); break;
+      default: break;
+    }
+    addSerialLogf_P(PSTR("🚨 Alarm: %s (V=%.2f I=%.2f SOC=%.1f)"), name, currentVoltage, filteredCurrent, soc);
 
-  if (strlen(savedSsid) == 0 || strlen(savedPass) == 0) {
-    if (wifiSetupSkipped) {
-      Serial.println("WiFi setup skipped. Running offline.");
-      addSerialLog("WiFi setup skipped. Running offline.");
-      WiFi.mode(WIFI_OFF);
-      internetConnected = false;
-      return;
-    } else {
-      Serial.println("No WiFi credentials. Starting AP mode.");
-      addSerialLog("No WiFi credentials. Starting AP mode.");
-      startAPMode();
-      internetConnected = false;
-      return;
+    // Wake the screen on the main display so the alarm is seen
+    if (!screenIsOn) {
+      screenIsOn = true;
+      display.ssd1306_command(SSD1306_DISPLAYON);
+      currentMenuState = STATE_MAIN_DISPLAY;
     }
+    lastActivityTime = millis();
+  } else {
+    addSerialLogf_P(PSTR("✅ Alarm cleared: %s"), name);
   }
+  blynkAlarmPending = true;
+}
 
-  Serial.println("Connecting to saved WiFi...");
-  addSerialLog("Connecting to WiFi SSID: " + String(savedSsid));
-
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(savedSsid, savedPass);
-
-  unsigned long startAttemptTime = millis();
-  int dotCount = 0;
-  while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 10000) {
-    yield();
-    delay(100);
-    Serial.print(".");
-    if (++dotCount >= 50) {
-      Serial.println();
-      dotCount = 0;
-    }
+// V10: names of the active alarms ("" = none)
+void sendAlarmsToBlynk() {
+  if (!blynkAlarmPending || !Blynk.connected()) return;
+  blynkAlarmPending = false;
+
+  char text[64] = "";
+  uint32_t alarms = alarmsActiveMask();
+  for (uint8_t id = 0; id < ALARM_COUNT; id++) {
+    if (!(alarms & (1UL << id))) continue;
+    if (text[0]) strncat(text, ", ", sizeof(text) - strlen(text) - 1);
+    strncat_P(text, (PGM_P)alarmName((AlarmId)id), sizeof(text) - strlen(text) - 1);
   }
-  Serial.println();
+  Blynk.virtualWrite(V10, text);
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("✅ WiFi connected!");
-    Serial.print("IP: ");
-    Serial.println(WiFi.localIP());
+// Network events (called from networkService())
+void onNetworkEvent(NetEvent event) {
+  switch (event) {
+    case NET_EVENT_CONNECTED:
+      Serial.print(F("✅ WiFi connected! IP: "));
+      Serial.println(WiFi.localIP());
+      addSerialLogf_P(PSTR("WiFi connected. IP: %s"), WiFi.localIP().toString().c_str());
+      break;
 
-    if (isInternetAvailable()) {
-      Serial.println("🌐 Internet is available!");
-      addSerialLog("WiFi + Internet OK");
+    case NET_EVENT_ONLINE:
+      Serial.println(F("🌐 Internet is available!"));
+      addSerialLog(F("WiFi + Internet OK"));
       internetConnected = true;
 
-      setupServerRoutes();
-      server.begin();
-
+      // Blynk.run() connects in the background once configured
       Blynk.config(BLYNK_AUTH_TOKEN);
-      Blynk.connect(5000);  // Non-blocking
+      timeSyncStart(); // SNTP in the background, see TimeSync.cpp
+      break;
 
-      delay(3000);  // Allow internet/DNS to fully initialize
-      checkAndFixRtcTime();  // Safe to run now
+    case NET_EVENT_OFFLINE:
+      addSerialLog(F("❌ Internet lost. Retrying with backoff."));
+      internetConnected = false;
+      break;
 
-    } else {
-      Serial.println("❌ WiFi OK, but no internet.");
-      addSerialLog("WiFi connected, but internet not available.");
+    case NET_EVENT_DISCONNECTED:
+      addSerialLog(F("WiFi link lost. Waiting for reconnect."));
       internetConnected = false;
+      break;
 
-      setupServerRoutes();
-      server.begin();
-    }
+    case NET_EVENT_FAILED:
+      Serial.println(F("❌ WiFi connection failed."));
+      addSerialLog(F("WiFi connection failed. Starting AP mode."));
+      internetConnected = false;
+      startAPFallback(); // non-modal: the scheduler keeps running
+      break;
+  }
+}
 
-  } else {
-    Serial.println("❌ WiFi connection failed.");
-    addSerialLog("WiFi connection failed. Starting AP mode.");
-    internetConnected = false;
-    startAPMode();
+// Starts the WiFi join and returns immediately; networkService() does the rest
+void connectWiFi() {
+  loadWiFiCredentials(); // Loads savedSsid and savedPass
+
+  if (strlen(savedSsid) == 0 || strlen(savedPass) == 0) {
+    if (wifiSetupSkipped) {
+      Serial.println(F("WiFi setup skipped. Running offline."));
+      addSerialLog(F("WiFi setup skipped. Running offline."));
+      WiFi.mode(WIFI_OFF);
+      internetConnected = false;
+      return;
+    } else {
+      Serial.println(F("No WiFi credentials. Starting AP mode."));
+      addSerialLog(F("No WiFi credentials. Starting AP mode."));
+      startAPMode();
+      internetConnected = false;
+      return;
+    }
   }
+
+  Serial.println(F("Connecting to saved WiFi (background)..."));
+  addSerialLogf_P(PSTR("Connecting to WiFi SSID: %s"), savedSsid);
+
+  networkSetEventHandler(onNetworkEvent);
+  networkBegin(savedSsid, savedPass);
 }
 
 
@@ -1403,14 +1903,14 @@ void showAPMenuOLED(int apMenuIndex, const String &apIP) {
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
-  display.println("AP Mode - Setup");
+  display.println(F("AP Mode - Setup"));
   display.println();
 
   display.println(apMenuIndex == 0 ? "> AP Details" : "  AP Details");
   display.println(apMenuIndex == 1 ? "> QR Code" : "  QR Code");
   display.println(apMenuIndex == 2 ? "> Skip setup" : "  Skip setup");
 
-  display.display();
+  i2cFlushDisplayNow();
 }
 
 void showAPModeSubmenu() {
@@ -1418,18 +1918,18 @@ void showAPModeSubmenu() {
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
-  display.println("Activate AP Mode");
+  display.println(F("Activate AP Mode"));
   display.println();
 
   for (int i = 0; i < apModeMenuCount; i++) {
     if (i == selectedMenuIndex) {
-      display.print("> ");
+      display.print(F("> "));
     } else {
-      display.print("  ");
+      display.print(F("  "));
     }
-    display.println(apModeMenuOptions[i]);
+    display.println(strTableItem(apModeMenuOptions, i));
   }
-  display.display();
+  i2cFlushDisplayNow();
 }
 
 
@@ -1446,15 +1946,15 @@ void displayAPDetails(const String &apIP) {
   display.setTextSize(1);
   display.setCursor(0, 0);
   display.setTextColor(SSD1306_WHITE);
-  display.println("AP Mode Details:");
-  display.println("----------------");
-  display.print("SSID: ");
+  display.println(F("AP Mode Details:"));
+  display.println(F("----------------"));
+  display.print(F("SSID: "));
   display.println(AP_SSID);
-  display.print("PASS: ");
+  display.print(F("PASS: "));
   display.println(AP_PASS);
-  display.print("IP: ");
+  display.print(F("IP: "));
   display.println(apIP);
-  display.display();
+  i2cFlushDisplayNow();
 
   // === Step 2: Wait for *new* button press while serving HTTP ===
   while (true) {
@@ -1472,6 +1972,7 @@ void displayAPDetails(const String &apIP) {
 }
 
 void displayAPQRCode(const String &apIP) {
+  STALL_MARK("ap_qr_screen");
   // --- Flush any previous button presses before showing ---
   while (digitalRead(BACK_BUTTON_PIN) == LOW || digitalRead(SELECT_BUTTON_PIN) == LOW) {
     delay(10);
@@ -1499,7 +2000,7 @@ void displayAPQRCode(const String &apIP) {
       }
     }
   }
-  display.display();
+  i2cFlushDisplayNow();
 
   // === Step 3: Wait for *new* button press while serving HTTP
   while (true) {
@@ -1552,90 +2053,12 @@ void handleAPModeMenu() {
   }
 }
 
-//ntp code
-bool isInternetAvailable() {
-  if (WiFi.status() != WL_CONNECTED) return false;
-
-  HTTPClient http;
-  http.setTimeout(3000);
-  http.begin("http://clients3.google.com/generate_204");
-  int httpCode = http.GET();
-  http.end();
-
-  return (httpCode == 204);
-}
-
-bool isRtcTimeValid(time_t ntpEpoch, DateTime rtcTime, int maxAllowedDiffSec = 60) {
-  // Convert rtcTime to epoch for comparison
-  tm rtcTm = {};
-  rtcTm.tm_year = rtcTime.year() - 1900;
-  rtcTm.tm_mon = rtcTime.month() - 1;
-  rtcTm.tm_mday = rtcTime.day();
-  rtcTm.tm_hour = rtcTime.hour();
-  rtcTm.tm_min = rtcTime.minute();
-  rtcTm.tm_sec = rtcTime.second();
-  time_t rtcEpoch = mktime(&rtcTm);
-
-  long diff = abs((long)(ntpEpoch - rtcEpoch));
-  return diff <= maxAllowedDiffSec; // valid if difference within maxAllowedDiffSec seconds
-}
-
-void checkAndFixRtcTime() {
-  if (WiFi.status() != WL_CONNECTED) {
-    addSerialLog("❌ WiFi not connected. Cannot check NTP.");
-    return;
-  }
-  configTime(19800, 0,
-    "0.in.pool.ntp.org",
-    "1.in.pool.ntp.org",
-    "2.in.pool.ntp.org"
-  );
-
-  Serial.print("Waiting for NTP time sync");
-  time_t now = time(nullptr);
-  int retries = 0;
-  const int maxRetries = 30;
-  while (now < 946684800 && retries < maxRetries) {
-    waitMillis(300);
-    Serial.print(".");
-    now = time(nullptr);
-    retries++;
-  }
-  Serial.println();
-
-  if (now < 946684800) {
-    addSerialLog("❌ NTP sync failed.");
-    return;
-  }
-  struct tm timeinfo;
-  localtime_r(&now, &timeinfo);
-  DateTime ntpDateTime(
-    timeinfo.tm_year + 1900,
-    timeinfo.tm_mon + 1,
-    timeinfo.tm_mday,
-    timeinfo.tm_hour,
-    timeinfo.tm_min,
-    timeinfo.tm_sec
-  );
-
-  DateTime rtcNow = rtc.now();
-
-  if (isRtcTimeValid(now, rtcNow, 60)) {
-    addSerialLog("✅ RTC time is valid. No update needed.");
-  } else {
-    rtc.adjust(ntpDateTime);
-    char buf[32];
-    strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S %p", &timeinfo);
-    addSerialLog("⚠️ RTC time corrected via NTP: " + String(buf));
-  }
-}
-
 void activateAPModeFromMenu() {
   // Check if AP is already running
   if (WiFi.getMode() == WIFI_AP) {
     String apIP = WiFi.softAPIP().toString();
-    addSerialLog("AP Mode already running. SSID: " + String(AP_SSID_MENU) +
-                 ", PASS: " + String(AP_PASS) + ", IP: " + apIP);
+    addSerialLogf_P(PSTR("AP Mode already running. SSID: %s, PASS: %s, IP: %s"),
+                    AP_SSID_MENU, AP_PASS, apIP.c_str());
     showAPStatusScreen("AP Mode Already On", AP_SSID_MENU, AP_PASS, apIP);
     delay(1500); // Brief message
     return;
@@ -1647,8 +2070,8 @@ void activateAPModeFromMenu() {
   WiFi.softAP(AP_SSID_MENU, AP_PASS);
 
   String apIP = WiFi.softAPIP().toString();
-  addSerialLog("AP Mode started from menu. SSID: " + String(AP_SSID_MENU) +
-               ", PASS: " + String(AP_PASS) + ", IP: " + apIP);
+  addSerialLogf_P(PSTR("AP Mode started from menu. SSID: %s, PASS: %s, IP: %s"),
+                  AP_SSID_MENU, AP_PASS, apIP.c_str());
 
   setupServerRoutes_AP(apIP, AP_SSID_MENU, AP_PASS);
   server.begin();
@@ -1659,13 +2082,13 @@ void activateAPModeFromMenu() {
 void deactivateAPModeFromMenu() {
   // Check if AP mode is already off
   if (WiFi.getMode() != WIFI_AP) {
-    addSerialLog("AP Mode already off.");
+    addSerialLog(F("AP Mode already off."));
     display.clearDisplay();
     display.setTextSize(1);
     display.setTextColor(SSD1306_WHITE);
     display.setCursor(0, 0);
-    display.println("AP Mode Already Off");
-    display.display();
+    display.println(F("AP Mode Already Off"));
+    i2cFlushDisplayNow();
     delay(1500); // Show message briefly
     return;
   }
@@ -1674,30 +2097,33 @@ void deactivateAPModeFromMenu() {
   WiFi.softAPdisconnect(true);
   WiFi.mode(WIFI_OFF);
 
-  addSerialLog("AP Mode stopped from menu.");
+  addSerialLog(F("AP Mode stopped from menu."));
   display.clearDisplay();
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
-  display.println("AP Mode Stopped");
-  display.display();
+  display.println(F("AP Mode Stopped"));
+  i2cFlushDisplayNow();
   delay(1500); // Show message briefly
 }
 
 
 // ======================= Setup and Loop =======================
 void waitMillis(unsigned long ms) {
+  STALL_MARK("wait_millis");
   unsigned long start = millis();
   while (millis() - start < ms) {
     Blynk.run();   // if you're using Blynk
     timer.run();   // if using SimpleTimer or BlynkTimer
+    networkService();
+    timeSyncService();
     yield();       // important for ESP8266/ESP32 to avoid watchdog resets
   }
 }
 
 void setup() {
   Serial.begin(115200);
-  Wire.begin();
+  i2cBusBegin(&display); // Wire @ 400 kHz + bus arbiter
 
   wifiSetupSkipped = (readFloat(ADDR_WIFI_SKIP_F) > 0.5f);
 
@@ -1710,11 +2136,13 @@ void setup() {
   display.setTextSize(1);
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(0, 0);
-  display.println("Initializing...");
-  display.display();
+  display.println(F("Initializing..."));
+  i2cFlushDisplayNow();
 
-  showBootProgressBar();
-  showWelcomeScreen();
+  if (BOOT_SPLASH_MS > 0) {
+    showWelcomeScreen();
+    bootSplashUntilMs = millis() + BOOT_SPLASH_MS;
+  }
 
   // Initialize buttons
   pinMode(BACK_BUTTON_PIN, INPUT_PULLUP);
@@ -1722,153 +2150,111 @@ void setup() {
   pinMode(UP_BUTTON_PIN, INPUT_PULLUP);
   pinMode(DOWN_BUTTON_PIN, INPUT_PULLUP);
 
-  // Load WiFi credentials
-  loadWiFiCredentials();
-
-  bool wifiConnected = false;
-
-  if (strlen(savedSsid) == 0) {
-    Serial.println("No saved WiFi credentials. Starting AP mode...");
-    startAPMode();
-  } else {
-    connectWiFi();
-
-    // Non-blocking wait for WiFi connection (max 10s)
-    unsigned long wifiStart = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - wifiStart < 10000) {
-      Blynk.run();
-      timer.run();
-      yield();
-
-      display.clearDisplay();
-      display.setCursor(0, 0);
-      display.println("Connecting to WiFi...");
-      display.display();
-    }
-
-    if (WiFi.status() != WL_CONNECTED) {
-      Serial.println("WiFi connection failed. Switching to AP mode...");
-      startAPMode();
-    } else {
-      wifiConnected = true;
-    }
-  }
+  // Sensors initialization
+  reinitINA219();
+  reinitADS1115();
+  reinitRTC();
+  if (!rtc_present) Serial.println(F("Couldn't find RTC"));
+
+  // Absent devices are quarantined and re-probed in the background
+  i2cSetDevicePresent(I2C_DEV_INA219, ina219_present);
+  i2cSetDevicePresent(I2C_DEV_ADS1115, ads1115_present);
+  i2cSetDevicePresent(I2C_DEV_RTC, rtc_present);
+  i2cSetReinitHandler(I2C_DEV_INA219, reinitINA219);
+  i2cSetReinitHandler(I2C_DEV_ADS1115, reinitADS1115);
+  i2cSetReinitHandler(I2C_DEV_RTC, reinitRTC);
+
+  // Software clock from the DS3231 until NTP arrives
+  timeSyncBegin();
+
+  // WiFi joins in the background while the rest of setup runs and the
+  // zero offset settles; networkService() brings up Blynk and NTP once
+  // the link is online. (After timeSyncBegin(): lease reuse needs a clock.)
+  connectWiFi();
 
   setupServerRoutes();
   server.begin();
 
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-
-if (WiFi.status() == WL_CONNECTED) {
-  if (isInternetAvailable()) {
-    display.println("WiFi + Internet OK");
-  } else {
-    display.println("WiFi OK, No Internet");
-  }
-
-  display.print("IP: ");
-  display.println(WiFi.localIP());
-} else {
-  display.println("AP Mode Active");
-  display.print("SSID: ");
-  display.println(AP_SSID);
-  display.print("IP: ");
-  display.println(WiFi.softAPIP());
-}
-    display.display();
-
-
-  // Sensors initialization
-  ina219_present = ina219.begin();
-  if (ina219_present) ina219.setCalibration_32V_2A();
-
-  ads1115_present = ads.begin();
-  if (ads1115_present) ads.setGain(GAIN_ONE);
-
-  rtc_present = rtc.begin();
-  if (!rtc_present) Serial.println("Couldn't find RTC");
-
-  if (wifiConnected && rtc_present) {
-    syncTimeFromNTPtoRTC();
-  }
-
-  // Load EEPROM values
-  readFloat(ADDR_BATTERY_CAPACITY, &batteryCapacityAh);
-  readFloat(ADDR_VOLTAGE_THRESHOLD_MIN, &minVoltageThreshold);
-  readFloat(ADDR_VOLTAGE_THRESHOLD_MAX, &maxVoltageThreshold);
-  readFloat(ADDR_CURRENT_DEADZONE, &currentDeadzoneThreshold);
-  readInt(ADDR_SCREEN_TIMEOUT, &screenTimeout);
-  readInt(ADDR_STATS_CYCLE_COUNT, &cycleCount);
-  readFloat(ADDR_STATS_TOTAL_ENERGY_IN, &totalEnergyInWh);
-  readFloat(ADDR_STATS_TOTAL_ENERGY_OUT, &totalEnergyOutWh);
-  readInt(ADDR_CHARGING_SECONDS, &chargingSeconds);
-  readInt(ADDR_DISCHARGING_SECONDS, &dischargingSeconds);
-  readInt(ADDR_IDLE_SECONDS, &idleSeconds);
+  // Load EEPROM values
+  loadSettingsFromEEPROM();
+  alarmsBegin(onAlarm); // thresholds come from the settings just loaded
+  captureSetScaleSource(fillCaptureScales);
+  histogramLoad();
+  forecastLoad();
+  historySetCloseHandler(onHistoryBucketClosed);
 
   lastStateChangeMillis = millis();
   lastRuntimeSaveMillis = millis();
 
-  uint32_t socFlag;
-  readInt(ADDR_SOC_SAVED_FLAG, &socFlag);
-  if (socFlag == 1) {
-    readFloat(ADDR_SOC, &soc);
-  } else {
-    soc = 100.0;
-    writeFloat(ADDR_SOC, soc);
-    writeInt(ADDR_SOC_SAVED_FLAG, 1);
-  }
-
-  totalCoulombs = (soc / 100.0) * batteryCapacityAh * 3600.0;
-  lastUpdate = millis();
+  lastUpdate = batteryMillis();
   lastActivityTime = millis();
-  lastActiveStateChange = millis();
+  lastActiveStateChange = batteryMillis();
   saverX = SCREEN_WIDTH / 2;
   saverY = SCREEN_HEIGHT / 2;
 
-  // Calibrate zero current (non-blocking delay)
-  Serial.println("Calibrating zero current...");
-  waitMillis(5000); // replaced delay(5000)
-
-  long total = 0;
-  for (int i = 0; i < MEASUREMENT_ITERATIONS; i++) {
-    int16_t adcReading = ads.readADC_SingleEnded(SENSOR_CHANNEL);
-    float mV = ads.computeVolts(adcReading) * 1000.0;
-    total += mV;
-    waitMillis(2);  // replaced delay(2)
+#if BATTERY_SIM
+  // Sensors come from the model: zero offset = WCS1600 mid-rail
+  simBegin(2500.0, WCS1600_SENSITIVITY_mV_PER_A);
+  ina219_present = ads1115_present = true;
+  i2cSetDevicePresent(I2C_DEV_INA219, true);
+  i2cSetDevicePresent(I2C_DEV_ADS1115, true);
+#endif
+
+  // Provisional zero current offset (~70 ms); refined in the background
+  float total = 0;
+  int good = 0;
+  for (int i = 0; i < ZERO_PROVISIONAL_SAMPLES && ads1115_present; i++) {
+    int16_t adcReading;
+    if (adsReadSingleEnded(SENSOR_CHANNEL, &adcReading)) {
+      total += ads.computeVolts(adcReading) * 1000.0;
+      good++;
+    }
   }
-  zeroOffset_mV = (float)total / MEASUREMENT_ITERATIONS;
-  Serial.print("Zero Current Offset (mV): ");
+  if (good > 0) zeroOffset_mV = total / good;
+  zeroRefineStartMs = millis();
+  isSensorStable = !ads1115_present; // nothing to refine without the ADC
+  Serial.print(F("Provisional Zero Current Offset (mV): "));
   Serial.println(zeroOffset_mV, 3);
 
   // Set timers
   timer.setInterval(1000L, sendToBlynk);
-  timer.setInterval(300000L, saveSocToEEPROM);
-  timer.setInterval(600000L, saveEnergyStatsToEEPROM);
-  timer.setInterval(60000L, checkAndResetDailyEnergy);
+  setBatteryInterval(300000L, saveSocToEEPROM);
+  setBatteryInterval(600000L, saveEnergyStatsToEEPROM);
+  setBatteryInterval(60000L, checkAndResetDailyEnergy);
   timer.setInterval(5000L, updateBlynkBackupTime);
   timer.setInterval(5000L, updateBlynkChargingTime);
 
-  Serial.println("Waiting for sensor to stabilize...");
-  waitMillis(5000); // replaced delay(5000)
-  isSensorStable = true;
-
-  // Load current thresholds
-  readFloat(ADDR_CHARGING_THRESHOLD, &chargingCurrentThreshold);
-  if (isnan(chargingCurrentThreshold) || chargingCurrentThreshold <= 0.0 || chargingCurrentThreshold > 10.0)
-    chargingCurrentThreshold = 0.6;
-
-  readFloat(ADDR_DISCHARGING_THRESHOLD, &dischargingCurrentThreshold);
-  if (isnan(dischargingCurrentThreshold) || dischargingCurrentThreshold <= 0.0 || dischargingCurrentThreshold > 10.0)
-    dischargingCurrentThreshold = 1.0;
+  // From here on EEPROM writes are queued and trickled out by loop()
+  i2cSetDeferredWrites(true);
+
+  setupTasks();
+#if ENABLE_BENCH
+  setupBenchmarks();
+#endif
+  heapMonitorSample(); // boot baseline for the heap watermarks
+  if (heapStats().freeBytes < MEM.heapHeadroom) {
+    addSerialLogf_P(PSTR("⚠️ Memory profile '%s': only %lu B free, target headroom %u B"),
+                  MEM.name, (unsigned long)heapStats().freeBytes, MEM.heapHeadroom);
+  } else {
+    addSerialLogf_P(PSTR("Memory profile '%s': %lu B free (headroom target %u B)"),
+                  MEM.name, (unsigned long)heapStats().freeBytes, MEM.heapHeadroom);
+  }
+  stallWatchBegin();   // last: setup itself is not a stall
 
-  Serial.println("Sensor stable. Starting measurements.");
+  Serial.println(F("Setup done. Measuring while zero offset settles."));
 }
 
 
 
 
+// Three consecutive pins: min, max, peak-to-peak (skipped if nothing was sampled)
+static void writeRangeToBlynk(int pin, const MinMax& m) {
+  if (!extremesValid(m)) return;
+  Blynk.virtualWrite(pin, m.lo);
+  Blynk.virtualWrite(pin + 1, m.hi);
+  Blynk.virtualWrite(pin + 2, m.hi - m.lo);
+}
+
 void sendToBlynk() {
   static bool toggleHalf = false;
 
@@ -1886,13 +2272,13 @@ void sendToBlynk() {
     Blynk.virtualWrite(V6, totalEnergyOutWh);   // Energy Out
 
     // Battery Status
-    String status = "Idle";
-			if (filteredCurrent > chargingCurrentThreshold) {
-				status = "Charging";
-			} else if (filteredCurrent < -dischargingCurrentThreshold) {
-				status = "Discharging";
-			}
-    Blynk.virtualWrite(V4, status);             // Status
+    Blynk.virtualWrite(V4, batteryStatusText()); // Status
+
+    // Raw-sample extremes since the previous push
+    Extremes ext = extremesTake(EXTREMES_BLYNK);
+    writeRangeToBlynk(V11, ext.voltage);        // V11..V13 voltage min/max/p-p
+    writeRangeToBlynk(V14, ext.current);        // V14..V16 current min/max/p-p
+    writeRangeToBlynk(V17, ext.power);          // V17..V19 power min/max/p-p
 
     // Uptime
     unsigned long seconds = uptimeSeconds % 60;
@@ -1928,50 +2314,17 @@ void processButtons() {
         return;
     }
 
-    // Special handling for charging/discharging threshold states
-    if (currentMenuState == STATE_SET_CHARGING_THRESHOLD) {
-        if (buttonUpPressed)    { tempFloatValue += 0.1; lastButtonPressTime = millis(); }
-        if (buttonDownPressed)  { tempFloatValue = max(0.1f, tempFloatValue - 0.1f); lastButtonPressTime = millis(); }
-        if (buttonSelectPressed) {
-            chargingCurrentThreshold = tempFloatValue;
-            writeFloat(ADDR_CHARGING_THRESHOLD, chargingCurrentThreshold);
-            currentMenuState = STATE_MESSAGE;
-            tempMessage = "Charging threshold saved.";
-            messageDisplayStartTime = millis();
-            popHistory();
-        }
-        if (buttonBackPressed) {
-            popHistory();
-            currentMenuState = menuHistory[historyIndex].state;
-            selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-        }
-        return;
+    // Update activity time (before any dispatch, so editing keeps the screen on)
+    if (buttonUpPressed || buttonDownPressed || buttonSelectPressed || buttonBackPressed) {
+        lastActivityTime = millis();
     }
 
-    if (currentMenuState == STATE_SET_DISCHARGING_THRESHOLD) {
-        if (buttonUpPressed)    { tempFloatValue += 0.1; lastButtonPressTime = millis(); }
-        if (buttonDownPressed)  { tempFloatValue = max(0.1f, tempFloatValue - 0.1f); lastButtonPressTime = millis(); }
-        if (buttonSelectPressed) {
-            dischargingCurrentThreshold = tempFloatValue;
-            writeFloat(ADDR_DISCHARGING_THRESHOLD, dischargingCurrentThreshold);
-            currentMenuState = STATE_MESSAGE;
-            tempMessage = "Discharging threshold saved.";
-            messageDisplayStartTime = millis();
-            popHistory();
-        }
-        if (buttonBackPressed) {
-            popHistory();
-            currentMenuState = menuHistory[historyIndex].state;
-            selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-        }
+    // Generic value editor (any SETTINGS_TABLE row)
+    if (currentMenuState == STATE_EDIT_SETTING) {
+        processSettingEditor();
         return;
     }
 
-    // Update activity time
-    if (buttonUpPressed || buttonDownPressed || buttonSelectPressed || buttonBackPressed) {
-        lastActivityTime = millis();
-    }
-
     // --- Main Display ---
     if (currentMenuState == STATE_MAIN_DISPLAY) {
         if (buttonSelectPressed) {
@@ -2088,8 +2441,7 @@ void processButtons() {
 					menuScrollOffset = 0;
 					break;
 				case 1: // Set screen timeout
-					currentMenuState = STATE_SET_SCREEN_TIMEOUT;
-					tempIntValue = screenTimeout;
+					beginSettingEdit(SETTING_SCREEN_TIMEOUT, SETTING_NONE);
 					break;
 				case 2: // Back
 					popHistory();
@@ -2129,21 +2481,16 @@ void processButtons() {
 			pushHistory(currentMenuState, selectedMenuIndex);
 			switch (selectedMenuIndex) {
 				case 0: // Set battery capacity (Ah)
-					currentMenuState = STATE_SET_CAPACITY;
-					tempFloatValue = batteryCapacityAh;
+					beginSettingEdit(SETTING_CAPACITY, SETTING_NONE);
 					break;
-				case 1: // Set voltage thresholds (min/max)
-					currentMenuState = STATE_SET_VOLTAGE_THRESHOLDS_MIN;
-					tempFloatValue = minVoltageThreshold;
+				case 1: // Set voltage thresholds (min, then max)
+					beginSettingEdit(SETTING_MIN_VOLTAGE, SETTING_MAX_VOLTAGE);
 					break;
 				case 2: // Select battery type
-					currentMenuState = STATE_SET_BATTERY_TYPE;
-					tempIntValue = batteryType;
+					beginSettingEdit(SETTING_BATTERY_TYPE, SETTING_NONE);
 					break;
 				case 3: // Reset SOC to 100%
-					soc = 100.0;
-					totalCoulombs = (soc / 100.0) * batteryCapacityAh * 3600.0;
-					writeFloat(ADDR_SOC, soc);
+					settingsSet(SETTING_SOC, 100.0);
                     currentMenuState = STATE_MESSAGE;
                     tempMessage = "SOC reset to 100%.";
                     messageDisplayStartTime = millis();
@@ -2162,132 +2509,6 @@ void processButtons() {
 			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
 			lastButtonPressTime = millis();
 		}
-	} else if (currentMenuState == STATE_SET_CAPACITY) {
-		if (buttonUpPressed) {
-			tempFloatValue += 0.1;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempFloatValue -= 0.1;
-			tempFloatValue = max(0.1f, tempFloatValue);
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			batteryCapacityAh = tempFloatValue;
-			writeFloat(ADDR_BATTERY_CAPACITY, batteryCapacityAh);
-			totalCoulombs = (soc / 100.0) * batteryCapacityAh * 3600.0;
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Capacity saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
-	} else if (currentMenuState == STATE_SET_VOLTAGE_THRESHOLDS_MIN) {
-		if (buttonUpPressed) {
-			tempFloatValue += 0.1;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempFloatValue -= 0.1;
-			tempFloatValue = max(0.1f, tempFloatValue);
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			minVoltageThreshold = tempFloatValue;
-			pushHistory(currentMenuState, selectedMenuIndex);
-			currentMenuState = STATE_SET_VOLTAGE_THRESHOLDS_MAX;
-			tempFloatValue = maxVoltageThreshold;
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
-	} else if (currentMenuState == STATE_SET_VOLTAGE_THRESHOLDS_MAX) {
-		if (buttonUpPressed) {
-			tempFloatValue += 0.1;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempFloatValue -= 0.1;
-			tempFloatValue = max(minVoltageThreshold + 0.1f, tempFloatValue);
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			maxVoltageThreshold = tempFloatValue;
-			writeFloat(ADDR_VOLTAGE_THRESHOLD_MIN, minVoltageThreshold);
-			writeFloat(ADDR_VOLTAGE_THRESHOLD_MAX, maxVoltageThreshold);
-			popHistory();
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Voltage thresholds saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
-	} else if (currentMenuState == STATE_SET_BATTERY_TYPE) {
-		if (buttonUpPressed) {
-			if (tempIntValue > 0) tempIntValue--;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			if (tempIntValue < 2) tempIntValue++;
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			batteryType = tempIntValue;
-			writeFloat(ADDR_BATTERY_TYPE, batteryType);
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Battery type saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
-	} else if (currentMenuState == STATE_SET_SCREEN_TIMEOUT) {
-		if (buttonUpPressed) {
-			tempIntValue += 5;
-			tempIntValue = constrain(tempIntValue, 5, 300);
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempIntValue -= 5;
-			tempIntValue = constrain(tempIntValue, 5, 300);
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			screenTimeout = tempIntValue;
-			writeInt(ADDR_SCREEN_TIMEOUT, screenTimeout);
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Screen timeout saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
 	} else if (currentMenuState == STATE_CALIBRATION_MENU) {
   if (buttonUpPressed) {
     if (selectedMenuIndex > 0) {
@@ -2372,27 +2593,19 @@ void processButtons() {
         break;
 
       case 1: // Manual zero offset adjustment
-        currentMenuState = STATE_MANUAL_ZERO_OFFSET;
-        tempFloatValue = currentOffset;
+        beginSettingEdit(SETTING_CURRENT_OFFSET, SETTING_NONE);
         break;
 
-		case 2: // Set Charge Current Threshold
-		if (isnan(chargingCurrentThreshold) || chargingCurrentThreshold <= 0.0 || chargingCurrentThreshold > 10.0)
-			chargingCurrentThreshold = 0.6;
-		tempFloatValue = chargingCurrentThreshold;
-		currentMenuState = STATE_SET_CHARGING_THRESHOLD;
-		break;
-
-		case 3: // Set Discharge Current Threshold
-		if (isnan(dischargingCurrentThreshold) || dischargingCurrentThreshold <= 0.0 || dischargingCurrentThreshold > 10.0)
-			dischargingCurrentThreshold = 1.0;
-		tempFloatValue = dischargingCurrentThreshold;
-		currentMenuState = STATE_SET_DISCHARGING_THRESHOLD;
-		break;
-		
-    case 4: // Set mV per Amp value
-        currentMenuState = STATE_SET_MV_PER_AMP;
-        tempFloatValue = mVperAmp;
+      case 2: // Set Charge Current Threshold
+        beginSettingEdit(SETTING_CHARGE_THRESHOLD, SETTING_NONE);
+        break;
+
+      case 3: // Set Discharge Current Threshold
+        beginSettingEdit(SETTING_DISCHARGE_THRESHOLD, SETTING_NONE);
+        break;
+
+      case 4: // Set mV per Amp value
+        beginSettingEdit(SETTING_MV_PER_AMP, SETTING_NONE);
         break;
 
       case 5: // Back
@@ -2410,56 +2623,7 @@ void processButtons() {
     selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
     lastButtonPressTime = millis();
   }
-} else if (currentMenuState == STATE_MANUAL_ZERO_OFFSET) {
-		if (buttonUpPressed) {
-			tempFloatValue += 0.01;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempFloatValue -= 0.01;
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			currentOffset = tempFloatValue;
-			writeFloat(ADDR_CURRENT_OFFSET, currentOffset);
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Current offset saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
-	} else if (currentMenuState == STATE_SET_MV_PER_AMP) {
-		if (buttonUpPressed) {
-			tempFloatValue += 0.1;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempFloatValue -= 0.1;
-			tempFloatValue = max(0.1f, tempFloatValue);
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			mVperAmp = tempFloatValue;
-			writeFloat(ADDR_MV_PER_AMP, mVperAmp);
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "mV per Amp saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
-	} else if (currentMenuState == STATE_VOLTAGE_CAL_MENU) {
+} else if (currentMenuState == STATE_VOLTAGE_CAL_MENU) {
 		if (buttonUpPressed) {
 			if (selectedMenuIndex > 0) {
 				selectedMenuIndex--;
@@ -2482,8 +2646,7 @@ void processButtons() {
 			pushHistory(currentMenuState, selectedMenuIndex);
 			switch (selectedMenuIndex) {
 				case 0: // Adjust voltage reading offset
-					currentMenuState = STATE_ADJUST_VOLTAGE_OFFSET;
-					tempFloatValue = voltageOffset;
+					beginSettingEdit(SETTING_VOLTAGE_OFFSET, SETTING_NONE);
 					break;
 				case 1: // Calibrate with known voltage source
 					currentMenuState = STATE_CALIBRATE_KNOWN_VOLTAGE;
@@ -2503,30 +2666,6 @@ void processButtons() {
 			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
 			lastButtonPressTime = millis();
 		}
-	} else if (currentMenuState == STATE_ADJUST_VOLTAGE_OFFSET) {
-		if (buttonUpPressed) {
-			tempFloatValue += 0.01;
-			lastButtonPressTime = millis();
-		}
-		if (buttonDownPressed) {
-			tempFloatValue -= 0.01;
-			lastButtonPressTime = millis();
-		}
-		if (buttonSelectPressed) {
-			voltageOffset = tempFloatValue;
-			writeFloat(ADDR_VOLTAGE_OFFSET, voltageOffset);
-			popHistory();
-			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Voltage offset saved.";
-            messageDisplayStartTime = millis();
-			lastButtonPressTime = millis();
-		}
-		if (buttonBackPressed) {
-			popHistory();
-			currentMenuState = menuHistory[historyIndex].state;
-			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
-			lastButtonPressTime = millis();
-		}
 	} else if (currentMenuState == STATE_CALIBRATE_KNOWN_VOLTAGE) {
 		if (buttonUpPressed) {
 			tempFloatValue += 0.1;
@@ -2538,11 +2677,12 @@ void processButtons() {
 			lastButtonPressTime = millis();
 		}
 		if (buttonSelectPressed) {
-			calibrateVoltageWithKnownSource(tempFloatValue);
+			if (calibrateVoltageWithKnownSource(tempFloatValue)) {
+				tempMessage = "Voltage calibrated.";
+			} // else: tempMessage already holds the reason
 			popHistory();
 			popHistory();
 			currentMenuState = STATE_MESSAGE;
-            tempMessage = "Voltage calibrated.";
             messageDisplayStartTime = millis();
 			lastButtonPressTime = millis();
 		}
@@ -2635,11 +2775,14 @@ void processButtons() {
 					currentMenuState = STATE_VIEW_RUNTIME_HISTORY;
 					logViewOffset = 0;
 					break;
-				case 3: // Reset Statistics
+				case 3: // Trend Graphs
+					currentMenuState = STATE_VIEW_TRENDS;
+					break;
+				case 4: // Reset Statistics
 					resetStatistics();
 					popHistory(); // Pop menu state
 					break;
-				case 4: // Back
+				case 5: // Back
 					popHistory();
 					currentMenuState = menuHistory[historyIndex].state;
 					selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
@@ -2686,6 +2829,25 @@ void processButtons() {
 			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
 			lastButtonPressTime = millis();
 		}
+	} else if (currentMenuState == STATE_VIEW_TRENDS) {
+		if (buttonUpPressed) {
+			trendMetric = (trendMetric + HIST_METRIC_COUNT - 1) % HIST_METRIC_COUNT;
+			lastButtonPressTime = millis();
+		}
+		if (buttonDownPressed) {
+			trendMetric = (trendMetric + 1) % HIST_METRIC_COUNT;
+			lastButtonPressTime = millis();
+		}
+		if (buttonSelectPressed) {
+			trendSpan = (trendSpan + 1) % HIST_SPAN_COUNT;
+			lastButtonPressTime = millis();
+		}
+		if (buttonBackPressed) {
+			popHistory();
+			currentMenuState = menuHistory[historyIndex].state;
+			selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
+			lastButtonPressTime = millis();
+		}
 	} else if (currentMenuState == STATE_SYSTEM_INFO_MENU) {
 		if (buttonUpPressed) {
 			if (selectedMenuIndex > 0) {
@@ -2720,10 +2882,14 @@ void processButtons() {
 				case 3: // Uptime
 					currentMenuState = STATE_VIEW_UPTIME;
 					break;
-				case 4: // About
+				case 4: // Performance
+					perfScrollOffset = 0;
+					currentMenuState = STATE_VIEW_PERF;
+					break;
+				case 5: // About
 					currentMenuState = STATE_ABOUT_MENU;
 					break;
-				case 5: // Back
+				case 6: // Back
 					popHistory();
 					currentMenuState = menuHistory[historyIndex].state;
 					selectedMenuIndex = menuHistory[historyIndex].selectedIndex;
@@ -2739,7 +2905,12 @@ void processButtons() {
 		}
 	} else if (currentMenuState == STATE_VIEW_FIRMWARE || currentMenuState == STATE_VIEW_SENSOR_STATUS ||
 			   currentMenuState == STATE_VIEW_MEMORY_USAGE || currentMenuState == STATE_VIEW_UPTIME ||
-			   currentMenuState == STATE_ABOUT_MENU) {
+			   currentMenuState == STATE_VIEW_PERF || currentMenuState == STATE_ABOUT_MENU) {
+		if (currentMenuState == STATE_VIEW_PERF) {
+			if (buttonUpPressed && perfScrollOffset > 0) perfScrollOffset--;
+			if (buttonDownPressed && perfScrollOffset < PERF_PROBE_COUNT - PERF_ROWS_VISIBLE) perfScrollOffset++;
+			if (buttonUpPressed || buttonDownPressed) lastButtonPressTime = millis();
+		}
 		if (buttonBackPressed) {
 			popHistory();
 			currentMenuState = menuHistory[historyIndex].state;
@@ -2757,60 +2928,11 @@ void handleMessageState() {
     }
 }
 
-unsigned long lastLogTime = 0;
-void loop() {
-    // Keep WiFi / HTTP responsive
-    server.handleClient();
-
-    // Check for internet every 30 min ONLY IF internet was previously down
-  if (!internetConnected && millis() - lastInternetCheck >= INTERNET_CHECK_INTERVAL) {
-    lastInternetCheck = millis();
-
-    Serial.println("🔁 Rechecking internet connectivity...");
-
-    if (WiFi.status() == WL_CONNECTED && isInternetAvailable()) {
-      internetConnected = true;
-      addSerialLog("✅ Internet reconnected. Syncing services.");
-
-      // Safe to run Blynk and NTP now
-      Blynk.config(BLYNK_AUTH_TOKEN);
-      Blynk.connect(5000);  // non-blocking
-
-      checkAndFixRtcTime(); // if you use RTC/NTP
-
-    } else {
-      Serial.println("❌ Still no internet.");
-      addSerialLog("Still no internet after retry.");
-    }
-  }
-    // Blynk tasks
-    Blynk.run();
-    timer.run();
-
-    DateTime rtcNow = rtc.now();
-
-    // Logs every 60 seconds
-    if (millis() - lastLogTime >= 10000) {
-        logSystemStatus();
-        logSensorStatus();
-        lastLogTime = millis();
-    }
-
-    // Midnight RTC check
-    static unsigned long lastMidnightCheck = 0;
-    if (rtcNow.hour() == 0 && rtcNow.minute() == 0 && rtcNow.second() == 0) {
-      if (millis() - lastMidnightCheck > 1000) { // debounce 1 second
-        checkAndFixRtcTime();
-        lastMidnightCheck = millis();
-      }
-  }
-    // Sensor update (with yield inside the sampling loop)
-    updateSensors();
-    yield();
+const uint32_t I2C_SERVICE_BUDGET_US = 1500; // max bus time for queued work per pass
 
+// Screen timeout + OLED rendering (throttled to one frame per 200 ms)
+void updateDisplay() {
     unsigned long now = millis();
-    uptimeMillis = now;
-    uptimeSeconds = uptimeMillis / 1000;
 
     // Screen timeout handling
     if (screenIsOn && now - lastActivityTime > screenTimeout * 1000) {
@@ -2820,117 +2942,97 @@ void loop() {
 
     // Throttle OLED redraws (every 200ms max)
     static unsigned long lastOledUpdate = 0;
-    if (screenIsOn && now - lastOledUpdate >= 200) {
+    if (screenIsOn && now - lastOledUpdate >= 200 && !i2cDisplayFlushPending() &&
+        now >= bootSplashUntilMs) {
         switch (currentMenuState) {
             case STATE_MAIN_DISPLAY:
                 drawMainScreen();
                 break;
             case STATE_MAIN_MENU:
-                drawMenu("Main Menu", mainMenuOptions, numMainMenuItems, selectedMenuIndex, menuScrollOffset);
+                drawMenu(F("Main Menu"), mainMenuOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_VIEW_QR_CODE:
                 drawQRCodeScreen();
                 break;
             case STATE_CONFIG_MENU:
-                drawMenu("Configuration", configMenuOptions, numConfigMenuItems, selectedMenuIndex, menuScrollOffset);
+                drawMenu(F("Configuration"), configMenuOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_BATTERY_SETTINGS_MENU:
-                drawMenu("Battery Settings", batterySettingsOptions, numBatterySettingsItems, selectedMenuIndex, menuScrollOffset);
-                break;
-            case STATE_SET_CAPACITY:
-                drawValueScreen("Set Capacity (Ah)", tempFloatValue, 1, 0.1);
-                break;
-            case STATE_SET_VOLTAGE_THRESHOLDS_MIN:
-                drawValueScreen("Set Min Voltage", tempFloatValue, 2, 0.1);
-                break;
-            case STATE_SET_VOLTAGE_THRESHOLDS_MAX:
-                drawValueScreen("Set Max Voltage", tempFloatValue, 2, 0.1);
+                drawMenu(F("Battery Settings"), batterySettingsOptions, selectedMenuIndex, menuScrollOffset);
                 break;
-            case STATE_SET_BATTERY_TYPE:
-                drawMenu("Set Battery Type", batteryTypes, 3, tempIntValue, 0);
-                break;
-            case STATE_SET_SCREEN_TIMEOUT:
-                drawValueScreen("Set Timeout (s)", (float)tempIntValue, 0, 5.0);
+            case STATE_EDIT_SETTING:
+                drawSettingEditor();
                 break;
             case STATE_CALIBRATION_MENU:
-                drawMenu("Calibration Menu", calibrationMenuOptions, numCalibrationMenuItems, selectedMenuIndex, menuScrollOffset);
+                drawMenu(F("Calibration Menu"), calibrationMenuOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_CURRENT_CAL_MENU:
-                drawMenu("Current Calibration", currentSensorCalOptions, numCurrentSensorCalItems, selectedMenuIndex, menuScrollOffset);
-                break;
-            case STATE_MANUAL_ZERO_OFFSET:
-                drawValueScreen("Current Offset", tempFloatValue, 2, 0.01);
-                break;
-            case STATE_SET_MV_PER_AMP:
-                drawValueScreen("mV/Amp", tempFloatValue, 2, 0.1);
+                drawMenu(F("Current Calibration"), currentSensorCalOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_VOLTAGE_CAL_MENU:
-                drawMenu("Voltage Calibration", voltageCalOptions, numVoltageCalItems, selectedMenuIndex, menuScrollOffset);
-                break;
-            case STATE_ADJUST_VOLTAGE_OFFSET:
-                drawValueScreen("Voltage Offset", tempFloatValue, 2, 0.01);
+                drawMenu(F("Voltage Calibration"), voltageCalOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_CALIBRATE_KNOWN_VOLTAGE:
-                drawValueScreen("Known Voltage", tempFloatValue, 2, 0.1);
+                drawValueScreen(F("Known Voltage"), tempFloatValue, 2, 0.1, F("V"));
                 break;
             case STATE_SAVE_LOAD_CAL_MENU:
-                drawMenu("Save/Load", saveLoadCalOptions, numSaveLoadCalItems, selectedMenuIndex, menuScrollOffset);
-                break;
-            case STATE_SET_CHARGING_THRESHOLD:
-                drawValueScreen("Charging Curr Thresh", tempFloatValue, 2, 0.1);
-                break;
-            case STATE_SET_DISCHARGING_THRESHOLD:
-                drawValueScreen("Dischg Curr Thresh", tempFloatValue, 2, 0.1);
+                drawMenu(F("Save/Load"), saveLoadCalOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_STATS_MENU:
-                drawMenu("Statistics", statsMenuOptions, numStatsMenuItems, selectedMenuIndex, menuScrollOffset);
+                drawMenu(F("Statistics"), statsMenuOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_VIEW_CYCLE_COUNT:
                 display.clearDisplay();
                 display.setTextSize(1);
                 display.setTextColor(SSD1306_WHITE);
                 display.setCursor(0, 0);
-                display.println("Cycle Count");
+                display.println(F("Cycle Count"));
                 display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
                 display.setTextSize(2);
                 display.setCursor(0, 24);
                 display.println(cycleCount);
-                display.display();
+                i2cRequestDisplayFlush();
                 break;
             case STATE_VIEW_TOTAL_ENERGY:
                 display.clearDisplay();
                 display.setTextSize(1);
                 display.setTextColor(SSD1306_WHITE);
                 display.setCursor(0, 0);
-                display.println("Total Energy");
+                display.println(F("Total Energy"));
                 display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
                 display.setCursor(0, 20);
-                display.print("Total In: ");
+                display.print(F("Total In: "));
                 display.print(totalEnergyInWh, 2);
                 display.setCursor(0, 32);
-                display.print("Total Out: ");
+                display.print(F("Total Out: "));
                 display.print(totalEnergyOutWh, 2);
                 display.setCursor(0, 44);
-                display.print("Reset in: ");
-                display.print(getTimeUntilMidnight());
-                display.display();
+                display.print(F("Reset in: "));
+                {
+                    char resetIn[12];
+                    display.print(getTimeUntilMidnight(resetIn, sizeof(resetIn)));
+                }
+                i2cRequestDisplayFlush();
                 break;
             case STATE_VIEW_RUNTIME_HISTORY:
                 drawRuntimeHistoryScreen();
                 break;
+            case STATE_VIEW_TRENDS:
+                drawTrendScreen((HistoryMetric)trendMetric, (HistorySpan)trendSpan);
+                break;
             case STATE_SYSTEM_INFO_MENU:
-                drawMenu("System Info", systemInfoOptions, numSystemInfoItems, selectedMenuIndex, menuScrollOffset);
+                drawMenu(F("System Info"), systemInfoOptions, selectedMenuIndex, menuScrollOffset);
                 break;
             case STATE_VIEW_FIRMWARE:
                 display.clearDisplay();
                 display.setTextSize(1);
                 display.setTextColor(SSD1306_WHITE);
                 display.setCursor(0, 0);
-                display.println("Firmware");
+                display.println(F("Firmware"));
                 display.drawFastHLine(0, 12, SCREEN_WIDTH, SSD1306_WHITE);
                 display.setCursor(0, 20);
                 display.println(FIRMWARE_VERSION);
-                display.display();
+                i2cRequestDisplayFlush();
                 break;
             case STATE_VIEW_SENSOR_STATUS:
                 drawSystemInfoScreen();
@@ -2941,11 +3043,14 @@ void loop() {
             case STATE_VIEW_UPTIME:
                 drawUptimeScreen();
                 break;
+            case STATE_VIEW_PERF:
+                drawPerfScreen();
+                break;
             case STATE_ABOUT_MENU:
                 drawAboutScreen();
                 break;
             case STATE_MESSAGE:
-                drawMessageScreen("System Message", tempMessage);
+                drawMessageScreen(F("System Message"), tempMessage);
                 handleMessageState();
                 break;
             case STATE_AP_MODE_MENU:
@@ -2953,14 +3058,90 @@ void loop() {
                 break;
         }
         lastOledUpdate = now;
-    } else if (currentMenuState == STATE_SCREEN_SAVER) {
+    } else if (currentMenuState == STATE_SCREEN_SAVER && !i2cDisplayFlushPending()) {
         drawScreenSaver();
     }
+}
+
+// ======================= Scheduler tasks =======================
+// Sampling + coulomb integration (updateSensors) is the only hard task;
+// everything else fills the time left in a pass.
+// HEAP_TRACE only counts with HEAP_DEBUG 1 (see /heap).
+#if BATTERY_SIM
+// Virtual time stands still until the zero offset has settled
+void taskSample() {
+    HEAP_TRACE("sample");
+    for (int i = 0; i < SIM_STEPS_PER_PASS; i++) {
+        if (isSensorStable) simStep();
+        updateSensors();
+    }
+}
+#else
+void taskSample()  { HEAP_TRACE("sample"); updateSensors(); }
+#endif
+void taskI2CBus()  { HEAP_TRACE("i2c"); i2cBusService(I2C_SERVICE_BUDGET_US); }
+void taskTimers()  { HEAP_TRACE("timers"); timer.run(); }          // SOC/energy saves, Blynk pushes
+void taskButtons() { PERF_SCOPE(PERF_BUTTONS); HEAP_TRACE("buttons"); processButtons(); }
+void taskHttp()    { PERF_SCOPE(PERF_HTTP); HEAP_TRACE("http"); server.handleClient(); }
+void taskNetwork() { PERF_SCOPE(PERF_NETWORK); HEAP_TRACE("network"); networkService(); timeSyncService(); }
+void taskBlynk()   { PERF_SCOPE(PERF_BLYNK); HEAP_TRACE("blynk"); Blynk.run(); sendAlarmsToBlynk(); }
+void taskDisplay() { PERF_SCOPE(PERF_OLED); HEAP_TRACE("display"); updateDisplay(); }
+void taskLogs()    { HEAP_TRACE("logs"); logSystemStatus(); logSensorStatus(); }
+
+#if ENABLE_BENCH
+// ======================= Benchmarks (GET /bench) =======================
+// Each runs back to back against the live peripherals; see Bench.h
+volatile float benchSink;
+
+void benchUpdateSensors()    { updateSensors(); }
+void benchSocFromVoltage() {
+    static uint8_t step = 0;
+    benchSink = getSocFromVoltage(11.4 + (step++ % 32) * 0.05); // sweeps the whole table
+}
+void benchAddSerialLog()     { addSerialLog(F("bench")); }
+void benchDrawMainScreen()   { drawMainScreen(); }
+void benchDrawMenu()         { drawMenu(F("Main Menu"), mainMenuOptions, 2, 0); }
+void benchEepromReadFloat() {
+    // readBytes, not readFloat(): that one logs two Serial lines per call
+    float value;
+    readBytes(settingsDef(SETTING_CAPACITY).addr, (uint8_t*)&value, sizeof(value));
+    benchSink = value;
+}
+void benchEepromReadBlock() {
+    uint8_t buf[32];
+    readBytes(0, buf, sizeof(buf));
+}
 
-    // Handle buttons
-    processButtons();
+void setupBenchmarks() {
+    benchRegister("update_sensors", benchUpdateSensors);
+    benchRegister("soc_from_voltage", benchSocFromVoltage);
+    benchRegister("add_serial_log", benchAddSerialLog);
+    benchRegister("draw_main_screen", benchDrawMainScreen);
+    benchRegister("draw_menu", benchDrawMenu);
+    benchRegister("eeprom_read_float", benchEepromReadFloat);
+    benchRegister("eeprom_read_32b", benchEepromReadBlock);
+    registerServerBenchmarks();
+}
+#endif
+
+void setupTasks() {
+    //                name       fn           priority          period ms  deadline ms  budget us
+    schedulerAddTask("sample",  taskSample,  TASK_PRIO_HARD,   0,         20,          12000);
+    schedulerAddTask("i2c",     taskI2CBus,  TASK_PRIO_HIGH,   0,         50,          I2C_SERVICE_BUDGET_US + 500);
+    schedulerAddTask("timers",  taskTimers,  TASK_PRIO_HIGH,   0,         100,         5000);
+    schedulerAddTask("buttons", taskButtons, TASK_PRIO_NORMAL, 0,         50,          5000);
+    schedulerAddTask("http",    taskHttp,    TASK_PRIO_NORMAL, 0,         100,         20000);
+    schedulerAddTask("network", taskNetwork, TASK_PRIO_NORMAL, 50,        250,         2000);
+    schedulerAddTask("blynk",   taskBlynk,   TASK_PRIO_NORMAL, 0,         250,         10000);
+    schedulerAddTask("display", taskDisplay, TASK_PRIO_LOW,    20,        400,         15000);
+    schedulerAddTask("logs",    taskLogs,    TASK_PRIO_LOW,    10000,     2000,        20000);
+}
 
-    // Keep server responsive after UI handling
-    server.handleClient();
-    yield();
+void loop() {
+    uptimeMillis = millis();
+    uptimeSeconds = uptimeMillis / 1000;
+
+    stallWatchFeed();
+    PERF_SCOPE(PERF_LOOP);
+    schedulerRun();
 }
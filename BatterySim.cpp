@@ -0,0 +1,254 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : BatterySim.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Battery, load and sensor models on a virtual clock (see BatterySim.h).
+*/
+
+#include "BatterySim.h"
+
+#if BATTERY_SIM
+
+#include "AppServer.h"
+#include "EEPROMUtils.h"
+
+extern float soc; // firmware's estimate, compared against the model
+
+// ======================= Model parameters =======================
+const float SIM_R_SERIES = 0.02f;          // ohm
+const float SIM_R_POLAR = 0.015f;          // ohm, RC branch
+const float SIM_TAU_POLAR_S = 1200.0f;     // 20 min relaxation
+const float SIM_NOISE_A = 0.03f;           // sensor noise, peak
+const uint32_t SIM_ERROR_SAMPLE_MS = 60000UL;
+const uint32_t SIM_DAY_MS = 86400000UL;
+const uint16_t SIM_EEPROM_SIZE = 4096;     // AT24C32
+const uint8_t SIM_EEPROM_PAGE = 32;
+const uint16_t SIM_EEPROM_PAGES = SIM_EEPROM_SIZE / SIM_EEPROM_PAGE;
+
+// Open-circuit voltage vs SOC (12 V lead-acid, same shape the firmware assumes)
+static const float ocvTable[][2] = {
+  {0.0, 11.4}, {10.0, 11.5}, {20.0, 11.6}, {30.0, 11.8}, {40.0, 11.9},
+  {50.0, 12.0}, {60.0, 12.2}, {70.0, 12.3}, {80.0, 12.4}, {90.0, 12.5}, {100.0, 12.7}
+};
+static const int ocvPoints = sizeof(ocvTable) / sizeof(ocvTable[0]);
+
+// ======================= State =======================
+struct SimJob {
+  uint32_t periodMs;
+  uint32_t nextMs;
+  void (*fn)();
+};
+
+static SimJob jobs[SIM_MAX_JOBS];
+static uint8_t jobCount = 0;
+
+static uint32_t realStartMs = 0;
+static uint32_t virtualMs = 0;
+static uint32_t startUnix = 0;
+static uint32_t rng = 0x2545F491;
+
+static float sensorZeroMv = 0;
+static float sensorMvPerAmp = 1;
+
+static float chargeAs = 0;       // true charge, ampere-seconds
+static float currentA = 0;       // true battery current (+ = charging)
+static float polarV = 0;         // RC branch voltage
+
+static uint32_t nextErrorSampleMs = 0;
+static double errorSqSum = 0;
+static uint32_t errorSamples = 0;
+static uint32_t lastReportedDay = 0;
+
+static uint8_t eepromImage[SIM_EEPROM_SIZE];
+static uint32_t eepromPageValid[SIM_EEPROM_PAGES / 32];
+static uint32_t eepromPageWrites[SIM_EEPROM_PAGES];
+
+static SimReport report;
+
+// ======================= Helpers =======================
+static float noise() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return ((rng & 0xFFFF) / 32768.0f - 1.0f); // -1 .. +1
+}
+
+static float capacityAs() {
+  return SIM_CAPACITY_AH * 3600.0f;
+}
+
+static float trueSoc() {
+  return chargeAs / capacityAs() * 100.0f;
+}
+
+static float ocvFromSoc(float s) {
+  if (s <= ocvTable[0][0]) return ocvTable[0][1];
+  for (int i = 1; i < ocvPoints; i++) {
+    if (s <= ocvTable[i][0]) {
+      float f = (s - ocvTable[i - 1][0]) / (ocvTable[i][0] - ocvTable[i - 1][0]);
+      return ocvTable[i - 1][1] + f * (ocvTable[i][1] - ocvTable[i - 1][1]);
+    }
+  }
+  return ocvTable[ocvPoints - 1][1];
+}
+
+// Daily profile: solar charge 09-15, evening load 19-22, small standby
+// drain overnight (below the firmware's dead zone, so only idle SOC
+// correction can catch it), idle otherwise.
+static float loadProfileA(uint32_t secondOfDay) {
+  float hour = secondOfDay / 3600.0f;
+  if (hour >= 9 && hour < 15) {
+    float clouds = (noise() > 0.9f) ? 0.5f : 1.0f;
+    return 1.5f * clouds;
+  }
+  if (hour >= 19 && hour < 22) return -1.2f;
+  if (hour >= 22 || hour < 6) return -0.15f;
+  return 0.0f;
+}
+
+static bool pageValid(uint16_t page) {
+  return eepromPageValid[page / 32] & (1UL << (page % 32));
+}
+
+static void sampleError() {
+  float err = soc - trueSoc();
+  errorSqSum += (double)err * err;
+  errorSamples++;
+  report.socError = err;
+  if (fabsf(err) > report.socErrorMaxAbs) report.socErrorMaxAbs = fabsf(err);
+}
+
+static void logDaySummary(uint32_t day) {
+  const SimReport& r = simReport();
+  addSerialLogf_P(PSTR("🧪 [SIM] day %lu: true SOC %.1f%%, est %.1f%%, err %+.1f (max %.1f), EEPROM %lu writes"),
+                (unsigned long)day, r.trueSoc, soc, r.socError, r.socErrorMaxAbs,
+                (unsigned long)r.eepromWrites);
+}
+
+// ======================= Public API =======================
+void simBegin(float zeroOffsetMv, float mvPerAmp) {
+  sensorZeroMv = zeroOffsetMv;
+  sensorMvPerAmp = mvPerAmp;
+  chargeAs = capacityAs() * SIM_START_SOC / 100.0f;
+  startUnix = DateTime(2025, 1, 1, 6, 0, 0).unixtime();
+  realStartMs = millis();
+  virtualMs = 0;
+  addSerialLogf_P(PSTR("🧪 [SIM] Battery simulator running: %.1f Ah, start SOC %.0f%%, %lu ms/step"),
+                SIM_CAPACITY_AH, SIM_START_SOC, (unsigned long)SIM_STEP_MS);
+}
+
+void simStep() {
+  float dt = SIM_STEP_MS / 1000.0f;
+  virtualMs += SIM_STEP_MS;
+
+  // Load + charger/LVD limits
+  float i = loadProfileA(((startUnix % 86400UL) + virtualMs / 1000) % 86400UL);
+  if (i > 0 && trueSoc() >= 100.0f) i = 0;   // charger cuts off when full
+  if (i < 0 && trueSoc() <= 0.0f) i = 0;     // low-voltage disconnect
+  currentA = i;
+
+  chargeAs += i * dt * (i > 0 ? SIM_CHARGE_EFFICIENCY : 1.0f);
+  chargeAs = constrain(chargeAs, 0.0f, capacityAs());
+  polarV += (i * SIM_R_POLAR - polarV) * (dt / SIM_TAU_POLAR_S);
+
+  for (uint8_t j = 0; j < jobCount; j++) {
+    if ((int32_t)(virtualMs - jobs[j].nextMs) >= 0) {
+      jobs[j].nextMs += jobs[j].periodMs;
+      jobs[j].fn();
+    }
+  }
+
+  if ((int32_t)(virtualMs - nextErrorSampleMs) >= 0) {
+    nextErrorSampleMs = virtualMs + SIM_ERROR_SAMPLE_MS;
+    sampleError();
+  }
+
+  uint32_t day = virtualMs / SIM_DAY_MS;
+  if (day != lastReportedDay) {
+    lastReportedDay = day;
+    logDaySummary(day);
+  }
+}
+
+uint32_t simMillis() {
+  return realStartMs + virtualMs;
+}
+
+void simNow(DateTime* out) {
+  *out = DateTime(startUnix + virtualMs / 1000);
+}
+
+bool simSetInterval(uint32_t periodMs, void (*fn)()) {
+  if (jobCount >= SIM_MAX_JOBS || !fn) return false;
+  jobs[jobCount].periodMs = periodMs;
+  jobs[jobCount].nextMs = virtualMs + periodMs;
+  jobs[jobCount].fn = fn;
+  jobCount++;
+  return true;
+}
+
+float simSensorMillivolts() {
+  float measured = currentA + noise() * SIM_NOISE_A;
+  return sensorZeroMv + measured * sensorMvPerAmp;
+}
+
+float simBusVoltage() {
+  return ocvFromSoc(trueSoc()) + currentA * SIM_R_SERIES + polarV;
+}
+
+// ======================= Simulated AT24C32 =======================
+// First write to a page seeds it from the real chip; after that the page
+// is served from RAM and only its wear counter moves.
+bool simEepromWritePage(uint16_t addr, const uint8_t* data, uint8_t len) {
+  if (addr + len > SIM_EEPROM_SIZE) return false;
+  uint16_t page = addr / SIM_EEPROM_PAGE;
+  if (!pageValid(page)) {
+    uint16_t base = page * SIM_EEPROM_PAGE;
+    readBytes(base, eepromImage + base, SIM_EEPROM_PAGE);
+    eepromPageValid[page / 32] |= 1UL << (page % 32);
+  }
+  memcpy(eepromImage + addr, data, len);
+  eepromPageWrites[page]++;
+  report.eepromWrites++;
+  return true;
+}
+
+void simEepromOverlay(uint16_t addr, uint8_t* buffer, size_t len) {
+  for (size_t i = 0; i < len && addr + i < SIM_EEPROM_SIZE; i++) {
+    if (pageValid((addr + i) / SIM_EEPROM_PAGE)) buffer[i] = eepromImage[addr + i];
+  }
+}
+
+// ======================= Report =======================
+void simCountIdleRecal() {
+  report.idleRecals++;
+}
+
+void simCountDailyReset() {
+  report.dailyResets++;
+}
+
+const SimReport& simReport() {
+  uint32_t realMs = millis() - realStartMs;
+  report.virtualSeconds = virtualMs / 1000;
+  report.speedup = realMs ? (float)virtualMs / realMs : 0;
+  report.trueSoc = trueSoc();
+  report.socErrorRms = errorSamples ? sqrt(errorSqSum / errorSamples) : 0;
+
+  report.eepromHotPageWrites = 0;
+  for (uint16_t p = 0; p < SIM_EEPROM_PAGES; p++) {
+    if (eepromPageWrites[p] > report.eepromHotPageWrites) {
+      report.eepromHotPageWrites = eepromPageWrites[p];
+      report.eepromHotPage = p;
+    }
+  }
+  float days = virtualMs / (float)SIM_DAY_MS;
+  float hotPerDay = days > 0 ? report.eepromHotPageWrites / days : 0;
+  report.eepromLifeYears = hotPerDay > 0 ? 1000000.0f / hotPerDay / 365.0f : 0;
+  return report;
+}
+
+#endif // BATTERY_SIM
@@ -0,0 +1,86 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : BatterySim.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for BatterySim.cpp.
+   Accelerated-time battery simulator (BATTERY_SIM builds). The normal
+   firmware runs unchanged, but the battery and its sensors are replaced
+   by a model on a virtual clock:
+   - Battery: coulomb store with charge efficiency, OCV curve, series
+     resistance and an RC polarization term (so idle voltage relaxes)
+   - Load: daily solar-charge / evening-discharge / standby profile + noise
+   - INA219 / ADS1115 return the model's terminal voltage / WCS1600 output
+   - DS3231: battery-side code reads the virtual calendar (batteryNow())
+   - AT24C32: page writes land in a RAM overlay with per-page wear counters,
+     so the real chip is never written during a run
+
+   Exposed Functions:
+   - simBegin()            → start the model (after the sensors are set up)
+   - simStep()             → advance the virtual clock one step + run due jobs
+   - simMillis(), simNow() → virtual clock for battery bookkeeping
+   - simSetInterval()      → periodic job on the virtual clock
+   - simSensorMillivolts(), simBusVoltage() → simulated sensor outputs
+   - simEepromWritePage(), simEepromOverlay() → simulated AT24C32
+   - simCountIdleRecal(), simCountDailyReset() → firmware event hooks
+   - simReport()           → SOC error, EEPROM wear, virtual time
+
+   Notes:
+   - The virtual clock only moves once the zero offset has settled
+   - Speed is SIM_STEPS_PER_PASS × SIM_STEP_MS per scheduler pass; with the
+     defaults a simulated month takes on the order of 15-30 min on the ESP
+*/
+
+#ifndef BATTERY_SIM_H
+#define BATTERY_SIM_H
+
+#include <Arduino.h>
+#include <RTClib.h>
+
+#ifndef BATTERY_SIM
+#define BATTERY_SIM 0
+#endif
+
+#define SIM_STEP_MS 100UL            // virtual time per sensor sample
+#define SIM_STEPS_PER_PASS 50        // sensor samples per scheduler pass
+#define SIM_CAPACITY_AH 7.0f         // true capacity (firmware uses its setting)
+#define SIM_CHARGE_EFFICIENCY 0.95f  // coulombs stored per coulomb charged
+#define SIM_START_SOC 80.0f
+#define SIM_MAX_JOBS 6
+
+struct SimReport {
+  uint32_t virtualSeconds;
+  float speedup;              // virtual time / real time
+  float trueSoc;
+  float socError;             // firmware SOC - true SOC (percentage points)
+  float socErrorMaxAbs;
+  float socErrorRms;
+  uint32_t idleRecals;
+  uint32_t dailyResets;
+  uint32_t eepromWrites;      // page write cycles
+  uint32_t eepromHotPageWrites;
+  uint16_t eepromHotPage;
+  float eepromLifeYears;      // hottest page at 1M cycles, at the current rate
+};
+
+#if BATTERY_SIM
+void simBegin(float zeroOffsetMv, float mvPerAmp);
+void simStep();
+uint32_t simMillis();
+void simNow(DateTime* out);
+bool simSetInterval(uint32_t periodMs, void (*fn)());
+
+float simSensorMillivolts();
+float simBusVoltage();
+
+bool simEepromWritePage(uint16_t addr, const uint8_t* data, uint8_t len);
+void simEepromOverlay(uint16_t addr, uint8_t* buffer, size_t len);
+
+void simCountIdleRecal();
+void simCountDailyReset();
+const SimReport& simReport();
+#endif
+
+#endif // BATTERY_SIM_H
@@ -0,0 +1,83 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Bench.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Microbenchmark runner (see Bench.h).
+
+   Notes:
+   - Iterations double until one batch takes BENCH_MIN_TIME_US, so cheap
+     functions get enough runs to swamp the timer overhead and slow ones
+     (I2C, serial) stop after a few calls
+*/
+
+#include "Bench.h"
+
+#if ENABLE_BENCH
+
+#include "HeapMonitor.h"
+
+struct BenchEntry {
+  const char* name;
+  BenchFn fn;
+};
+
+static BenchEntry benches[BENCH_MAX];
+static uint8_t benchTotal = 0;
+
+bool benchRegister(const char* name, BenchFn fn) {
+  if (benchTotal >= BENCH_MAX || !fn) return false;
+  benches[benchTotal].name = name;
+  benches[benchTotal].fn = fn;
+  benchTotal++;
+  return true;
+}
+
+uint8_t benchCount() {
+  return benchTotal;
+}
+
+const char* benchName(uint8_t index) {
+  return index < benchTotal ? benches[index].name : "";
+}
+
+// Cycle count for `iterations` back-to-back calls
+static uint32_t timeBatch(BenchFn fn, uint32_t iterations) {
+  uint32_t start = ESP.getCycleCount();
+  for (uint32_t i = 0; i < iterations; i++) fn();
+  return ESP.getCycleCount() - start;
+}
+
+bool benchRun(uint8_t index, BenchResult* out) {
+  if (index >= benchTotal) return false;
+  BenchFn fn = benches[index].fn;
+  uint32_t cyclesPerUs = ESP.getCpuFreqMHz();
+
+  fn(); // warm-up: first-call statics, flash cache
+  yield();
+
+  uint32_t iterations = 1;
+  uint32_t cycles = 0;
+  uint32_t allocsBefore = 0;
+  int32_t heapBefore = 0;
+  while (true) {
+    heapBefore = (int32_t)ESP.getFreeHeap();
+    allocsBefore = heapAllocCount();
+    cycles = timeBatch(fn, iterations);
+    if (cycles / cyclesPerUs >= BENCH_MIN_TIME_US || iterations >= BENCH_MAX_ITERATIONS) break;
+    iterations *= 2;
+    yield();
+  }
+
+  out->name = benches[index].name;
+  out->iterations = iterations;
+  out->nsPerOp = (float)cycles * 1000.0f / cyclesPerUs / iterations;
+  out->allocsPerOp = (float)(heapAllocCount() - allocsBefore) / iterations;
+  out->heapDelta = (int32_t)ESP.getFreeHeap() - heapBefore;
+  yield();
+  return true;
+}
+
+#endif // ENABLE_BENCH
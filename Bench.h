@@ -0,0 +1,56 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Bench.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Bench.cpp.
+   On-device microbenchmarks for the firmware's hot functions. Each
+   benchmark is a plain function that is called in a loop until it has
+   run for at least BENCH_MIN_TIME_US. The result is cycle-accurate
+   ns/op and, with HEAP_DEBUG, allocations/op.
+
+   Exposed Functions:
+   - benchRegister()   → add a benchmark (call from setup())
+   - benchCount(), benchName()
+   - benchRun()        → run one benchmark and fill a BenchResult
+
+   Notes:
+   - Only compiled in with ENABLE_BENCH 1; results are served by GET /bench
+     in Google Benchmark's JSON layout so existing compare tools can diff runs
+   - Benchmarks run against the real peripherals and block the loop while
+     they run (sampling included): use on a bench unit, not in the field
+*/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+
+#ifndef ENABLE_BENCH
+#define ENABLE_BENCH 0
+#endif
+
+#define BENCH_MAX 16
+#define BENCH_MIN_TIME_US 20000UL       // per benchmark
+#define BENCH_MAX_ITERATIONS 100000UL
+
+typedef void (*BenchFn)();
+
+struct BenchResult {
+  const char* name;
+  uint32_t iterations;
+  float nsPerOp;
+  float allocsPerOp;     // 0 unless HEAP_DEBUG
+  int32_t heapDelta;     // free heap after - before (negative = retained)
+};
+
+#if ENABLE_BENCH
+bool benchRegister(const char* name, BenchFn fn);
+uint8_t benchCount();
+const char* benchName(uint8_t index);
+bool benchRun(uint8_t index, BenchResult* out);
+#endif
+
+#endif // BENCH_H
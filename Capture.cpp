@@ -0,0 +1,128 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Capture.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Burst capture buffer and state (see Capture.h). The acquisition loop
+   itself lives next to the other sensor reads in BatteryMonitor.ino.
+*/
+
+#include "Capture.h"
+#include "MemoryConfig.h"
+#include "AppServer.h"
+
+static CaptureSample buffer[MEM.captureSamples];   // preallocated, never on the heap
+static CaptureHeader header;
+static CaptureState state = CAPTURE_IDLE;
+static uint16_t requestedWindowMs = 0;
+static uint8_t requestedVoltageEvery = 1;
+static void (*scaleSource)(CaptureScales* out) = nullptr;
+
+void captureSetScaleSource(void (*source)(CaptureScales* out)) {
+  scaleSource = source;
+}
+
+CaptureScales captureScales() {
+  CaptureScales sc = { 1.0, 0.0, 0.004, 0.0 }; // raw counts, INA219 4 mV LSB
+  if (scaleSource) scaleSource(&sc);
+  return sc;
+}
+
+// Common part of burst and triggered headers
+void fillCaptureHeader(CaptureHeader* h, uint32_t startUnix, uint8_t trigger, uint8_t sampleBytes) {
+  CaptureScales sc = captureScales();
+  memset(h, 0, sizeof(*h));
+  h->magic = CAPTURE_MAGIC;
+  h->version = CAPTURE_VERSION;
+  h->startUnix = startUnix;
+  h->currentScale = sc.currentScale;
+  h->currentOffset = sc.currentOffset;
+  h->voltageScale = sc.voltageScale;
+  h->voltageOffset = sc.voltageOffset;
+  h->trigger = trigger;
+  h->sampleBytes = sampleBytes;
+}
+
+bool captureRequest(uint16_t windowMs, uint8_t voltageEvery) {
+  if (state == CAPTURE_REQUESTED || state == CAPTURE_RUNNING) return false;
+  if (windowMs == 0 || windowMs > captureMaxWindowMs() || voltageEvery == 0) return false;
+  requestedWindowMs = windowMs;
+  requestedVoltageEvery = voltageEvery;
+  state = CAPTURE_REQUESTED;
+  return true;
+}
+
+bool captureRequested() {
+  return state == CAPTURE_REQUESTED;
+}
+
+uint16_t captureWindowMs() {
+  return requestedWindowMs;
+}
+
+uint8_t captureVoltageEvery() {
+  return requestedVoltageEvery;
+}
+
+uint16_t captureCapacity() {
+  return MEM.captureSamples;
+}
+
+uint16_t captureMaxWindowMs() {
+  uint32_t bufferMs = (uint32_t)MEM.captureSamples * 1000UL / CAPTURE_SAMPLE_RATE_HZ;
+  return (uint16_t)min(bufferMs, (uint32_t)CAPTURE_MAX_WINDOW_MS);
+}
+
+void captureStart(uint32_t startUnix) {
+  fillCaptureHeader(&header, startUnix, 0, sizeof(CaptureSample));
+  header.voltageEvery = requestedVoltageEvery;
+  header.sampleRateHz = CAPTURE_SAMPLE_RATE_HZ;
+  header.windowMs = requestedWindowMs;
+  state = CAPTURE_RUNNING;
+}
+
+bool captureAdd(int16_t currentRaw, uint16_t voltageRaw) {
+  if (header.count >= MEM.captureSamples) return false;
+  buffer[header.count].currentRaw = currentRaw;
+  buffer[header.count].voltageRaw = voltageRaw;
+  header.count++;
+  return true;
+}
+
+void captureFinish(uint32_t durationUs) {
+  header.durationUs = durationUs;
+  state = CAPTURE_DONE;
+  addSerialLogf_P(PSTR("📈 Burst capture: %u samples in %lu us"),
+                  header.count, (unsigned long)durationUs);
+}
+
+void captureAbort() {
+  header.count = 0;
+  state = CAPTURE_FAILED;
+  addSerialLog(F("⚠️ Burst capture failed (ADS1115 not answering)"));
+}
+
+CaptureState captureState() {
+  return state;
+}
+
+const CaptureHeader& captureHeader() {
+  return header;
+}
+
+const CaptureSample* captureSamples() {
+  return buffer;
+}
+
+const char* captureStateName(CaptureState s) {
+  switch (s) {
+    case CAPTURE_IDLE:      return "idle";
+    case CAPTURE_REQUESTED: return "requested";
+    case CAPTURE_RUNNING:   return "running";
+    case CAPTURE_DONE:      return "done";
+    case CAPTURE_FAILED:    return "failed";
+    default:                return "?";
+  }
+}
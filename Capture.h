@@ -0,0 +1,106 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Capture.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Capture.cpp.
+   On-demand burst capture for inrush / surge analysis. The normal
+   current path averages 100 single-shot ADS1115 reads, which hides
+   anything shorter than a second; a burst runs the ADS1115 continuously
+   at 860 SPS into a preallocated buffer, each sample paired with the
+   latest INA219 bus voltage, and keeps it for download as a binary blob.
+
+   Exposed Functions:
+   - captureRequest(windowMs, voltageEvery) → arm a burst (POST /capture)
+   - captureRequested()     → polled by the sampler, which runs the burst
+   - captureSetScaleSource() → raw → amps/volts conversion (BatteryMonitor.ino)
+   - captureStart() / captureAdd() / captureFinish() / captureAbort()
+                            → used by the acquisition loop (BatteryMonitor.ino)
+   - captureState(), captureHeader(), captureSamples() → GET /capture
+
+   Notes:
+   - Blob = CaptureHeader followed by header.count samples of
+     header.sampleBytes each, little-endian, packed (triggered captures,
+     see Trigger.h, use the same header with 6-byte TriggerSample records):
+       amps  = currentRaw * currentScale + currentOffset
+       volts = voltageRaw * voltageScale + voltageOffset
+   - The burst blocks the loop for its window (WiFi gets no time either),
+     so CAPTURE_MAX_WINDOW_MS stays below the stall threshold (StallWatch.h);
+     SOC integration runs inside it from the captured samples
+   - Buffer size comes from the memory profile (MEM.captureSamples) and
+     limits the window further (captureMaxWindowMs())
+   - An ADS1115 read failure mid-window fails the whole capture
+*/
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <Arduino.h>
+
+#define CAPTURE_SAMPLE_RATE_HZ 860      // ADS1115 maximum data rate
+#define CAPTURE_MAX_WINDOW_MS 800       // < STALL_THRESHOLD_MS
+#define CAPTURE_MAGIC 0x50414342UL      // "BCAP"
+#define CAPTURE_VERSION 2
+
+enum CaptureState : uint8_t {
+  CAPTURE_IDLE,        // nothing captured yet
+  CAPTURE_REQUESTED,   // waiting for the sampler
+  CAPTURE_RUNNING,
+  CAPTURE_DONE,        // blob ready
+  CAPTURE_FAILED       // ADS1115 unavailable or stopped answering
+};
+
+struct __attribute__((packed)) CaptureSample {
+  int16_t currentRaw;   // ADS1115 conversion register
+  uint16_t voltageRaw;  // INA219 bus voltage register >> 3 (4 mV LSB)
+};
+
+struct __attribute__((packed)) CaptureHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t voltageEvery;   // INA219 read every N samples (others repeat it)
+  uint16_t sampleRateHz;  // nominal; count / durationUs is the real rate
+  uint16_t count;
+  uint16_t windowMs;
+  uint32_t startUnix;
+  uint32_t durationUs;
+  float currentScale;     // A per count
+  float currentOffset;    // A
+  float voltageScale;     // V per count
+  float voltageOffset;    // V
+  uint8_t trigger;        // TriggerType; 0 = manual burst
+  uint8_t sampleBytes;    // size of one sample record
+  uint16_t preSamples;    // samples before the trigger (0 for bursts)
+};
+
+struct CaptureScales {
+  float currentScale;
+  float currentOffset;
+  float voltageScale;
+  float voltageOffset;
+};
+
+bool captureRequest(uint16_t windowMs, uint8_t voltageEvery);
+bool captureRequested();
+uint16_t captureWindowMs();
+uint8_t captureVoltageEvery();
+uint16_t captureCapacity();
+uint16_t captureMaxWindowMs();   // buffer and stall limits
+
+void captureSetScaleSource(void (*source)(CaptureScales* out));
+CaptureScales captureScales();
+void fillCaptureHeader(CaptureHeader* h, uint32_t startUnix, uint8_t trigger, uint8_t sampleBytes);
+
+void captureStart(uint32_t startUnix);
+bool captureAdd(int16_t currentRaw, uint16_t voltageRaw);   // false = buffer full
+void captureFinish(uint32_t durationUs);
+void captureAbort();
+
+CaptureState captureState();
+const CaptureHeader& captureHeader();
+const CaptureSample* captureSamples();
+const char* captureStateName(CaptureState s);
+
+#endif // CAPTURE_H
@@ -12,52 +12,112 @@
    - writeFloat() / readFloat()
    - writeInt() / readInt()
    - writeString() / readString()
+   - writeBytes() / readBytes()
+   - eepromWritePage() / eepromReady()  (used by the I2C arbiter)
 
    Notes:
    - Values stored at predefined addresses (see AppServer.cpp)
    - Used for WiFi credentials, calibration values, SOC, thresholds, etc.
+   - Writes go through I2CBus: page-chunked, queued once the main loop runs
+   - Reads see queued-but-unwritten bytes, so read-after-write is consistent
+   - BATTERY_SIM builds write to a RAM overlay instead of the chip (BatterySim.cpp)
 */
 
 #include "EEPROMUtils.h"
+#include "I2CBus.h"
+#include "BatterySim.h"
 #include <Wire.h>
 
 const uint8_t EEPROM_ADDR = 0x57; // AT24C32 I2C Address
+const uint8_t EEPROM_READ_CHUNK = 32;
+
+// ------------------ Raw page write (single transaction) ------------------
+// Caller guarantees len fits the Wire buffer and does not cross a page.
+bool eepromWritePage(uint16_t addr, const uint8_t* data, uint8_t len) {
+#if BATTERY_SIM
+    return simEepromWritePage(addr, data, len); // accelerated runs must not wear the real chip
+#endif
+    I2CTransaction t(I2C_DEV_EEPROM);
+    Wire.beginTransmission(EEPROM_ADDR);
+    Wire.write((uint8_t)(addr >> 8));
+    Wire.write((uint8_t)(addr & 0xFF));
+    Wire.write(data, len);
+    return Wire.endTransmission() == 0;
+}
+
+// ------------------ Write-cycle ACK poll ------------------
+bool eepromReady() {
+#if BATTERY_SIM
+    return true;
+#endif
+    I2CTransaction t(I2C_DEV_EEPROM);
+    Wire.beginTransmission(EEPROM_ADDR);
+    return Wire.endTransmission() == 0;
+}
+
+// ------------------ Bytes Write ------------------
+void writeBytes(uint16_t addr, const uint8_t* data, size_t len) {
+    i2cQueueEepromWrite(addr, data, len);
+}
+
+// ------------------ Read address phase ------------------
+// An AT24C32 in its internal write cycle NACKs its address (error 2).
+// That is "busy", not a fault: poll until the write timeout instead of
+// counting it towards quarantine.
+static uint8_t eepromSelectRead(uint16_t addr) {
+    uint32_t startUs = micros();
+    while (true) {
+        Wire.beginTransmission(EEPROM_ADDR);
+        Wire.write((uint8_t)(addr >> 8));
+        Wire.write((uint8_t)(addr & 0xFF));
+        uint8_t err = Wire.endTransmission();
+        if (err != 2 || micros() - startUs > I2C_EEPROM_WRITE_TIMEOUT_US) return err;
+        delayMicroseconds(200);
+    }
+}
+
+// ------------------ Bytes Read ------------------
+void readBytes(uint16_t addr, uint8_t* buffer, size_t len) {
+    if (i2cDeviceAvailable(I2C_DEV_EEPROM)) i2cEepromWaitIdle();
+    size_t done = 0;
+    while (done < len) {
+        uint8_t n = (uint8_t)min<size_t>(len - done, EEPROM_READ_CHUNK);
+        uint16_t a = addr + done;
+        if (!i2cDeviceAvailable(I2C_DEV_EEPROM)) {
+            memset(buffer + done, 0xFF, n); // reads like erased EEPROM
+        } else {
+            I2CTransaction t(I2C_DEV_EEPROM);
+            uint8_t err = eepromSelectRead(a);
+            uint8_t got = (err == 0) ? Wire.requestFrom((uint8_t)EEPROM_ADDR, n) : 0;
+            i2cReportResult(I2C_DEV_EEPROM, got == n, err ? err : 4);
+            for (uint8_t i = 0; i < n; i++) {
+                buffer[done + i] = (i < got && Wire.available()) ? Wire.read() : 0xFF;
+            }
+        }
+        done += n;
+    }
+#if BATTERY_SIM
+    simEepromOverlay(addr, buffer, len);
+#endif
+    i2cEepromOverlay(addr, buffer, len);
+}
 
 // ------------------ Float Write ------------------
 void writeFloat(uint16_t addr, float value) {
-    Serial.print("💾 Writing to DS3231 EEPROM @ ");
+    Serial.print(F("💾 Writing to DS3231 EEPROM @ "));
     Serial.print(addr);
-    Serial.print(" -> ");
+    Serial.print(F(" -> "));
     Serial.println(value, 4); // show with 4 decimal places
 
-    byte* p = (byte*)&value;
-    for (int i = 0; i < 4; i++) {
-        Wire.beginTransmission(EEPROM_ADDR);
-        Wire.write((uint8_t)((addr + i) >> 8));
-        Wire.write((uint8_t)((addr + i) & 0xFF));
-        Wire.write(p[i]);
-        Wire.endTransmission();
-        delay(5);
-    }
+    writeBytes(addr, (const uint8_t*)&value, 4);
 }
 
 // ------------------ Float Read (Pointer) ------------------
 void readFloat(uint16_t addr, float* value) {
-    Serial.print("📖 Reading from DS3231 EEPROM @ ");
+    Serial.print(F("📖 Reading from DS3231 EEPROM @ "));
     Serial.println(addr);
 
-    byte data[4];
-    for (int i = 0; i < 4; i++) {
-        Wire.beginTransmission(EEPROM_ADDR);
-        Wire.write((uint8_t)((addr + i) >> 8));
-        Wire.write((uint8_t)((addr + i) & 0xFF));
-        Wire.endTransmission();
-        Wire.requestFrom((uint8_t)EEPROM_ADDR, (uint8_t)1);
-        if (Wire.available()) {
-            data[i] = Wire.read();
-        }
-    }
-    memcpy(value, data, 4);
+    readBytes(addr, (uint8_t*)value, 4);
 }
 
 // ------------------ Float Read (Return) ------------------
@@ -69,31 +129,12 @@ float readFloat(uint16_t addr) {
 
 // ------------------ Int Write ------------------
 void writeInt(uint16_t addr, uint32_t value) {
-    byte* p = (byte*)&value;
-    for (int i = 0; i < 4; i++) {
-        Wire.beginTransmission(EEPROM_ADDR);
-        Wire.write((uint8_t)((addr + i) >> 8));
-        Wire.write((uint8_t)((addr + i) & 0xFF));
-        Wire.write(p[i]);
-        Wire.endTransmission();
-        delay(5);
-    }
+    writeBytes(addr, (const uint8_t*)&value, 4);
 }
 
 // ------------------ Int Read (Pointer) ------------------
 void readInt(uint16_t addr, uint32_t* value) {
-    byte data[4];
-    for (int i = 0; i < 4; i++) {
-        Wire.beginTransmission(EEPROM_ADDR);
-        Wire.write((uint8_t)((addr + i) >> 8));
-        Wire.write((uint8_t)((addr + i) & 0xFF));
-        Wire.endTransmission();
-        Wire.requestFrom((uint8_t)EEPROM_ADDR, (uint8_t)1);
-        if (Wire.available()) {
-            data[i] = Wire.read();
-        }
-    }
-    memcpy(value, data, 4);
+    readBytes(addr, (uint8_t*)value, 4);
 }
 
 // ------------------ Int Read (Return) ------------------
@@ -105,28 +146,14 @@ uint32_t readInt(uint16_t addr) {
 
 // ------------------ Write String ------------------
 void writeString(uint16_t addr, const char* value) {
-    Wire.beginTransmission(EEPROM_ADDR);
-    Wire.write((uint8_t)(addr >> 8));
-    Wire.write((uint8_t)(addr & 0xFF));
-    for (int i = 0; i < strlen(value); i++) {
-        Wire.write(value[i]);
-    }
-    Wire.write(0x00); // Null terminator
-    Wire.endTransmission();
-    delay(5);
+    writeBytes(addr, (const uint8_t*)value, strlen(value) + 1); // include null terminator
 }
 
 // ------------------ Read String ------------------
 void readString(uint16_t addr, char* buffer, size_t size) {
-    Wire.beginTransmission(EEPROM_ADDR);
-    Wire.write((uint8_t)(addr >> 8));
-    Wire.write((uint8_t)(addr & 0xFF));
-    Wire.endTransmission();
-
-    Wire.requestFrom((uint8_t)EEPROM_ADDR, (uint8_t)size);
-    int i = 0;
-    while (Wire.available() && i < size - 1) {
-        buffer[i++] = Wire.read();
-    }
+    readBytes(addr, (uint8_t*)buffer, size - 1);
+    buffer[size - 1] = '\0';
+    size_t i = 0;
+    while (i < size - 1 && buffer[i] != '\0') i++;
     buffer[i] = '\0'; // Null-terminate
 }
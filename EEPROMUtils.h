@@ -13,6 +13,7 @@
    - writeFloat(), readFloat()
    - writeInt(), readInt()
    - writeString(), readString()
+   - writeBytes(), readBytes()
 
    Notes:
    - Works with AT24C32 I2C EEPROM
@@ -36,4 +37,12 @@ void readString(uint16_t addr, char* buffer, size_t size);
 float readFloat(uint16_t addr);
 uint32_t readInt(uint16_t addr);
 
+// Raw byte ranges (page-safe, any length)
+void writeBytes(uint16_t addr, const uint8_t* data, size_t len);
+void readBytes(uint16_t addr, uint8_t* buffer, size_t len);
+
+// Low-level helpers for the I2C arbiter (I2CBus.cpp)
+bool eepromWritePage(uint16_t addr, const uint8_t* data, uint8_t len);
+bool eepromReady();
+
 #endif // EEPROM_UTILS_H
@@ -0,0 +1,80 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Extremes.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Per-interval min / max trackers (see Extremes.h).
+*/
+
+#include "Extremes.h"
+
+static Extremes intervals[EXTREMES_INTERVAL_COUNT];
+static bool intervalsInitialized = false;
+
+// ======================= Building blocks =======================
+static inline void minMaxReset(MinMax& m) {
+  m.lo = INFINITY;
+  m.hi = -INFINITY;
+}
+
+// NaN fails both compares and is skipped
+static inline void minMaxAdd(MinMax& m, float x) {
+  if (x < m.lo) m.lo = x;
+  if (x > m.hi) m.hi = x;
+}
+
+void extremesReset(Extremes& e) {
+  minMaxReset(e.voltage);
+  minMaxReset(e.current);
+  minMaxReset(e.power);
+}
+
+void extremesAdd(Extremes& e, float voltage, float current) {
+  minMaxAdd(e.voltage, voltage);
+  minMaxAdd(e.current, current);
+  minMaxAdd(e.power, voltage * current);
+}
+
+void extremesMerge(Extremes& into, const Extremes& from) {
+  minMaxAdd(into.voltage, from.voltage.lo);
+  minMaxAdd(into.voltage, from.voltage.hi);
+  minMaxAdd(into.current, from.current.lo);
+  minMaxAdd(into.current, from.current.hi);
+  minMaxAdd(into.power, from.power.lo);
+  minMaxAdd(into.power, from.power.hi);
+}
+
+bool extremesValid(const MinMax& m) {
+  return m.hi >= m.lo;
+}
+
+float extremesPeakToPeak(const MinMax& m) {
+  return extremesValid(m) ? m.hi - m.lo : NAN;
+}
+
+// ======================= Reporting intervals =======================
+static void initIntervals() {
+  for (uint8_t i = 0; i < EXTREMES_INTERVAL_COUNT; i++) extremesReset(intervals[i]);
+  intervalsInitialized = true;
+}
+
+void extremesAddSample(float voltage, float current) {
+  if (!intervalsInitialized) initIntervals();
+  for (uint8_t i = 0; i < EXTREMES_INTERVAL_COUNT; i++) {
+    extremesAdd(intervals[i], voltage, current);
+  }
+}
+
+Extremes extremesTake(ExtremesInterval interval) {
+  if (!intervalsInitialized) initIntervals();
+  Extremes e = intervals[interval];
+  extremesReset(intervals[interval]);
+  return e;
+}
+
+Extremes extremesPeek(ExtremesInterval interval) {
+  if (!intervalsInitialized) initIntervals();
+  return intervals[interval];
+}
@@ -0,0 +1,61 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Extremes.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Extremes.cpp.
+   Min / max / peak-to-peak of voltage, current and power per reporting
+   interval. /live_data and Blynk only see the averaged current and the
+   smoothed voltage; the extremes are folded in from every raw sample
+   of the acquisition path, so short peaks and sags still show up.
+
+   Exposed Functions:
+   - extremesAddSample()     → one raw sample into every open interval
+   - extremesTake(interval)  → copy an interval and start the next one
+   - extremesPeek(interval)  → copy without restarting (benchmarks)
+   - extremesReset(), extremesAdd(), extremesMerge() → building blocks (History.cpp)
+   - extremesValid(), extremesPeakToPeak()
+
+   Notes:
+   - Constant cost per sample: two compares per signal per interval
+   - Samples are raw (no averaging, no dead zone); NaN voltage (INA219
+     down) only skips voltage and power
+   - An empty range has lo = +inf / hi = -inf; JsonWriter prints both as null
+*/
+
+#ifndef EXTREMES_H
+#define EXTREMES_H
+
+#include <Arduino.h>
+
+enum ExtremesInterval {
+  EXTREMES_LIVE_DATA = 0,   // since the previous GET /live_data
+  EXTREMES_BLYNK,           // since the previous Blynk push
+  EXTREMES_INTERVAL_COUNT
+};
+
+struct MinMax {
+  float lo;
+  float hi;
+};
+
+struct Extremes {
+  MinMax voltage;   // V
+  MinMax current;   // A (+charge / -discharge)
+  MinMax power;     // W
+};
+
+void extremesReset(Extremes& e);
+void extremesAdd(Extremes& e, float voltage, float current);
+void extremesMerge(Extremes& into, const Extremes& from);
+
+bool extremesValid(const MinMax& m);
+float extremesPeakToPeak(const MinMax& m);   // NaN if empty
+
+void extremesAddSample(float voltage, float current);
+Extremes extremesTake(ExtremesInterval interval);
+Extremes extremesPeek(ExtremesInterval interval);
+
+#endif // EXTREMES_H
@@ -0,0 +1,161 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Forecast.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Weekday / hour-of-day load profile and the time-to-empty projection
+   (see Forecast.h).
+*/
+
+#include "Forecast.h"
+#include "EEPROMUtils.h"
+#include "AppServer.h"
+
+#define FORECAST_MAGIC 0x54534346UL    // "FCST"
+
+const uint8_t MIN_MINUTES_PER_HOUR = 30;
+const float RECENT_ALPHA = 0.2;      // recent current, per minute (~5 min)
+
+static int16_t profile[FORECAST_DAYS][FORECAST_HOURS];   // 0.01 A, +charge / -discharge
+static uint8_t knownSlots = 0;
+
+// The hour being collected
+static int8_t hourDay = -1;
+static int8_t hourOfDay = -1;
+static float hourSum = 0;
+static uint8_t hourMinutes = 0;
+
+static float recentA = NAN;
+static float runtimeMinutes = NAN;
+
+// ======================= Profile =======================
+static uint16_t slotAddr(uint8_t day, uint8_t hour) {
+  return ADDR_FORECAST + 4 + (day * FORECAST_HOURS + hour) * sizeof(int16_t);
+}
+
+void forecastLoad() {
+  uint32_t magic = 0;
+  readBytes(ADDR_FORECAST, (uint8_t*)&magic, sizeof(magic));
+  knownSlots = 0;
+  if (magic == FORECAST_MAGIC) {
+    readBytes(ADDR_FORECAST + 4, (uint8_t*)profile, sizeof(profile));
+    for (uint8_t d = 0; d < FORECAST_DAYS; d++) {
+      for (uint8_t h = 0; h < FORECAST_HOURS; h++) {
+        if (profile[d][h] != FORECAST_UNKNOWN) knownSlots++;
+      }
+    }
+    addSerialLogf_P(PSTR("🔮 Runtime forecast: %u of %u hour slots learned"),
+                    knownSlots, FORECAST_DAYS * FORECAST_HOURS);
+    return;
+  }
+  // Blank chip: write an empty profile once so later single-slot writes are valid
+  for (uint8_t d = 0; d < FORECAST_DAYS; d++) {
+    for (uint8_t h = 0; h < FORECAST_HOURS; h++) profile[d][h] = FORECAST_UNKNOWN;
+  }
+  magic = FORECAST_MAGIC;
+  writeBytes(ADDR_FORECAST + 4, (const uint8_t*)profile, sizeof(profile));
+  writeBytes(ADDR_FORECAST, (const uint8_t*)&magic, sizeof(magic));
+}
+
+// Fold the finished hour into its slot
+static void closeHour() {
+  if (hourOfDay >= 0 && hourMinutes >= MIN_MINUTES_PER_HOUR) {
+    float avg = hourSum / hourMinutes;
+    int16_t& slot = profile[hourDay][hourOfDay];
+    float next = avg;
+    if (slot == FORECAST_UNKNOWN) {
+      knownSlots++;
+    } else {
+      next = slot / 100.0f + FORECAST_ALPHA * (avg - slot / 100.0f);
+    }
+    slot = (int16_t)constrain(lroundf(next * 100.0f), -32767L, 32767L);
+    writeBytes(slotAddr(hourDay, hourOfDay), (const uint8_t*)&slot, sizeof(slot));
+  }
+  hourSum = 0;
+  hourMinutes = 0;
+}
+
+void forecastAddMinute(uint8_t dayOfWeek, uint8_t hour, float currentA) {
+  if (dayOfWeek >= FORECAST_DAYS || hour >= FORECAST_HOURS) return;
+  if (dayOfWeek != hourDay || hour != hourOfDay) {
+    closeHour();
+    hourDay = dayOfWeek;
+    hourOfDay = hour;
+  }
+  hourSum += currentA;
+  if (hourMinutes < 255) hourMinutes++;
+
+  recentA = isnan(recentA) ? currentA : recentA + RECENT_ALPHA * (currentA - recentA);
+}
+
+// Slot → same hour on the other weekdays → recent current
+static float slotCurrent(uint8_t day, uint8_t hour) {
+  if (profile[day][hour] != FORECAST_UNKNOWN) return profile[day][hour] / 100.0f;
+  float sum = 0;
+  uint8_t n = 0;
+  for (uint8_t d = 0; d < FORECAST_DAYS; d++) {
+    if (profile[d][hour] == FORECAST_UNKNOWN) continue;
+    sum += profile[d][hour] / 100.0f;
+    n++;
+  }
+  return n ? sum / n : recentA;
+}
+
+// ======================= Projection =======================
+// Walk forward hour by hour from now, draining (or charging, up to full)
+// the remaining Ah with each hour's expected current.
+void forecastUpdate(uint8_t dayOfWeek, uint8_t hour, uint8_t minute,
+                    float socPercent, float capacityAh) {
+  if (dayOfWeek >= FORECAST_DAYS || hour >= FORECAST_HOURS || isnan(recentA)) {
+    runtimeMinutes = NAN;
+    return;
+  }
+  float remainingAh = constrain(socPercent, 0.0f, 100.0f) / 100.0f * capacityAh;
+  float elapsedH = 0;
+  float stepH = (60 - minute) / 60.0f;   // rest of the current hour first
+
+  for (uint16_t step = 0; step <= FORECAST_HORIZON_H; step++) {
+    float amps = slotCurrent(dayOfWeek, hour);
+    if (step == 0 && hourMinutes > 0 && hourDay == dayOfWeek && hourOfDay == hour &&
+        profile[dayOfWeek][hour] == FORECAST_UNKNOWN) {
+      amps = hourSum / hourMinutes;      // this hour so far beats a guess
+    }
+    if (isnan(amps)) amps = 0;
+
+    float drawAh = -amps * stepH;        // > 0 while discharging
+    if (drawAh > 0 && drawAh >= remainingAh) {
+      runtimeMinutes = (elapsedH + remainingAh / -amps) * 60.0f;
+      return;
+    }
+    remainingAh = min(remainingAh - drawAh, capacityAh);
+    elapsedH += stepH;
+    stepH = 1.0f;
+    if (++hour >= FORECAST_HOURS) {
+      hour = 0;
+      dayOfWeek = (dayOfWeek + 1) % FORECAST_DAYS;
+    }
+  }
+  runtimeMinutes = INFINITY;             // does not run empty within the horizon
+}
+
+float forecastRuntimeMinutes() {
+  return runtimeMinutes;
+}
+
+char* forecastFormatRuntime(char* buf, size_t len, const char* unknownText) {
+  if (isnan(runtimeMinutes)) {
+    snprintf(buf, len, "%s", unknownText);
+  } else if (isinf(runtimeMinutes)) {
+    snprintf_P(buf, len, PSTR(">%ud"), FORECAST_HORIZON_H / 24);
+  } else {
+    unsigned long total = (unsigned long)runtimeMinutes;
+    snprintf_P(buf, len, PSTR("%02lu:%02lu"), total / 60, total % 60);
+  }
+  return buf;
+}
+
+uint8_t forecastKnownSlots() {
+  return knownSlots;
+}
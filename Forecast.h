@@ -0,0 +1,56 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Forecast.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Forecast.cpp.
+   Remaining-runtime predictor. Learns the average net current for every
+   hour of every weekday (7 x 24 slots) and projects the remaining charge
+   forward through that profile to the hour the battery runs empty, so
+   the estimate follows the daily load pattern instead of the current
+   of the moment.
+
+   Exposed Functions:
+   - forecastLoad()          → restore the learned profile at boot
+   - forecastAddMinute()     → one closed 1-minute history bucket
+   - forecastUpdate()        → re-run the projection (once per closed bucket)
+   - forecastRuntimeMinutes() → NaN = unknown, INFINITY = beyond the horizon
+   - forecastFormatRuntime() → "hh:mm" / ">7d" for /live_data and Blynk V8
+   - forecastKnownSlots()
+
+   Notes:
+   - A slot learns from complete hours only (at least 30 minutes of
+     data), as an EMA over weeks (FORECAST_ALPHA)
+   - Slots not learned yet fall back to the same hour on other weekdays,
+     then to the recent average current
+   - Each learned slot is written to EEPROM (2 bytes, queued) as its hour
+     closes, so the profile survives reboots
+   - Projection horizon: FORECAST_HORIZON_H hours, at most one step per
+     hour, only when a bucket closes (never per sample)
+*/
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <Arduino.h>
+
+#define FORECAST_DAYS 7
+#define FORECAST_HOURS 24
+#define FORECAST_HORIZON_H 168
+#define FORECAST_ALPHA 0.25            // weight of the newest week
+#define FORECAST_UNKNOWN INT16_MIN     // slot not learned yet
+
+#define ADDR_FORECAST 1296             // 4 B magic + 7 x 24 x int16 (0.01 A)
+
+void forecastLoad();
+void forecastAddMinute(uint8_t dayOfWeek, uint8_t hour, float currentA);
+void forecastUpdate(uint8_t dayOfWeek, uint8_t hour, uint8_t minute,
+                    float socPercent, float capacityAh);
+
+float forecastRuntimeMinutes();
+char* forecastFormatRuntime(char* buf, size_t len, const char* unknownText);
+uint8_t forecastKnownSlots();
+
+#endif // FORECAST_H
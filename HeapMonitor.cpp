@@ -0,0 +1,69 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : HeapMonitor.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Heap health watermarks and per-call-site allocation counters
+   (see HeapMonitor.h).
+*/
+
+#include "HeapMonitor.h"
+
+#if HEAP_DEBUG
+extern "C" {
+#include <umm_malloc/umm_malloc_cfg.h>
+}
+#endif
+
+static HeapStats stats;
+static HeapSite* siteList = nullptr;
+
+// ======================= Watermarks =======================
+void heapMonitorSample() {
+  uint32_t freeBytes, maxBlock;
+  uint8_t frag;
+  ESP.getHeapStats(&freeBytes, &maxBlock, &frag);
+
+  stats.freeBytes = freeBytes;
+  stats.maxBlock = maxBlock;
+  stats.fragPct = frag;
+
+  if (stats.samples == 0 || freeBytes < stats.minFreeBytes) stats.minFreeBytes = freeBytes;
+  if (stats.samples == 0 || maxBlock < stats.minMaxBlock) stats.minMaxBlock = maxBlock;
+  if (frag > stats.maxFragPct) stats.maxFragPct = frag;
+  stats.samples++;
+}
+
+const HeapStats& heapStats() {
+  return stats;
+}
+
+void heapMonitorReset() {
+  memset(&stats, 0, sizeof(stats));
+  stats.sinceMs = millis();
+  for (HeapSite* s = siteList; s; s = s->next) {
+    s->calls = 0;
+    s->allocs = 0;
+  }
+  heapMonitorSample();
+}
+
+// ======================= Call sites =======================
+uint32_t heapAllocCount() {
+#if HEAP_DEBUG
+  return (uint32_t)(umm_get_malloc_count() + umm_get_realloc_count());
+#else
+  return 0;
+#endif
+}
+
+HeapSite::HeapSite(const char* siteName)
+  : name(siteName), calls(0), allocs(0), next(siteList) {
+  siteList = this;
+}
+
+const HeapSite* heapSiteFirst() {
+  return siteList;
+}
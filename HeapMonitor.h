@@ -0,0 +1,80 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : HeapMonitor.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for HeapMonitor.cpp.
+   Tracks heap health for long uptimes: free bytes, largest free block,
+   fragmentation % and their worst values since boot (or the last reset).
+   Debug builds (HEAP_DEBUG 1) also count allocations per call site.
+
+   Exposed Functions:
+   - heapMonitorSample()   → refresh current values and watermarks
+   - heapStats()           → latest snapshot + watermarks
+   - heapMonitorReset()    → restart watermarks and site counters
+   - HEAP_TRACE(name)      → count allocations made inside the enclosing block
+   - heapSiteFirst()       → iterate traced call sites (HEAP_DEBUG only)
+
+   Notes:
+   - HEAP_DEBUG needs the core's umm_malloc statistics (-DUMM_STATS_FULL,
+     also enabled by the "Debug level: OOM" board option)
+   - Site counts are inclusive: a traced block that calls another traced
+     function is charged for that function's allocations too
+*/
+
+#ifndef HEAP_MONITOR_H
+#define HEAP_MONITOR_H
+
+#include <Arduino.h>
+
+#ifndef HEAP_DEBUG
+#define HEAP_DEBUG 0
+#endif
+
+struct HeapStats {
+  uint32_t freeBytes;
+  uint32_t maxBlock;       // largest single allocation that would succeed
+  uint8_t  fragPct;        // 0 = one contiguous block
+  uint32_t minFreeBytes;   // watermarks since boot / reset
+  uint32_t minMaxBlock;
+  uint8_t  maxFragPct;
+  uint32_t samples;
+  uint32_t sinceMs;        // millis() of the last reset
+};
+
+void heapMonitorSample();
+const HeapStats& heapStats();
+void heapMonitorReset();
+
+// Total malloc + realloc calls so far (always 0 without HEAP_DEBUG)
+uint32_t heapAllocCount();
+
+struct HeapSite {
+  const char* name;
+  uint32_t calls;
+  uint32_t allocs;
+  HeapSite* next;
+  explicit HeapSite(const char* siteName);
+};
+
+const HeapSite* heapSiteFirst();
+
+#if HEAP_DEBUG
+class HeapTraceScope {
+public:
+  explicit HeapTraceScope(HeapSite& site) : site_(site), start_(heapAllocCount()) {}
+  ~HeapTraceScope() { site_.calls++; site_.allocs += heapAllocCount() - start_; }
+private:
+  HeapSite& site_;
+  uint32_t start_;
+};
+#define HEAP_TRACE(name) \
+  static HeapSite heapSite_(name); \
+  HeapTraceScope heapTrace_(heapSite_)
+#else
+#define HEAP_TRACE(name) do {} while (0)
+#endif
+
+#endif // HEAP_MONITOR_H
@@ -0,0 +1,151 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Histogram.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Streaming current / SOC occupancy histogram and its EEPROM image
+   (see Histogram.h).
+*/
+
+#include "Histogram.h"
+#include "EEPROMUtils.h"
+#include "AppServer.h"
+
+#define HISTOGRAM_MAGIC 0x54534948UL   // "HIST"
+#define HISTOGRAM_VERSION 1
+
+struct HistogramHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t currentBins;
+  uint8_t socBins;
+  uint8_t reserved;
+  uint32_t sinceUnix;
+  uint32_t savedUnix;
+};
+
+static_assert(sizeof(HistogramHeader) == 16, "header must keep the counters 16-byte aligned");
+static_assert(HISTOGRAM_BINS_PER_OCTAVE == 2, "currentBin() splits each octave in two");
+
+const uint8_t CHUNK_BYTES = 16;      // one queued EEPROM write
+const uint8_t CHUNK_COUNT = (sizeof(HistogramCounts) + CHUNK_BYTES - 1) / CHUNK_BYTES;
+static_assert(CHUNK_COUNT <= 16, "dirty mask is 16 bits");
+
+const unsigned long MAX_SAMPLE_GAP_MS = 5000;
+
+static HistogramCounts counts;
+static HistogramHeader header;
+static uint16_t dirtyChunks = 0;
+static uint16_t carryMs = 0;         // sub-second remainder, goes to the next sample's bin
+static unsigned long lastSampleMs = 0;
+static bool started = false;
+
+// ======================= Binning =======================
+static void addSeconds(uint32_t* bin, uint32_t seconds) {
+  *bin += seconds;
+  size_t offset = (const uint8_t*)bin - (const uint8_t*)&counts;
+  dirtyChunks |= 1U << (offset / CHUNK_BYTES);
+}
+
+// |I| / min = m * 2^e with m in [0.5, 1): the octave is e - 1, the upper
+// half of it starts at m = 1/sqrt(2)
+static uint8_t currentBin(float magnitude) {
+  int e;
+  float m = frexpf(magnitude / HISTOGRAM_MIN_CURRENT_A, &e);
+  int bin = (e - 1) * 2 + (m >= (float)M_SQRT1_2 ? 1 : 0);
+  return (uint8_t)constrain(bin, 0, HISTOGRAM_CURRENT_BINS - 1);
+}
+
+void histogramAddSample(float current, float socPercent, unsigned long now) {
+  if (!started) {
+    started = true;
+    lastSampleMs = now;
+    return;
+  }
+  unsigned long dt = now - lastSampleMs;
+  lastSampleMs = now;
+  carryMs += min(dt, MAX_SAMPLE_GAP_MS);
+  if (carryMs < 1000) return;
+
+  uint32_t seconds = carryMs / 1000;
+  carryMs -= seconds * 1000;
+
+  float magnitude = fabsf(current);
+  if (magnitude < HISTOGRAM_MIN_CURRENT_A) {
+    addSeconds(&counts.idle, seconds);
+  } else if (current > 0) {
+    addSeconds(&counts.charge[currentBin(magnitude)], seconds);
+  } else {
+    addSeconds(&counts.discharge[currentBin(magnitude)], seconds);
+  }
+
+  int socBin = (int)(socPercent * HISTOGRAM_SOC_BINS / 100.0f);
+  addSeconds(&counts.soc[constrain(socBin, 0, HISTOGRAM_SOC_BINS - 1)], seconds);
+}
+
+float histogramBinLowA(uint8_t bin) {
+  return HISTOGRAM_MIN_CURRENT_A * powf(2.0f, (float)bin / HISTOGRAM_BINS_PER_OCTAVE);
+}
+
+// ======================= Persistence =======================
+static void initHeader(uint32_t sinceUnix) {
+  header.magic = HISTOGRAM_MAGIC;
+  header.version = HISTOGRAM_VERSION;
+  header.currentBins = HISTOGRAM_CURRENT_BINS;
+  header.socBins = HISTOGRAM_SOC_BINS;
+  header.reserved = 0;
+  header.sinceUnix = sinceUnix;
+  header.savedUnix = 0;
+}
+
+void histogramLoad() {
+  readBytes(ADDR_HISTOGRAM, (uint8_t*)&header, sizeof(header));
+  if (header.magic == HISTOGRAM_MAGIC && header.version == HISTOGRAM_VERSION &&
+      header.currentBins == HISTOGRAM_CURRENT_BINS && header.socBins == HISTOGRAM_SOC_BINS) {
+    readBytes(ADDR_HISTOGRAM + sizeof(header), (uint8_t*)&counts, sizeof(counts));
+    dirtyChunks = 0;
+    return;
+  }
+  // Blank chip or a different bin layout: start over, first save writes everything
+  memset(&counts, 0, sizeof(counts));
+  initHeader(0);
+  dirtyChunks = (1U << CHUNK_COUNT) - 1;
+}
+
+void histogramSave(uint32_t unixTime) {
+  uint8_t written = 0;
+  for (uint8_t c = 0; c < CHUNK_COUNT; c++) {
+    if (!(dirtyChunks & (1U << c))) continue;
+    size_t offset = c * CHUNK_BYTES;
+    size_t len = min((size_t)CHUNK_BYTES, sizeof(counts) - offset);
+    writeBytes(ADDR_HISTOGRAM + sizeof(header) + offset, (const uint8_t*)&counts + offset, len);
+    written++;
+  }
+  dirtyChunks = 0;
+
+  header.savedUnix = unixTime;
+  writeBytes(ADDR_HISTOGRAM, (const uint8_t*)&header, sizeof(header));
+  addSerialLogf_P(PSTR("📊 Load histogram saved (%u of %u chunks)"), written, CHUNK_COUNT);
+}
+
+void histogramReset(uint32_t unixTime) {
+  memset(&counts, 0, sizeof(counts));
+  carryMs = 0;
+  initHeader(unixTime);
+  dirtyChunks = (1U << CHUNK_COUNT) - 1;
+  histogramSave(unixTime);
+}
+
+const HistogramCounts& histogramCounts() {
+  return counts;
+}
+
+uint32_t histogramSinceUnix() {
+  return header.sinceUnix;
+}
+
+uint32_t histogramSavedUnix() {
+  return header.savedUnix;
+}
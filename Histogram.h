@@ -0,0 +1,60 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Histogram.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Histogram.cpp.
+   Load profile: how many seconds the battery has spent at each current
+   level (log-spaced bins, charge and discharge separately) and at each
+   SOC level. Updated from every sensor sample, kept in EEPROM, served
+   by GET /histogram, for sizing the battery and the charger.
+
+   Exposed Functions:
+   - histogramAddSample()   → one sensor sample (called from updateSensors)
+   - histogramLoad()        → restore the counters at boot
+   - histogramSave()        → write the bins changed since the last save (daily)
+   - histogramReset()       → clear and persist (GET /histogram?reset=1)
+   - histogramCounts(), histogramBinLowA(), histogramSavedUnix()
+
+   Notes:
+   - Current bins: |I| < HISTOGRAM_MIN_CURRENT_A is idle; above that each
+     bin is half an octave wide (x1.41), the last one open-ended
+   - SOC bins are 5 % wide
+   - O(1) per sample (frexpf instead of a log), fixed 244 byte footprint
+   - Each touched counter marks its 16-byte EEPROM chunk dirty; a save
+     only writes the dirty chunks, through the queued EEPROM writer
+*/
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <Arduino.h>
+
+#define HISTOGRAM_CURRENT_BINS 20      // per direction
+#define HISTOGRAM_BINS_PER_OCTAVE 2
+#define HISTOGRAM_MIN_CURRENT_A 0.05
+#define HISTOGRAM_SOC_BINS 20          // 5 % each
+
+#define ADDR_HISTOGRAM 1024            // 16 B header + HistogramCounts (must stay 16-byte aligned)
+
+struct HistogramCounts {               // seconds in each bin
+  uint32_t idle;
+  uint32_t discharge[HISTOGRAM_CURRENT_BINS];
+  uint32_t charge[HISTOGRAM_CURRENT_BINS];
+  uint32_t soc[HISTOGRAM_SOC_BINS];
+};
+
+void histogramAddSample(float current, float socPercent, unsigned long now);
+
+void histogramLoad();
+void histogramSave(uint32_t unixTime);
+void histogramReset(uint32_t unixTime);
+
+const HistogramCounts& histogramCounts();
+float histogramBinLowA(uint8_t bin);   // lower edge of a current bin
+uint32_t histogramSinceUnix();         // last reset (0 = unknown)
+uint32_t histogramSavedUnix();         // last save (0 = never)
+
+#endif // HISTOGRAM_H
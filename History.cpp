@@ -0,0 +1,302 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : History.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Rolling aggregate store for voltage, current, SOC and energy.
+   Every sensor reading is folded into one accumulator per span; a span
+   closes its bucket when its period elapses (1 min → 30 min → 3 h) and
+   pushes it into a fixed-size ring.
+
+   Notes:
+   - Constant cost per sample, fixed memory regardless of uptime
+   - Trend graph columns are (re)computed only when a bucket closes; a
+     full rebuild only happens when a value falls outside the graph scale
+*/
+
+#include "History.h"
+
+// ======================= Span configuration =======================
+static const uint8_t SPAN_SIZE[HIST_SPAN_COUNT] = { 60, 48, 56 };
+// How many closes of the previous span make one bucket of this span
+static const uint8_t SPAN_CHILD_CLOSES[HIST_SPAN_COUNT] = { 0, 30, 6 };
+// Bucket length, to turn bucket energy into Wh per hour (comparable across spans)
+static const float SPAN_BUCKET_HOURS[HIST_SPAN_COUNT] = { 1.0 / 60, 0.5, 3.0 };
+static const unsigned long MINUTE_MS = 60000UL;
+static const float MAX_SAMPLE_GAP_S = 5.0;
+
+struct HistoryAccumulator {
+  float voltageSum;
+  float currentSum;
+  float socSum;
+  float energyWh;
+  uint32_t samples;
+  uint8_t childCloses;
+  Extremes extremes;    // raw samples (minute span) or merged child buckets
+};
+
+static HistoryBucket hourRing[60];
+static HistoryBucket dayRing[48];
+static HistoryBucket weekRing[56];
+static HistoryBucket* const rings[HIST_SPAN_COUNT] = { hourRing, dayRing, weekRing };
+
+static uint8_t ringHead[HIST_SPAN_COUNT] = { 0, 0, 0 };
+static uint8_t ringCount[HIST_SPAN_COUNT] = { 0, 0, 0 };
+static HistoryAccumulator acc[HIST_SPAN_COUNT];
+
+static TrendGraph graphs[HIST_SPAN_COUNT][HIST_METRIC_COUNT];
+static bool graphsInitialized = false;
+
+static HistoryCloseHandler closeHandler = nullptr;
+
+static unsigned long minuteStartMs = 0;
+static unsigned long lastSampleMs = 0;
+static bool historyStarted = false;
+
+// ======================= Graph scaling =======================
+static uint8_t valueToRow(const TrendGraph& g, float value) {
+  float span = g.hi - g.lo;
+  if (span <= 0) return 0;
+  int row = (int)((value - g.lo) / span * (HISTORY_GRAPH_HEIGHT - 1) + 0.5f);
+  return (uint8_t)constrain(row, 0, HISTORY_GRAPH_HEIGHT - 1);
+}
+
+static void initGraphScale(TrendGraph& g, HistoryMetric metric) {
+  switch (metric) {
+    case HIST_METRIC_VOLTAGE: g.lo = 10.0; g.hi = 15.0; break;
+    case HIST_METRIC_CURRENT: g.lo = -2.0; g.hi = 2.0;  break;
+    case HIST_METRIC_SOC:     g.lo = 0.0;  g.hi = 100.0; break;
+    case HIST_METRIC_ENERGY:  g.lo = -1.0; g.hi = 1.0;  break;
+    default:                  g.lo = 0.0;  g.hi = 1.0;  break;
+  }
+  memset(g.col, HISTORY_COLUMN_EMPTY, sizeof(g.col));
+  g.zeroRow = valueToRow(g, 0.0);
+}
+
+static void initGraphs() {
+  for (int s = 0; s < HIST_SPAN_COUNT; s++) {
+    for (int m = 0; m < HIST_METRIC_COUNT; m++) {
+      initGraphScale(graphs[s][m], (HistoryMetric)m);
+    }
+  }
+  graphsInitialized = true;
+}
+
+// Widen the scale so that value fits. Returns true if the scale changed.
+static bool expandScale(TrendGraph& g, HistoryMetric metric, float value) {
+  if (value >= g.lo && value <= g.hi) return false;
+
+  if (metric == HIST_METRIC_VOLTAGE) {
+    while (value < g.lo) g.lo -= 1.0;
+    while (value > g.hi) g.hi += 1.0;
+  } else if (metric == HIST_METRIC_CURRENT || metric == HIST_METRIC_ENERGY) {
+    // Signed metrics stay symmetric around zero
+    while (value < g.lo || value > g.hi) {
+      g.lo *= 2.0;
+      g.hi *= 2.0;
+    }
+  } else {
+    return false; // SOC is always 0..100
+  }
+  return true;
+}
+
+static void rebuildGraph(HistorySpan span, HistoryMetric metric) {
+  TrendGraph& g = graphs[span][metric];
+  g.zeroRow = valueToRow(g, 0.0);
+  HistoryBucket* ring = rings[span];
+  for (uint8_t i = 0; i < SPAN_SIZE[span]; i++) {
+    g.col[i] = ring[i].valid ? valueToRow(g, historyBucketValue(ring[i], metric))
+                             : HISTORY_COLUMN_EMPTY;
+  }
+}
+
+// Called once per closed bucket: one new column per metric
+static void updateGraphs(HistorySpan span, uint8_t slot) {
+  const HistoryBucket& b = rings[span][slot];
+  for (int m = 0; m < HIST_METRIC_COUNT; m++) {
+    TrendGraph& g = graphs[span][m];
+    if (!b.valid) {
+      g.col[slot] = HISTORY_COLUMN_EMPTY;
+      continue;
+    }
+    float value = historyBucketValue(b, (HistoryMetric)m);
+    if (expandScale(g, (HistoryMetric)m, value)) {
+      rebuildGraph(span, (HistoryMetric)m);
+    } else {
+      g.col[slot] = valueToRow(g, value);
+    }
+  }
+}
+
+// ======================= Bucket closing =======================
+static void resetAccumulator(HistoryAccumulator& a) {
+  memset(&a, 0, sizeof(a));
+  extremesReset(a.extremes);
+}
+
+static void packRange(const MinMax& m, float scale, int16_t* lo, int16_t* hi) {
+  if (!extremesValid(m)) {
+    *lo = *hi = HISTORY_NO_EXTREME;
+    return;
+  }
+  *lo = (int16_t)constrain(floorf(m.lo * scale), -32767.0f, 32767.0f);
+  *hi = (int16_t)constrain(ceilf(m.hi * scale), -32767.0f, 32767.0f);
+}
+
+static void unpackRange(int16_t lo, int16_t hi, float scale, MinMax& m) {
+  if (lo == HISTORY_NO_EXTREME) {
+    m.lo = INFINITY;
+    m.hi = -INFINITY;
+    return;
+  }
+  m.lo = lo / scale;
+  m.hi = hi / scale;
+}
+
+static void closeSpan(HistorySpan span) {
+  HistoryAccumulator& a = acc[span];
+  uint8_t slot = ringHead[span];
+  HistoryBucket& b = rings[span][slot];
+
+  if (a.samples > 0) {
+    float n = (float)a.samples;
+    b.voltage_cV = (int16_t)constrain(a.voltageSum / n * 100.0f, -32768.0f, 32767.0f);
+    b.current_cA = (int16_t)constrain(a.currentSum / n * 100.0f, -32768.0f, 32767.0f);
+    b.soc_halfPct = (uint8_t)constrain(a.socSum / n * 2.0f + 0.5f, 0.0f, 200.0f);
+    b.energyWhPerH = a.energyWh / SPAN_BUCKET_HOURS[span];
+    b.valid = 1;
+  } else {
+    memset(&b, 0, sizeof(b));
+  }
+  packRange(a.extremes.voltage, 100.0f, &b.voltageMin_cV, &b.voltageMax_cV);
+  packRange(a.extremes.current, 100.0f, &b.currentMin_cA, &b.currentMax_cA);
+  packRange(a.extremes.power, 10.0f, &b.powerMin_dW, &b.powerMax_dW);
+
+  ringHead[span] = (slot + 1) % SPAN_SIZE[span];
+  if (ringCount[span] < SPAN_SIZE[span]) ringCount[span]++;
+  updateGraphs(span, slot);
+  if (closeHandler) closeHandler(span, b);
+
+  // Cascade into the next (longer) span
+  if (span + 1 < HIST_SPAN_COUNT) {
+    HistorySpan next = (HistorySpan)(span + 1);
+    extremesMerge(acc[next].extremes, a.extremes);
+    resetAccumulator(a);
+    if (++acc[next].childCloses >= SPAN_CHILD_CLOSES[next]) {
+      closeSpan(next);
+    }
+    return;
+  }
+  resetAccumulator(a);
+}
+
+// ======================= Public API =======================
+void historyAddSample(float voltage, float current, float socPercent) {
+  unsigned long now = millis();
+  if (!graphsInitialized) initGraphs();
+
+  if (!historyStarted) {
+    historyStarted = true;
+    minuteStartMs = now;
+    lastSampleMs = now;
+    for (int s = 0; s < HIST_SPAN_COUNT; s++) resetAccumulator(acc[s]);
+  }
+
+  float dt = (now - lastSampleMs) / 1000.0;
+  if (dt > MAX_SAMPLE_GAP_S) dt = MAX_SAMPLE_GAP_S;
+  lastSampleMs = now;
+  float energyWh = voltage * current * dt / 3600.0;
+
+  for (int s = 0; s < HIST_SPAN_COUNT; s++) {
+    HistoryAccumulator& a = acc[s];
+    a.voltageSum += voltage;
+    a.currentSum += current;
+    a.socSum += socPercent;
+    a.energyWh += energyWh;
+    a.samples++;
+  }
+
+  // Close every elapsed minute (catches up after a stall)
+  while (now - minuteStartMs >= MINUTE_MS) {
+    minuteStartMs += MINUTE_MS;
+    closeSpan(HIST_SPAN_HOUR);
+  }
+}
+
+// Only the minute span sees raw samples; cost stays one update per sample
+void historyAddRawSample(float voltage, float current) {
+  if (!historyStarted) return;
+  extremesAdd(acc[HIST_SPAN_HOUR].extremes, voltage, current);
+}
+
+void historySetCloseHandler(HistoryCloseHandler handler) {
+  closeHandler = handler;
+}
+
+uint8_t historySpanSize(HistorySpan span) {
+  return SPAN_SIZE[span];
+}
+
+uint8_t historyBucketCount(HistorySpan span) {
+  return ringCount[span];
+}
+
+uint8_t historyRingHead(HistorySpan span) {
+  return ringHead[span];
+}
+
+const HistoryBucket* historyBucketAt(HistorySpan span, uint8_t age) {
+  if (age >= ringCount[span]) return nullptr;
+  uint8_t size = SPAN_SIZE[span];
+  uint8_t slot = (ringHead[span] + size - 1 - age) % size;
+  return &rings[span][slot];
+}
+
+float historyBucketValue(const HistoryBucket& b, HistoryMetric metric) {
+  switch (metric) {
+    case HIST_METRIC_VOLTAGE: return b.voltage_cV / 100.0f;
+    case HIST_METRIC_CURRENT: return b.current_cA / 100.0f;
+    case HIST_METRIC_SOC:     return b.soc_halfPct / 2.0f;
+    case HIST_METRIC_ENERGY:  return b.energyWhPerH;
+    default:                  return 0.0f;
+  }
+}
+
+Extremes historyBucketExtremes(const HistoryBucket& b) {
+  Extremes e;
+  unpackRange(b.voltageMin_cV, b.voltageMax_cV, 100.0f, e.voltage);
+  unpackRange(b.currentMin_cA, b.currentMax_cA, 100.0f, e.current);
+  unpackRange(b.powerMin_dW, b.powerMax_dW, 10.0f, e.power);
+  return e;
+}
+
+const TrendGraph& historyGraph(HistorySpan span, HistoryMetric metric) {
+  if (!graphsInitialized) initGraphs();
+  return graphs[span][metric];
+}
+
+uint8_t historyGraphRow(const TrendGraph& g, float value) {
+  return valueToRow(g, value);
+}
+
+const char* historySpanLabel(HistorySpan span) {
+  switch (span) {
+    case HIST_SPAN_HOUR: return "1h";
+    case HIST_SPAN_DAY:  return "24h";
+    case HIST_SPAN_WEEK: return "7d";
+    default:             return "?";
+  }
+}
+
+const char* historyMetricLabel(HistoryMetric metric) {
+  switch (metric) {
+    case HIST_METRIC_VOLTAGE: return "Voltage";
+    case HIST_METRIC_CURRENT: return "Current";
+    case HIST_METRIC_SOC:     return "SOC";
+    case HIST_METRIC_ENERGY:  return "Wh/h";
+    default:                  return "?";
+  }
+}
@@ -0,0 +1,101 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : History.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for History.cpp.
+   On-device aggregate store: rolling buckets of voltage, current, SOC
+   and energy over the last hour, day and week, plus precomputed trend
+   graph columns for the OLED.
+
+   Exposed Functions:
+   - historyAddSample()        → feed one sensor reading (called from updateSensors)
+   - historyAddRawSample()     → feed one raw reading into the bucket min/max
+   - historyBucketAt()         → read a closed bucket (0 = newest)
+   - historyBucketExtremes()   → min/max of voltage, current and power in a bucket
+   - historyBucketCount()      → number of closed buckets in a span
+   - historySetCloseHandler()  → notify a consumer when a bucket closes (runtime forecast)
+   - historyGraph()            → precomputed OLED columns for a span/metric
+   - historyGraphRow()         → scale a value like the graph columns (min/max whiskers)
+   - historySpanLabel(), historyMetricLabel()
+
+   Notes:
+   - Hour  : 60 buckets x 1 min
+   - Day   : 48 buckets x 30 min
+   - Week  : 56 buckets x 3 h
+   - Graph columns are updated incrementally when a bucket closes, so
+     drawing a frame never recomputes the whole series.
+   - Bucket min/max come from the raw samples (see Extremes.h); only the
+     minute accumulator sees them, longer spans merge their child buckets.
+*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <Arduino.h>
+#include "Extremes.h"
+
+enum HistorySpan {
+  HIST_SPAN_HOUR = 0,
+  HIST_SPAN_DAY,
+  HIST_SPAN_WEEK,
+  HIST_SPAN_COUNT
+};
+
+enum HistoryMetric {
+  HIST_METRIC_VOLTAGE = 0,
+  HIST_METRIC_CURRENT,
+  HIST_METRIC_SOC,
+  HIST_METRIC_ENERGY,
+  HIST_METRIC_COUNT
+};
+
+#define HISTORY_MAX_BUCKETS 60
+#define HISTORY_GRAPH_HEIGHT 50   // plot height in pixels
+#define HISTORY_COLUMN_EMPTY 0xFF
+#define HISTORY_NO_EXTREME INT16_MIN   // bucket min/max: no raw samples
+
+// One closed bucket (fixed-point to keep the rings small)
+struct HistoryBucket {
+  int16_t voltage_cV;   // average voltage, 0.01 V
+  int16_t current_cA;   // average current, 0.01 A (+charge / -discharge)
+  uint8_t soc_halfPct;  // average SOC, 0.5 %
+  uint8_t valid;        // 0 = no samples in this bucket
+  float energyWhPerH;   // net energy over the bucket per hour (+in / -out)
+  int16_t voltageMin_cV, voltageMax_cV;
+  int16_t currentMin_cA, currentMax_cA;
+  int16_t powerMin_dW, powerMax_dW;   // 0.1 W
+};
+
+// Precomputed OLED columns for one span/metric.
+// col[] is indexed like the history ring, so a new bucket only
+// overwrites one slot; the renderer walks it oldest → newest.
+struct TrendGraph {
+  uint8_t col[HISTORY_MAX_BUCKETS]; // pixel height 0..HISTORY_GRAPH_HEIGHT-1
+  uint8_t zeroRow;                  // pixel row of 0 for signed metrics
+  float lo;
+  float hi;
+};
+
+typedef void (*HistoryCloseHandler)(HistorySpan span, const HistoryBucket& bucket);
+
+void historyAddSample(float voltage, float current, float socPercent);
+void historyAddRawSample(float voltage, float current);
+
+uint8_t historySpanSize(HistorySpan span);
+uint8_t historyBucketCount(HistorySpan span);
+uint8_t historyRingHead(HistorySpan span);        // slot of the next write
+const HistoryBucket* historyBucketAt(HistorySpan span, uint8_t age); // 0 = newest
+float historyBucketValue(const HistoryBucket& b, HistoryMetric metric);
+Extremes historyBucketExtremes(const HistoryBucket& b);
+
+void historySetCloseHandler(HistoryCloseHandler handler);   // after every closed bucket
+const TrendGraph& historyGraph(HistorySpan span, HistoryMetric metric);
+uint8_t historyGraphRow(const TrendGraph& g, float value);   // value → pixel row (clamped)
+
+const char* historySpanLabel(HistorySpan span);
+const char* historyMetricLabel(HistoryMetric metric);
+
+#endif // HISTORY_H
@@ -0,0 +1,448 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : I2CBus.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Shares the single Wire bus between the sampling path and the slow
+   peripherals. Sensor and RTC reads run immediately; EEPROM writes and
+   OLED frame flushes are queued and sent in small chunks from
+   i2cBusService(), which loop() calls with a time budget right after
+   sampling. A 1 KB frame or a multi-page EEPROM update therefore can
+   no longer hold the bus for tens of milliseconds.
+
+   Notes:
+   - AT24C32 page size is 32 bytes; chunks never cross a page
+   - Write-cycle completion is detected by ACK polling instead of delay()
+   - OLED frame is streamed in horizontal addressing mode, 30 bytes per
+     transaction so it also fits cores with a 32-byte Wire buffer
+   - Every transaction reports its result; absent or failing devices are
+     quarantined and re-probed from i2cBusService(), so a missing chip
+     costs one address ping every few seconds instead of a stalled loop
+*/
+
+#include "I2CBus.h"
+#include "EEPROMUtils.h"
+#include "Profiler.h"
+
+const uint8_t OLED_I2C_ADDR = 0x3C;
+const uint8_t EEPROM_PAGE_SIZE = 32;
+const uint8_t EEPROM_CHUNK_MAX = 16;
+const uint8_t EEPROM_QUEUE_LEN = 24;
+const uint32_t EEPROM_POLL_AFTER_US = 2000;     // don't poll before tWR is likely over
+const uint16_t OLED_FRAME_BYTES = 128 * 64 / 8;
+const uint8_t OLED_CHUNK = 30;
+const uint32_t STATS_WINDOW_MS = 5000;
+const uint8_t DEVICE_ADDR[I2C_DEV_COUNT] = { 0x40, 0x48, 0x68, 0x57, 0x3C };
+const unsigned long REPROBE_MIN_MS = 5000;
+const unsigned long REPROBE_MAX_MS = 60000;
+const unsigned long BUS_CLEAR_MIN_GAP_MS = 1000;
+
+static Adafruit_SSD1306* oledDisplay = nullptr;
+
+// ======================= Statistics =======================
+static I2CDeviceStats deviceStats[I2C_DEV_COUNT];
+static uint32_t windowBusyUs[I2C_DEV_COUNT];
+static unsigned long windowStartMs = 0;
+
+static const char* const DEVICE_NAMES[I2C_DEV_COUNT] = {
+  "ina219", "ads1115", "rtc", "eeprom", "oled"
+};
+
+static void rollStatsWindow() {
+  unsigned long now = millis();
+  unsigned long elapsed = now - windowStartMs;
+  if (elapsed < STATS_WINDOW_MS) return;
+  for (int d = 0; d < I2C_DEV_COUNT; d++) {
+    uint32_t pct = (uint32_t)((uint64_t)windowBusyUs[d] * 100 / ((uint64_t)elapsed * 1000));
+    deviceStats[d].utilizationPct = (uint8_t)min<uint32_t>(pct, 100);
+    windowBusyUs[d] = 0;
+  }
+  windowStartMs = now;
+}
+
+void i2cAccount(I2CDevice dev, uint32_t busyUs) {
+  I2CDeviceStats& s = deviceStats[dev];
+  s.transactions++;
+  s.busyUs += busyUs;
+  if (busyUs > s.maxUs) s.maxUs = busyUs;
+  windowBusyUs[dev] += busyUs;
+}
+
+I2CTransaction::I2CTransaction(I2CDevice dev) : dev_(dev), startUs_(micros()) {}
+
+I2CTransaction::~I2CTransaction() {
+  i2cAccount(dev_, micros() - startUs_);
+}
+
+const I2CDeviceStats& i2cDeviceStats(I2CDevice dev) {
+  rollStatsWindow();
+  return deviceStats[dev];
+}
+
+const char* i2cDeviceName(I2CDevice dev) {
+  return DEVICE_NAMES[dev];
+}
+
+// ======================= Fault handling =======================
+static bool (*reinitHandler[I2C_DEV_COUNT])() = { nullptr };
+static unsigned long nextProbeMs[I2C_DEV_COUNT];
+static unsigned long probeBackoffMs[I2C_DEV_COUNT];
+static uint32_t busClears = 0;
+static unsigned long lastBusClearMs = 0;
+
+static void applyBusConfig() {
+  Wire.setClock(I2C_FAST_MODE_HZ);
+  Wire.setClockStretchLimit(I2C_CLOCK_STRETCH_LIMIT_US);
+}
+
+static void quarantine(I2CDevice dev) {
+  I2CDeviceStats& s = deviceStats[dev];
+  if (s.quarantined) return;
+  s.quarantined = true;
+  probeBackoffMs[dev] = REPROBE_MIN_MS;
+  nextProbeMs[dev] = millis() + REPROBE_MIN_MS;
+  Serial.print(F("⚠️ I2C device quarantined: "));
+  Serial.println(DEVICE_NAMES[dev]);
+}
+
+// 9 SCL pulses release a slave stuck mid-byte, then a STOP resets its state
+bool i2cBusClear() {
+  lastBusClearMs = millis();
+  busClears++;
+
+  pinMode(SDA, INPUT_PULLUP);
+  pinMode(SCL, INPUT_PULLUP);
+  delayMicroseconds(5);
+  if (digitalRead(SCL) == LOW) {
+    // SCL held low by a slave: nothing the master can do
+    Wire.begin();
+    applyBusConfig();
+    return false;
+  }
+
+  for (int i = 0; i < 9 && digitalRead(SDA) == LOW; i++) {
+    pinMode(SCL, OUTPUT_OPEN_DRAIN);
+    digitalWrite(SCL, LOW);
+    delayMicroseconds(5);
+    pinMode(SCL, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+
+  // STOP condition: SDA low → high while SCL is high
+  pinMode(SDA, OUTPUT_OPEN_DRAIN);
+  digitalWrite(SDA, LOW);
+  delayMicroseconds(5);
+  pinMode(SDA, INPUT_PULLUP);
+  delayMicroseconds(5);
+  bool released = (digitalRead(SDA) == HIGH);
+
+  Wire.begin();
+  applyBusConfig();
+  if (released) Serial.println(F("✅ I2C bus cleared"));
+  else Serial.println(F("❌ I2C bus still stuck"));
+  return released;
+}
+
+uint32_t i2cBusClearCount() {
+  return busClears;
+}
+
+void i2cReportResult(I2CDevice dev, bool ok, uint8_t errorCode) {
+  I2CDeviceStats& s = deviceStats[dev];
+  if (ok) {
+    s.consecutiveErrors = 0;
+    return;
+  }
+  s.errors++;
+  s.lastError = errorCode;
+  if (s.consecutiveErrors < 255) s.consecutiveErrors++;
+  if (s.consecutiveErrors >= I2C_QUARANTINE_ERRORS) quarantine(dev);
+
+  // A slave left holding SDA low blocks every other device
+  if (digitalRead(SDA) == LOW && millis() - lastBusClearMs >= BUS_CLEAR_MIN_GAP_MS) {
+    i2cBusClear();
+  }
+}
+
+bool i2cDeviceAvailable(I2CDevice dev) {
+  return deviceStats[dev].present && !deviceStats[dev].quarantined;
+}
+
+void i2cSetDevicePresent(I2CDevice dev, bool present) {
+  I2CDeviceStats& s = deviceStats[dev];
+  s.present = present;
+  s.consecutiveErrors = 0;
+  if (present) {
+    s.quarantined = false;
+  } else {
+    // Missing at boot: keep looking for it in the background
+    s.present = true;
+    quarantine(dev);
+  }
+}
+
+void i2cSetReinitHandler(I2CDevice dev, bool (*reinit)()) {
+  reinitHandler[dev] = reinit;
+}
+
+static bool pingDevice(I2CDevice dev) {
+  I2CTransaction t(dev);
+  Wire.beginTransmission(DEVICE_ADDR[dev]);
+  return Wire.endTransmission() == 0;
+}
+
+// One address ping per due device; a hit runs the driver's re-init hook
+static void reprobeQuarantined() {
+  unsigned long now = millis();
+  for (int d = 0; d < I2C_DEV_COUNT; d++) {
+    I2CDeviceStats& s = deviceStats[d];
+    if (!s.quarantined || (long)(now - nextProbeMs[d]) < 0) continue;
+
+    bool ok = pingDevice((I2CDevice)d);
+    if (ok && reinitHandler[d]) ok = reinitHandler[d]();
+    if (ok) {
+      s.quarantined = false;
+      s.consecutiveErrors = 0;
+      Serial.print(F("✅ I2C device back online: "));
+      Serial.println(DEVICE_NAMES[d]);
+    } else {
+      probeBackoffMs[d] = min(probeBackoffMs[d] * 2, REPROBE_MAX_MS);
+      nextProbeMs[d] = now + probeBackoffMs[d];
+    }
+    return; // at most one probe per service call
+  }
+}
+
+// ======================= Register access =======================
+bool i2cWriteReg16(I2CDevice dev, uint8_t addr, uint8_t reg, uint16_t value) {
+  Wire.beginTransmission(addr);
+  Wire.write(reg);
+  Wire.write((uint8_t)(value >> 8));
+  Wire.write((uint8_t)(value & 0xFF));
+  uint8_t err = Wire.endTransmission();
+  i2cReportResult(dev, err == 0, err);
+  return err == 0;
+}
+
+bool i2cReadReg16(I2CDevice dev, uint8_t addr, uint8_t reg, uint16_t* value) {
+  Wire.beginTransmission(addr);
+  Wire.write(reg);
+  uint8_t err = Wire.endTransmission();
+  if (err == 0 && Wire.requestFrom(addr, (uint8_t)2) == 2) {
+    *value = ((uint16_t)Wire.read() << 8) | Wire.read();
+    i2cReportResult(dev, true);
+    return true;
+  }
+  i2cReportResult(dev, false, err ? err : 4);
+  return false;
+}
+
+// ======================= EEPROM write queue =======================
+struct EepromWrite {
+  uint16_t addr;
+  uint8_t len;
+  uint8_t data[EEPROM_CHUNK_MAX];
+};
+
+static EepromWrite eepromQueue[EEPROM_QUEUE_LEN];
+static uint8_t eepromQueueHead = 0;   // oldest entry
+static uint8_t eepromQueueCount = 0;
+static bool deferredWrites = false;
+static bool eepromCycleActive = false;
+static uint32_t eepromLastWriteUs = 0;
+
+static EepromWrite& queueAt(uint8_t i) {
+  return eepromQueue[(eepromQueueHead + i) % EEPROM_QUEUE_LEN];
+}
+
+// Wait until the AT24C32 has finished its internal write cycle
+static bool eepromWaitReady(bool blocking) {
+  if (!eepromCycleActive) return true;
+  uint32_t elapsed = micros() - eepromLastWriteUs;
+  if (elapsed < EEPROM_POLL_AFTER_US && !blocking) return false;
+  while (true) {
+    elapsed = micros() - eepromLastWriteUs;
+    if (elapsed >= EEPROM_POLL_AFTER_US && eepromReady()) break;
+    if (elapsed > I2C_EEPROM_WRITE_TIMEOUT_US) {   // give up, don't stall the loop
+      i2cReportResult(I2C_DEV_EEPROM, false);
+      break;
+    }
+    if (!blocking) return false;
+    delayMicroseconds(200);
+  }
+  eepromCycleActive = false;
+  return true;
+}
+
+static void eepromWriteChunkNow(uint16_t addr, const uint8_t* data, uint8_t len) {
+  if (!i2cDeviceAvailable(I2C_DEV_EEPROM)) return; // chip missing: drop, don't stall
+  PERF_SCOPE(PERF_EEPROM);
+  eepromWaitReady(true);
+  bool ok = eepromWritePage(addr, data, len);
+  i2cReportResult(I2C_DEV_EEPROM, ok);
+  eepromCycleActive = ok;
+  eepromLastWriteUs = micros();
+}
+
+static void eepromPopAndWrite() {
+  EepromWrite& w = queueAt(0);
+  eepromWriteChunkNow(w.addr, w.data, w.len);
+  eepromQueueHead = (eepromQueueHead + 1) % EEPROM_QUEUE_LEN;
+  eepromQueueCount--;
+}
+
+static void enqueueChunk(uint16_t addr, const uint8_t* data, uint8_t len) {
+  // Coalesce repeated writes of the same value slot (e.g. SOC every 5 min).
+  // Newest first: an overlapping entry queued after the match would land
+  // on top of the coalesced data, so append instead.
+  uint32_t end = (uint32_t)addr + len;
+  for (uint8_t i = eepromQueueCount; i-- > 0; ) {
+    EepromWrite& w = queueAt(i);
+    if (w.addr == addr && w.len == len) {
+      memcpy(w.data, data, len);
+      return;
+    }
+    if ((uint32_t)w.addr + w.len > addr && w.addr < end) break;
+  }
+  if (eepromQueueCount >= EEPROM_QUEUE_LEN) {
+    eepromWaitReady(true);
+    eepromPopAndWrite(); // queue full → make room synchronously
+  }
+  EepromWrite& w = queueAt(eepromQueueCount);
+  w.addr = addr;
+  w.len = len;
+  memcpy(w.data, data, len);
+  eepromQueueCount++;
+}
+
+void i2cSetDeferredWrites(bool enabled) {
+  if (!enabled) i2cFlushEepromWrites();
+  deferredWrites = enabled;
+}
+
+void i2cQueueEepromWrite(uint16_t addr, const uint8_t* data, size_t len) {
+  while (len > 0) {
+    uint8_t pageRoom = EEPROM_PAGE_SIZE - (addr % EEPROM_PAGE_SIZE);
+    uint8_t chunk = (uint8_t)min<size_t>(len, min<uint8_t>(pageRoom, EEPROM_CHUNK_MAX));
+    if (deferredWrites) {
+      enqueueChunk(addr, data, chunk);
+    } else {
+      eepromWriteChunkNow(addr, data, chunk);
+    }
+    addr += chunk;
+    data += chunk;
+    len -= chunk;
+  }
+  if (!deferredWrites) eepromWaitReady(true);
+}
+
+// Apply not-yet-written bytes on top of data just read from the chip
+void i2cEepromOverlay(uint16_t addr, uint8_t* buf, size_t len) {
+  uint32_t end = (uint32_t)addr + len;
+  for (uint8_t i = 0; i < eepromQueueCount; i++) {
+    const EepromWrite& w = queueAt(i);
+    uint32_t wEnd = (uint32_t)w.addr + w.len;
+    if (wEnd <= addr || w.addr >= end) continue;
+    uint32_t from = max<uint32_t>(addr, w.addr);
+    uint32_t to = min<uint32_t>(end, wEnd);
+    memcpy(buf + (from - addr), w.data + (from - w.addr), to - from);
+  }
+}
+
+bool i2cEepromWritePending() {
+  return eepromQueueCount > 0;
+}
+
+// A chunk leaves the queue (and the overlay) when it is sent, but the chip
+// NACKs its address for ~5 ms after that: readers wait the cycle out here
+bool i2cEepromWaitIdle() {
+  return eepromWaitReady(true);
+}
+
+void i2cFlushEepromWrites() {
+  while (eepromQueueCount > 0) {
+    eepromPopAndWrite();
+  }
+  eepromWaitReady(true);
+}
+
+// ======================= Display flush =======================
+static bool displayFlushPending = false;
+static bool displayHeaderSent = false;
+static uint16_t displayOffset = 0;
+
+void i2cRequestDisplayFlush() {
+  displayFlushPending = true;
+  displayHeaderSent = false;
+  displayOffset = 0;
+}
+
+bool i2cDisplayFlushPending() {
+  return displayFlushPending;
+}
+
+void i2cFlushDisplayNow() {
+  displayFlushPending = false;
+  if (!oledDisplay || !i2cDeviceAvailable(I2C_DEV_OLED)) return;
+  I2CTransaction t(I2C_DEV_OLED);
+  oledDisplay->display();
+}
+
+static void displaySendChunk() {
+  I2CTransaction t(I2C_DEV_OLED);
+  if (!displayHeaderSent) {
+    // Full-screen window, same sequence as Adafruit_SSD1306::display()
+    oledDisplay->ssd1306_command(SSD1306_PAGEADDR);
+    oledDisplay->ssd1306_command(0);
+    oledDisplay->ssd1306_command(0xFF);
+    oledDisplay->ssd1306_command(SSD1306_COLUMNADDR);
+    oledDisplay->ssd1306_command(0);
+    oledDisplay->ssd1306_command(127);
+    displayHeaderSent = true;
+    return;
+  }
+  const uint8_t* buffer = oledDisplay->getBuffer();
+  uint16_t n = min<uint16_t>(OLED_CHUNK, OLED_FRAME_BYTES - displayOffset);
+  Wire.beginTransmission(OLED_I2C_ADDR);
+  Wire.write((uint8_t)0x40); // Co = 0, D/C = 1 → data stream
+  Wire.write(buffer + displayOffset, n);
+  uint8_t err = Wire.endTransmission();
+  i2cReportResult(I2C_DEV_OLED, err == 0, err);
+  if (err != 0) {
+    displayFlushPending = false; // drop the frame, the next one starts clean
+    return;
+  }
+  displayOffset += n;
+  if (displayOffset >= OLED_FRAME_BYTES) displayFlushPending = false;
+}
+
+// ======================= Bus setup / service =======================
+void i2cBusBegin(Adafruit_SSD1306* oled) {
+  oledDisplay = oled;
+  Wire.begin();
+  applyBusConfig();
+  windowStartMs = millis();
+  // Assume present until a driver's begin() says otherwise
+  for (int d = 0; d < I2C_DEV_COUNT; d++) deviceStats[d].present = true;
+}
+
+// Runs queued low-priority transfers until budgetUs is used up.
+// EEPROM goes first; the display only gets the slots EEPROM can't use
+// (e.g. while the chip is busy with its write cycle).
+void i2cBusService(uint32_t budgetUs) {
+  uint32_t start = micros();
+  rollStatsWindow();
+  reprobeQuarantined();
+
+  while (micros() - start < budgetUs) {
+    if (eepromQueueCount > 0 && i2cDeviceAvailable(I2C_DEV_EEPROM) && eepromWaitReady(false)) {
+      eepromPopAndWrite();
+    } else if (displayFlushPending && oledDisplay && i2cDeviceAvailable(I2C_DEV_OLED)) {
+      displaySendChunk();
+    } else {
+      break;
+    }
+  }
+}
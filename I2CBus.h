@@ -0,0 +1,117 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : I2CBus.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for I2CBus.cpp.
+   Arbiter for the shared Wire bus (OLED, INA219, ADS1115, DS3231, AT24C32).
+
+   Priorities (highest first):
+   1. Sampling  (INA219, ADS1115)  → always immediate, never queued
+   2. RTC       (DS3231)           → immediate
+   3. EEPROM    (AT24C32) writes   → queued, one page chunk per slot
+   4. Display   (SSD1306) flush    → queued, one small chunk per slot
+
+   Exposed Functions:
+   - i2cBusBegin()              → Wire init at 400 kHz Fast-mode
+   - i2cBusService()            → run queued transfers within a time budget
+   - i2cSetDeferredWrites()     → switch EEPROM writes to the queue (after boot)
+   - i2cQueueEepromWrite()      → queue (or write now) an EEPROM range
+   - i2cFlushEepromWrites()     → blocking drain (call before ESP.restart())
+   - i2cEepromWaitIdle()        → block until the chip's write cycle is over (before reads)
+   - i2cRequestDisplayFlush()   → chunked, non-blocking OLED flush
+   - i2cFlushDisplayNow()       → blocking OLED flush (modal screens)
+   - I2CTransaction             → scoped bus-time accounting per device
+   - i2cDeviceStats()           → per-device transactions / utilization
+   - i2cReadReg16() / i2cWriteReg16() → checked register access
+   - i2cReportResult()          → error counting, quarantine, bus-clear
+   - i2cDeviceAvailable()       → false while a device is absent/quarantined
+   - i2cSetDevicePresent() / i2cSetReinitHandler() → boot presence + re-probe hook
+
+   Fault handling:
+   - Clock stretching is capped, so a hung slave can't hold SCL forever
+   - A device is quarantined after I2C_QUARANTINE_ERRORS consecutive
+     failures and re-probed with exponential backoff (5 s → 60 s)
+   - If SDA is found stuck low the bus is cleared with 9 SCL pulses + STOP
+*/
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+
+// Every device on the bus supports Fast-mode (400 kHz)
+#define I2C_FAST_MODE_HZ 400000UL
+#define I2C_CLOCK_STRETCH_LIMIT_US 1500
+#define I2C_QUARANTINE_ERRORS 3
+#define I2C_EEPROM_WRITE_TIMEOUT_US 20000UL   // AT24C32 tWR is 5..10 ms
+
+enum I2CDevice {
+  I2C_DEV_INA219 = 0,
+  I2C_DEV_ADS1115,
+  I2C_DEV_RTC,
+  I2C_DEV_EEPROM,
+  I2C_DEV_OLED,
+  I2C_DEV_COUNT
+};
+
+struct I2CDeviceStats {
+  uint32_t transactions;   // since boot
+  uint32_t busyUs;         // total bus time since boot
+  uint32_t maxUs;          // longest single transaction
+  uint8_t utilizationPct;  // bus share over the last window
+  uint32_t errors;         // failed transactions since boot
+  uint8_t consecutiveErrors;
+  uint8_t lastError;       // Wire error code of the last failure
+  bool present;            // detected at boot or re-probed OK
+  bool quarantined;        // skipped until the next successful re-probe
+};
+
+// Scoped accounting: wrap any direct Wire / driver access
+class I2CTransaction {
+public:
+  explicit I2CTransaction(I2CDevice dev);
+  ~I2CTransaction();
+private:
+  I2CDevice dev_;
+  uint32_t startUs_;
+};
+
+void i2cBusBegin(Adafruit_SSD1306* oled);
+void i2cBusService(uint32_t budgetUs);
+
+// EEPROM write queue
+void i2cSetDeferredWrites(bool enabled);
+void i2cQueueEepromWrite(uint16_t addr, const uint8_t* data, size_t len);
+void i2cEepromOverlay(uint16_t addr, uint8_t* buf, size_t len);
+bool i2cEepromWritePending();
+void i2cFlushEepromWrites();
+bool i2cEepromWaitIdle();
+
+// Display flush
+void i2cRequestDisplayFlush();
+bool i2cDisplayFlushPending();
+void i2cFlushDisplayNow();
+
+// Checked register access (big-endian 16-bit registers: INA219, ADS1115)
+bool i2cWriteReg16(I2CDevice dev, uint8_t addr, uint8_t reg, uint16_t value);
+bool i2cReadReg16(I2CDevice dev, uint8_t addr, uint8_t reg, uint16_t* value);
+
+// Fault handling
+void i2cReportResult(I2CDevice dev, bool ok, uint8_t errorCode = 4);
+bool i2cDeviceAvailable(I2CDevice dev);
+void i2cSetDevicePresent(I2CDevice dev, bool present);
+void i2cSetReinitHandler(I2CDevice dev, bool (*reinit)());
+bool i2cBusClear();
+uint32_t i2cBusClearCount();
+
+// Statistics
+void i2cAccount(I2CDevice dev, uint32_t busyUs);
+const I2CDeviceStats& i2cDeviceStats(I2CDevice dev);
+const char* i2cDeviceName(I2CDevice dev);
+
+#endif // I2C_BUS_H
@@ -0,0 +1,136 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : JsonWriter.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Fixed-shape JSON output with fixed-point float formatting
+   (see JsonWriter.h).
+*/
+
+#include "JsonWriter.h"
+
+static const uint32_t POW10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+const uint8_t MAX_DECIMALS = 6;
+
+JsonWriter::JsonWriter(char* buf, size_t size) : _buf(buf), _size(size) {
+  if (_size) _buf[0] = '\0';
+  put('{');
+}
+
+void JsonWriter::put(char c) {
+  if (!_overflow && _len + 1 < _size) {
+    _buf[_len++] = c;
+  } else {
+    _overflow = true;
+  }
+}
+
+void JsonWriter::putP(PGM_P s) {
+  char c;
+  while ((c = pgm_read_byte(s++)) != '\0') put(c);
+}
+
+void JsonWriter::member(PGM_P prefix) {
+  putP(_first ? prefix + 1 : prefix); // skip the comma on the first member
+  _first = false;
+}
+
+void JsonWriter::putUInt(uint32_t v) {
+  char digits[10];
+  uint8_t n = 0;
+  do {
+    digits[n++] = '0' + v % 10;
+    v /= 10;
+  } while (v);
+  while (n) put(digits[--n]);
+}
+
+void JsonWriter::putInt(int32_t v) {
+  if (v < 0) {
+    put('-');
+    putUInt(0u - (uint32_t)v);
+  } else {
+    putUInt(v);
+  }
+}
+
+// Integer part and scaled fraction as two uint32s: no printf, no doubles
+void JsonWriter::putFixed(float v, uint8_t decimals) {
+  if (isnan(v) || isinf(v)) {
+    putP(PSTR("null"));
+    return;
+  }
+  if (decimals > MAX_DECIMALS) decimals = MAX_DECIMALS;
+
+  float a = fabsf(v);
+  if (a >= 4.0e9f) { // outside uint32: rare enough for printf
+    char tmp[24];
+    snprintf_P(tmp, sizeof(tmp), PSTR("%.0f"), v);
+    for (const char* p = tmp; *p; p++) put(*p);
+    return;
+  }
+
+  uint32_t scale = POW10[decimals];
+  uint32_t whole = (uint32_t)a;
+  uint32_t frac = (uint32_t)((a - whole) * scale + 0.5f);
+  if (frac >= scale) { // rounding carried into the integer part
+    whole++;
+    frac -= scale;
+  }
+
+  // Trim trailing zeros (ArduinoJson prints 7.0 as 7 as well)
+  while (decimals && frac % 10 == 0) {
+    frac /= 10;
+    decimals--;
+  }
+
+  if (v < 0 && (whole || frac)) put('-');
+  putUInt(whole);
+  if (decimals) {
+    put('.');
+    for (uint8_t i = decimals; i-- > 0;) {
+      put('0' + (frac / POW10[i]) % 10);
+    }
+  }
+}
+
+void JsonWriter::field(PGM_P prefix, float value, uint8_t decimals) {
+  member(prefix);
+  putFixed(value, decimals);
+}
+
+void JsonWriter::field(PGM_P prefix, bool value, uint8_t) {
+  member(prefix);
+  putP(value ? PSTR("true") : PSTR("false"));
+}
+
+void JsonWriter::field(PGM_P prefix, const char* value, uint8_t) {
+  member(prefix);
+  if (!value) {
+    putP(PSTR("null"));
+    return;
+  }
+  put('"');
+  for (const char* p = value; *p; p++) {
+    char c = *p;
+    if (c == '"' || c == '\\') {
+      put('\\');
+      put(c);
+    } else if ((uint8_t)c < 0x20) {
+      char esc[7];
+      snprintf_P(esc, sizeof(esc), PSTR("\\u%04x"), (uint8_t)c);
+      for (const char* e = esc; *e; e++) put(*e);
+    } else {
+      put(c);
+    }
+  }
+  put('"');
+}
+
+const char* JsonWriter::finish() {
+  put('}');
+  if (_size) _buf[_len] = '\0';
+  return _buf;
+}
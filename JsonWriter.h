@@ -0,0 +1,70 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : JsonWriter.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for JsonWriter.cpp.
+   Serializer for responses whose shape never changes (/live_data,
+   /settings, the /wifi_config reply). The fields are an X-macro list;
+   each key is expanded at compile time into one flash literal that
+   already holds its punctuation (`,"voltage":`), so at run time only
+   the values are formatted, straight into a caller buffer. No document,
+   no key strings in RAM, no heap.
+
+   Exposed Functions:
+   - JsonWriter(buf, size)      → starts the object ("{")
+   - field(prefix, value, dec)  → one member; float / integer / bool / string
+   - finish()                   → closes the object, returns the buffer
+   - JSON_WRITE(FIELDS)         → expands a field list against a writer named `json`
+
+   Notes:
+   - Field list rows are X(key, value expression, decimals); decimals only
+     matter for floats, which are printed fixed-point with trailing zeros
+     trimmed (12.500 → 12.5), NaN/inf as null
+   - On overflow the output is cut short and overflowed() is set
+*/
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+
+class JsonWriter {
+public:
+  JsonWriter(char* buf, size_t size);
+
+  void field(PGM_P prefix, float value, uint8_t decimals);
+  void field(PGM_P prefix, double value, uint8_t decimals)            { field(prefix, (float)value, decimals); }
+  void field(PGM_P prefix, int value, uint8_t = 0)                    { member(prefix); putInt(value); }
+  void field(PGM_P prefix, long value, uint8_t = 0)                   { member(prefix); putInt(value); }
+  void field(PGM_P prefix, unsigned int value, uint8_t = 0)           { member(prefix); putUInt(value); }
+  void field(PGM_P prefix, unsigned long value, uint8_t = 0)          { member(prefix); putUInt(value); }
+  void field(PGM_P prefix, bool value, uint8_t decimals = 0);
+  void field(PGM_P prefix, const char* value, uint8_t decimals = 0);
+
+  const char* finish();
+  size_t length() const { return _len; }
+  bool overflowed() const { return _overflow; }
+
+private:
+  void member(PGM_P prefix);
+  void put(char c);
+  void putP(PGM_P s);
+  void putInt(int32_t v);
+  void putUInt(uint32_t v);
+  void putFixed(float v, uint8_t decimals);
+
+  char* _buf;
+  size_t _size;
+  size_t _len = 0;
+  bool _first = true;
+  bool _overflow = false;
+};
+
+// Every prefix carries a leading comma; the writer drops it for the first member
+#define JSON_FIELD(key, value, decimals) json.field(PSTR(",\"" key "\":"), (value), (decimals));
+#define JSON_WRITE(FIELDS) FIELDS(JSON_FIELD)
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,110 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : MemoryConfig.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Compile-time memory profiles. One switch (MEM_PROFILE) sizes the
+   firmware's own buffers and turns optional subsystems on or off:
+
+     profile    log ring    stats JSON  Blynk rx/tx  profiler  capture  slots  heap headroom
+     minimal    16 x  96 B  1536 B      256/128 B    off        256 sa   2     24 KB
+     standard   50 x 144 B  2048 B      512/128 B    on         512 sa   4     16 KB
+     full       60 x 160 B  3072 B     1024/256 B    on         704 sa   5     12 KB
+
+   (capture = burst capture samples, 4 bytes each: ~0.3 / 0.6 / 0.8 s at 860 SPS,
+    the longest window allowed by CAPTURE_MAX_WINDOW_MS;
+    slots = triggered capture slots, ~810 bytes each, plus one ~770 byte ring)
+
+   The budget below adds up what each profile puts on the heap/DRAM and a
+   static_assert refuses to build a profile that would eat into its
+   guaranteed headroom. After boot the real free heap is checked against
+   the same target (see /heap and the boot log).
+
+   Notes:
+   - Set MEM_PROFILE before the includes in BatteryMonitor.ino or with
+     -DMEM_PROFILE=0/1/2; individual flags (ENABLE_PROFILER, ...) can still
+     be overridden the same way
+   - The per-module figures are estimates for the budget check; for the
+     real static RAM/flash breakdown run tools/memory_report.py on the
+     build's .map file
+*/
+
+#ifndef MEMORY_CONFIG_H
+#define MEMORY_CONFIG_H
+
+#include <stdint.h>
+
+#define MEM_PROFILE_MINIMAL  0
+#define MEM_PROFILE_STANDARD 1
+#define MEM_PROFILE_FULL     2
+
+#ifndef MEM_PROFILE
+#define MEM_PROFILE MEM_PROFILE_STANDARD
+#endif
+
+// ===== Feature switches (preprocessor, so disabled code is not linked) =====
+#if MEM_PROFILE == MEM_PROFILE_MINIMAL
+  #ifndef ENABLE_PROFILER
+  #define ENABLE_PROFILER 0
+  #endif
+  #define MEM_BLYNK_READBYTES 256
+  #define MEM_BLYNK_SENDBYTES 128
+#elif MEM_PROFILE == MEM_PROFILE_STANDARD
+  #define MEM_BLYNK_READBYTES 512
+  #define MEM_BLYNK_SENDBYTES 128
+#elif MEM_PROFILE == MEM_PROFILE_FULL
+  #define MEM_BLYNK_READBYTES 1024
+  #define MEM_BLYNK_SENDBYTES 256
+#else
+  #error "MEM_PROFILE must be 0 (minimal), 1 (standard) or 2 (full)"
+#endif
+
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER 1
+#endif
+
+// ===== Buffer sizes =====
+struct MemProfile {
+  const char* name;
+  uint16_t logLines;        // serial log ring (AppServer.cpp)
+  uint16_t logLineLen;
+  uint16_t statsJsonBytes;  // DynamicJsonDocument of the stats endpoints
+  uint16_t heapHeadroom;    // free heap that must remain after boot
+  uint16_t captureSamples;  // burst capture buffer (Capture.cpp)
+  uint8_t triggerSlots;     // triggered capture slots (Trigger.cpp)
+};
+
+constexpr MemProfile MEM_PROFILES[] = {
+  { "minimal",  16,  96, 1536, 24576,  256, 2 },
+  { "standard", 50, 144, 2048, 16384,  512, 4 },
+  { "full",     60, 160, 3072, 12288,  704, 5 },
+};
+
+constexpr MemProfile MEM = MEM_PROFILES[MEM_PROFILE];
+
+// ===== Budget (bytes) =====
+constexpr uint32_t MEM_USABLE_HEAP = 50UL * 1024;   // free heap after core + WiFi + libraries
+
+constexpr uint32_t MEM_OLED_FRAMEBUFFER = 128 * 64 / 8;
+constexpr uint32_t MEM_WEB_SERVER = 3072;            // ESP8266WebServer + one client
+constexpr uint32_t MEM_HISTORY = 5000;               // trend rings (24 B buckets) + precomputed graphs
+constexpr uint32_t MEM_I2C_QUEUE = 600;              // EEPROM write queue
+constexpr uint32_t MEM_HISTOGRAM = 280;              // load profile counters
+constexpr uint32_t MEM_FORECAST = 360;               // weekday x hour current profile
+constexpr uint32_t MEM_PROFILER = 9 * (16 + 24 * 4); // per-probe histograms
+constexpr uint32_t MEM_LOG_RING = (uint32_t)MEM.logLines * MEM.logLineLen;
+constexpr uint32_t MEM_BLYNK = MEM_BLYNK_READBYTES + MEM_BLYNK_SENDBYTES;
+constexpr uint32_t MEM_CAPTURE = (uint32_t)MEM.captureSamples * 4;
+constexpr uint32_t MEM_TRIGGER = (MEM.triggerSlots + 1) * (40 + 128 * 6);   // slots + pre-trigger ring
+
+constexpr uint32_t MEM_FIRMWARE_BYTES =
+    MEM_OLED_FRAMEBUFFER + MEM_WEB_SERVER + MEM_HISTORY + MEM_HISTOGRAM + MEM_FORECAST + MEM_I2C_QUEUE +
+    MEM_LOG_RING + MEM_BLYNK + MEM.statsJsonBytes + MEM_CAPTURE + MEM_TRIGGER +
+    (ENABLE_PROFILER ? MEM_PROFILER : 0);
+
+static_assert(MEM_FIRMWARE_BYTES + MEM.heapHeadroom <= MEM_USABLE_HEAP,
+              "memory profile does not leave its guaranteed heap headroom");
+
+#endif // MEMORY_CONFIG_H
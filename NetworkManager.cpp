@@ -0,0 +1,459 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : NetworkManager.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Non-blocking WiFi station state machine (see NetworkManager.h).
+
+   Connectivity probe:
+   - Step 1: async DNS lookup of PROBE_HOST (lwIP dns_gethostbyname)
+   - Step 2: raw lwIP TCP connect to port 80, closed as soon as it opens
+   - Both steps only register callbacks; networkService() polls the result,
+     so a probe never blocks loop(). The whole probe times out after
+     PROBE_TIMEOUT_MS.
+   - While offline the probe interval backs off 5 s → 10 s → … → 15 min;
+     while online a slow recheck detects loss of the uplink.
+
+   Notes:
+   - Only the first join can time out into FAILED; after that the SDK's
+     auto-reconnect is left to do its job and we just track the link
+   - Leaving STA mode (AP from the menu, WiFi off) parks the machine in OFF
+   - A reused lease is not renewed with the DHCP server; it is only taken
+     when it is fresh (WIFI_LEASE_REUSE_S, needs a valid clock), otherwise
+     only the BSSID/channel part of the cache is used
+   - lwIP callbacks run from the SDK between loop() passes, never
+     concurrently with it, so plain statics are safe here
+*/
+
+#include "NetworkManager.h"
+#include "EEPROMUtils.h"
+#include "TimeSync.h"
+#include <ESP8266WiFi.h>
+#include <lwip/dns.h>
+#include <lwip/tcp.h>
+
+#define PROBE_HOST "clients3.google.com"
+#define PROBE_PORT 80
+#define PROBE_TIMEOUT_MS 3000UL
+
+#define FAST_CACHE_MAGIC 0xA5
+#define STATIC_IP_MAGIC 0x5A
+
+// Persisted records (checksum is always the last byte)
+struct WiFiFastCache {
+  uint32_t ip, gateway, subnet, dns;
+  uint32_t savedAt;        // local epoch of the lease, 0 = unknown
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t magic;
+  uint8_t reserved[3];
+  uint8_t checksum;
+};
+
+struct WiFiStaticIp {
+  uint32_t ip, gateway, subnet, dns;
+  uint8_t magic;
+  uint8_t reserved[2];
+  uint8_t checksum;
+};
+
+static NetState state = NET_OFF;
+static unsigned long stateSinceMs = 0;
+static bool everConnected = false;
+static void (*eventHandler)(NetEvent) = nullptr;
+
+// ======================= Join state =======================
+static const char* joinSsid = nullptr;
+static const char* joinPass = nullptr;
+static unsigned long joinBeginMs = 0;
+static bool directedJoin = false;        // still on the cached-BSSID attempt
+static NetConnectStats connectStats = { 0, NET_FAST_NONE, false, 0 };
+
+// ======================= Probe state =======================
+enum ProbePhase { PROBE_IDLE, PROBE_DNS, PROBE_CONNECT };
+enum ProbeResult { PROBE_PENDING, PROBE_OK, PROBE_FAIL };
+
+static ProbePhase probePhase = PROBE_IDLE;
+static uint32_t probeGeneration = 0;     // ignores DNS answers from timed-out probes
+static unsigned long probeStartMs = 0;
+static ip_addr_t probeAddr;
+static bool dnsDone = false, dnsOk = false;
+static struct tcp_pcb* probePcb = nullptr;
+static bool tcpDone = false, tcpOk = false;
+
+static unsigned long lastProbeMs = 0;
+static unsigned long probeWaitMs = 0;    // time from lastProbeMs to the next probe
+static unsigned long probeBackoffMs = PROBE_BACKOFF_MIN_MS;
+static NetProbeStats probeStats = {};
+
+// ======================= Fast-connect cache =======================
+static uint8_t recordChecksum(const uint8_t* data, size_t len) {
+  uint8_t sum = 0x3C;
+  for (size_t i = 0; i < len; i++) {
+    sum = (uint8_t)((sum << 1) | (sum >> 7)) ^ data[i];
+  }
+  return sum;
+}
+
+static bool loadFastCache(WiFiFastCache* c) {
+  readBytes(ADDR_WIFI_FAST_CACHE, (uint8_t*)c, sizeof(*c));
+  return c->magic == FAST_CACHE_MAGIC &&
+         c->checksum == recordChecksum((const uint8_t*)c, sizeof(*c) - 1);
+}
+
+static bool loadStaticIp(WiFiStaticIp* c) {
+  readBytes(ADDR_WIFI_STATIC_IP, (uint8_t*)c, sizeof(*c));
+  return c->magic == STATIC_IP_MAGIC &&
+         c->checksum == recordChecksum((const uint8_t*)c, sizeof(*c) - 1);
+}
+
+static bool leaseFresh(const WiFiFastCache& c) {
+  uint32_t now = timeSyncUnixtime();
+  if (c.ip == 0 || c.savedAt == 0 || now == 0 || now < c.savedAt) return false;
+  return now - c.savedAt < WIFI_LEASE_REUSE_S;
+}
+
+static void saveFastCache() {
+  WiFiFastCache stored;
+  bool haveStored = loadFastCache(&stored);
+
+  WiFiFastCache c;
+  memset(&c, 0, sizeof(c));
+  if (connectStats.path == NET_FAST_LEASE && haveStored) {
+    // Reused lease: not renewed, so it keeps its original address and age
+    c.ip = stored.ip;
+    c.gateway = stored.gateway;
+    c.subnet = stored.subnet;
+    c.dns = stored.dns;
+    c.savedAt = stored.savedAt;
+  } else if (connectStats.path != NET_FAST_STATIC) {
+    c.ip = (uint32_t)WiFi.localIP();
+    c.gateway = (uint32_t)WiFi.gatewayIP();
+    c.subnet = (uint32_t)WiFi.subnetMask();
+    c.dns = (uint32_t)WiFi.dnsIP(0);
+    c.savedAt = timeSyncUnixtime();
+  }
+  memcpy(c.bssid, WiFi.BSSID(), sizeof(c.bssid));
+  c.channel = (uint8_t)WiFi.channel();
+  c.magic = FAST_CACHE_MAGIC;
+  c.checksum = recordChecksum((const uint8_t*)&c, sizeof(c) - 1);
+
+  if (haveStored && memcmp(&c, &stored, sizeof(c)) == 0) return; // unchanged: spare the EEPROM
+  writeBytes(ADDR_WIFI_FAST_CACHE, (const uint8_t*)&c, sizeof(c));
+}
+
+// Directed join did not come up: normal scan + DHCP
+static void fallBackToScan() {
+  Serial.println(F("Directed WiFi join failed, falling back to full scan."));
+  directedJoin = false;
+  connectStats.fellBack = true;
+  connectStats.fallbacks++;
+
+  WiFi.disconnect();
+  if (connectStats.path == NET_FAST_LEASE) {
+    WiFi.config(IPAddress(), IPAddress(), IPAddress()); // back to DHCP
+  }
+  WiFi.begin(joinSsid, joinPass);
+}
+
+// ======================= Helpers =======================
+static void setState(NetState next) {
+  state = next;
+  stateSinceMs = millis();
+}
+
+static void emit(NetEvent event) {
+  if (eventHandler) eventHandler(event);
+}
+
+static void probeDnsFound(const char* name, const ip_addr_t* ipaddr, void* arg) {
+  (void)name;
+  if (probePhase != PROBE_DNS || (uint32_t)(uintptr_t)arg != probeGeneration) return;
+  if (ipaddr) {
+    probeAddr = *ipaddr;
+    dnsOk = true;
+  }
+  dnsDone = true;
+}
+
+static err_t probeConnected(void* arg, struct tcp_pcb* pcb, err_t err) {
+  (void)arg;
+  tcpOk = (err == ERR_OK);
+  tcpDone = true;
+  probePcb = nullptr;
+
+  // Reachability is all we need; drop the connection straight away
+  tcp_arg(pcb, nullptr);
+  tcp_err(pcb, nullptr);
+  if (tcp_close(pcb) != ERR_OK) {
+    tcp_abort(pcb);
+    return ERR_ABRT;
+  }
+  return ERR_OK;
+}
+
+static void probeError(void* arg, err_t err) {
+  (void)arg;
+  (void)err;
+  probePcb = nullptr; // already freed by lwIP
+  tcpOk = false;
+  tcpDone = true;
+}
+
+static void probeCancel() {
+  if (probePcb) {
+    tcp_arg(probePcb, nullptr);
+    tcp_err(probePcb, nullptr);
+    tcp_abort(probePcb);
+    probePcb = nullptr;
+  }
+  probePhase = PROBE_IDLE;
+}
+
+static void probeStart() {
+  probeGeneration++;
+  dnsDone = dnsOk = tcpDone = tcpOk = false;
+  probeStartMs = millis();
+  probePhase = PROBE_DNS;
+
+  err_t err = dns_gethostbyname(PROBE_HOST, &probeAddr, probeDnsFound,
+                                (void*)(uintptr_t)probeGeneration);
+  if (err == ERR_OK) {
+    dnsDone = dnsOk = true; // answered from the DNS cache
+  } else if (err != ERR_INPROGRESS) {
+    dnsDone = true;
+  }
+}
+
+static ProbeResult probeFinish(bool ok) {
+  probeCancel();
+  unsigned long tookMs = millis() - probeStartMs;
+  lastProbeMs = millis();
+  probeStats.probes++;
+  if (!ok) probeStats.failures++;
+  probeStats.lastProbeMs = tookMs;
+  return ok ? PROBE_OK : PROBE_FAIL;
+}
+
+// Advances the probe; returns PROBE_PENDING until it has an answer
+static ProbeResult probeStep() {
+  if (probePhase == PROBE_IDLE) return PROBE_PENDING;
+
+  if (millis() - probeStartMs >= PROBE_TIMEOUT_MS) {
+    return probeFinish(false);
+  }
+
+  if (probePhase == PROBE_DNS) {
+    if (!dnsDone) return PROBE_PENDING;
+    if (!dnsOk) return probeFinish(false);
+
+    probePcb = tcp_new();
+    if (!probePcb) return probeFinish(false);
+    tcp_arg(probePcb, nullptr);
+    tcp_err(probePcb, probeError);
+    if (tcp_connect(probePcb, &probeAddr, PROBE_PORT, probeConnected) != ERR_OK) {
+      tcp_err(probePcb, nullptr);
+      tcp_close(probePcb);
+      probePcb = nullptr;
+      return probeFinish(false);
+    }
+    probePhase = PROBE_CONNECT;
+    return PROBE_PENDING;
+  }
+
+  if (!tcpDone) return PROBE_PENDING;
+  return probeFinish(tcpOk);
+}
+
+static void scheduleProbe(unsigned long waitMs) {
+  lastProbeMs = millis();
+  probeWaitMs = waitMs;
+}
+
+// ======================= Public API =======================
+void networkBegin(const char* ssid, const char* pass) {
+  joinSsid = ssid;
+  joinPass = pass;
+  WiFi.mode(WIFI_STA);
+
+  WiFiFastCache cache;
+  WiFiStaticIp staticIp;
+  bool haveCache = loadFastCache(&cache);
+  NetFastPath path = NET_FAST_NONE;
+
+  if (loadStaticIp(&staticIp)) {
+    WiFi.config(IPAddress(staticIp.ip), IPAddress(staticIp.gateway),
+                IPAddress(staticIp.subnet), IPAddress(staticIp.dns));
+    path = NET_FAST_STATIC;
+  } else if (haveCache && leaseFresh(cache)) {
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway),
+                IPAddress(cache.subnet), IPAddress(cache.dns));
+    path = NET_FAST_LEASE;
+  }
+
+  if (haveCache && cache.channel >= 1 && cache.channel <= 14) {
+    WiFi.begin(ssid, pass, cache.channel, cache.bssid);
+    if (path == NET_FAST_NONE) path = NET_FAST_BSSID;
+    directedJoin = true;
+  } else {
+    WiFi.begin(ssid, pass);
+    directedJoin = false;
+  }
+
+  connectStats.path = path;
+  connectStats.fellBack = false;
+  joinBeginMs = millis();
+  everConnected = false;
+  setState(NET_CONNECTING);
+}
+
+void networkService() {
+  if (state == NET_OFF || state == NET_FAILED) return;
+
+  if (!(WiFi.getMode() & WIFI_STA)) {
+    probeCancel();
+    setState(NET_OFF);
+    return;
+  }
+
+  unsigned long now = millis();
+  bool linked = (WiFi.status() == WL_CONNECTED);
+
+  if (!linked && (state == NET_CONNECTED || state == NET_ONLINE)) {
+    probeCancel();
+    setState(NET_CONNECTING);
+    emit(NET_EVENT_DISCONNECTED);
+    return;
+  }
+
+  switch (state) {
+    case NET_CONNECTING:
+      if (linked) {
+        if (!everConnected) connectStats.lastJoinMs = now - joinBeginMs;
+        directedJoin = false;
+        saveFastCache(); // refresh BSSID / channel / lease for the next boot
+        everConnected = true;
+        probeBackoffMs = PROBE_BACKOFF_MIN_MS;
+        scheduleProbe(0);
+        setState(NET_CONNECTED);
+        emit(NET_EVENT_CONNECTED);
+      } else if (directedJoin && now - stateSinceMs >= WIFI_FAST_CONNECT_TIMEOUT_MS) {
+        fallBackToScan();
+        setState(NET_CONNECTING); // full join budget for the scan
+      } else if (!everConnected && now - stateSinceMs >= WIFI_CONNECT_TIMEOUT_MS) {
+        setState(NET_FAILED);
+        emit(NET_EVENT_FAILED);
+      }
+      break;
+
+    case NET_CONNECTED:
+    case NET_ONLINE: {
+      if (probePhase == PROBE_IDLE) {
+        if (now - lastProbeMs >= probeWaitMs) probeStart();
+        break;
+      }
+
+      ProbeResult result = probeStep();
+      if (result == PROBE_PENDING) break;
+
+      if (result == PROBE_OK) {
+        probeBackoffMs = PROBE_BACKOFF_MIN_MS;
+        scheduleProbe(ONLINE_RECHECK_INTERVAL_MS);
+        if (state != NET_ONLINE) {
+          setState(NET_ONLINE);
+          emit(NET_EVENT_ONLINE);
+        }
+      } else if (state == NET_ONLINE) {
+        // Uplink lost: start over with a short retry
+        probeBackoffMs = PROBE_BACKOFF_MIN_MS;
+        scheduleProbe(probeBackoffMs);
+        setState(NET_CONNECTED);
+        emit(NET_EVENT_OFFLINE);
+      } else {
+        scheduleProbe(probeBackoffMs);
+        probeBackoffMs = min(probeBackoffMs * 2, (unsigned long)PROBE_BACKOFF_MAX_MS);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+NetState networkState() {
+  return state;
+}
+
+bool networkIsConnected() {
+  return state == NET_CONNECTED || state == NET_ONLINE;
+}
+
+bool networkIsOnline() {
+  return state == NET_ONLINE;
+}
+
+const NetProbeStats& networkProbeStats() {
+  probeStats.nextProbeInMs = (probePhase == PROBE_IDLE && networkIsConnected())
+      ? probeWaitMs - min(probeWaitMs, millis() - lastProbeMs) : 0;
+  return probeStats;
+}
+
+const NetConnectStats& networkConnectStats() {
+  return connectStats;
+}
+
+const char* networkFastPathName(NetFastPath path) {
+  switch (path) {
+    case NET_FAST_BSSID:  return "bssid";
+    case NET_FAST_LEASE:  return "bssid+lease";
+    case NET_FAST_STATIC: return "static";
+    default:              return "scan";
+  }
+}
+
+void networkSetStaticIp(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns) {
+  WiFiStaticIp c;
+  memset(&c, 0, sizeof(c));
+  c.ip = (uint32_t)ip;
+  c.gateway = (uint32_t)gateway;
+  c.subnet = (uint32_t)subnet;
+  c.dns = (uint32_t)dns;
+  c.magic = STATIC_IP_MAGIC;
+  c.checksum = recordChecksum((const uint8_t*)&c, sizeof(c) - 1);
+  writeBytes(ADDR_WIFI_STATIC_IP, (const uint8_t*)&c, sizeof(c));
+}
+
+void networkClearStaticIp() {
+  WiFiStaticIp c;
+  memset(&c, 0, sizeof(c));
+  writeBytes(ADDR_WIFI_STATIC_IP, (const uint8_t*)&c, sizeof(c));
+}
+
+bool networkStaticIpEnabled() {
+  WiFiStaticIp c;
+  return loadStaticIp(&c);
+}
+
+void networkForgetFastConnect() {
+  WiFiFastCache c;
+  memset(&c, 0, sizeof(c));
+  writeBytes(ADDR_WIFI_FAST_CACHE, (const uint8_t*)&c, sizeof(c));
+}
+
+void networkSetEventHandler(void (*handler)(NetEvent event)) {
+  eventHandler = handler;
+}
+
+const char* networkStateName(NetState s) {
+  switch (s) {
+    case NET_OFF:        return "off";
+    case NET_CONNECTING: return "connecting";
+    case NET_CONNECTED:  return "connected";
+    case NET_ONLINE:     return "online";
+    case NET_FAILED:     return "failed";
+    default:             return "?";
+  }
+}
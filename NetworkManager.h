@@ -0,0 +1,109 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : NetworkManager.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for NetworkManager.cpp.
+   Non-blocking WiFi station state machine. WiFi.begin() is issued once
+   and the join, link loss and internet check are stepped from loop(),
+   so sensors and the web server run while the radio connects.
+   Internet reachability comes from an asynchronous DNS + TCP probe with
+   exponential backoff, so no call here ever waits on the network.
+
+   Fast reconnect:
+   - The BSSID, channel and DHCP lease of the last successful join are
+     cached in EEPROM; the next boot joins that AP directly (no channel
+     scan) and reuses the lease (no DHCP) if it is less than 12 h old
+   - An optional user static IP always replaces DHCP
+   - If the directed join fails within 4 s, a normal scan + DHCP join
+     follows within the usual 10 s budget
+
+   States:
+   OFF → CONNECTING → CONNECTED (link up) → ONLINE (internet reachable)
+                    ↘ FAILED (first join timed out; caller falls back to AP)
+
+   Exposed Functions:
+   - networkBegin()            → start joining (returns immediately)
+   - networkService()          → step the state machine (call every loop pass)
+   - networkState(), networkIsConnected(), networkIsOnline()
+   - networkSetEventHandler()  → callback on state transitions
+   - networkProbeStats()       → probe count / failures / next probe
+   - networkConnectStats()     → join time and which fast path was used
+   - networkSetStaticIp() / networkClearStaticIp() / networkForgetFastConnect()
+   - networkStateName()
+*/
+
+#ifndef NETWORK_MANAGER_H
+#define NETWORK_MANAGER_H
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#define WIFI_CONNECT_TIMEOUT_MS 10000UL
+#define WIFI_FAST_CONNECT_TIMEOUT_MS 4000UL   // directed join before falling back to a scan
+#define WIFI_LEASE_REUSE_S (12UL * 3600UL)
+
+// EEPROM layout (after the WiFi password at 564..627)
+#define ADDR_WIFI_FAST_CACHE 640   // 32 B: BSSID / channel / lease of the last join
+#define ADDR_WIFI_STATIC_IP 672    // 20 B: optional user static IP
+#define PROBE_BACKOFF_MIN_MS 5000UL                          // first retry while offline
+#define PROBE_BACKOFF_MAX_MS (15UL * 60UL * 1000UL)          // backoff ceiling
+#define ONLINE_RECHECK_INTERVAL_MS (5UL * 60UL * 1000UL)     // uplink check while online
+
+enum NetState {
+  NET_OFF = 0,
+  NET_CONNECTING,
+  NET_CONNECTED,
+  NET_ONLINE,
+  NET_FAILED
+};
+
+enum NetEvent {
+  NET_EVENT_CONNECTED,     // station got an IP
+  NET_EVENT_ONLINE,        // internet probe passed
+  NET_EVENT_OFFLINE,       // link still up, but the probe failed
+  NET_EVENT_DISCONNECTED,  // link lost (radio keeps auto-reconnecting)
+  NET_EVENT_FAILED         // first join timed out
+};
+
+struct NetProbeStats {
+  uint32_t probes;
+  uint32_t failures;
+  uint32_t lastProbeMs;    // duration of the last probe
+  uint32_t nextProbeInMs;
+};
+
+enum NetFastPath {
+  NET_FAST_NONE = 0,    // full scan + DHCP
+  NET_FAST_BSSID,       // directed join, DHCP
+  NET_FAST_LEASE,       // directed join, cached lease
+  NET_FAST_STATIC       // user static IP (directed join if cached)
+};
+
+struct NetConnectStats {
+  uint32_t lastJoinMs;     // WiFi.begin() → link up, last join
+  NetFastPath path;        // path of the last join attempt
+  bool fellBack;           // directed join failed, scan was needed
+  uint32_t fallbacks;      // since boot
+};
+
+void networkBegin(const char* ssid, const char* pass);
+void networkService();
+
+NetState networkState();
+bool networkIsConnected();
+bool networkIsOnline();
+const NetProbeStats& networkProbeStats();
+const NetConnectStats& networkConnectStats();
+const char* networkFastPathName(NetFastPath path);
+
+void networkSetStaticIp(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns);
+void networkClearStaticIp();
+bool networkStaticIpEnabled();
+void networkForgetFastConnect();   // new credentials → old AP/lease no longer valid
+void networkSetEventHandler(void (*handler)(NetEvent event));
+const char* networkStateName(NetState state);
+
+#endif // NETWORK_MANAGER_H
@@ -0,0 +1,67 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Profiler.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Log2 latency histograms per subsystem (see Profiler.h).
+*/
+
+#include "Profiler.h"
+
+static PerfStats stats[PERF_PROBE_COUNT];
+
+static uint8_t bucketFor(uint32_t us) {
+  uint8_t b = us ? (uint8_t)(32 - __builtin_clz(us)) : 0;
+  return b < PERF_BUCKETS ? b : PERF_BUCKETS - 1;
+}
+
+static uint32_t bucketUpperUs(uint8_t b) {
+  return b ? (1UL << b) - 1 : 0;
+}
+
+void perfRecordCycles(PerfProbe probe, uint32_t cycles) {
+  uint32_t us = cycles / ESP.getCpuFreqMHz();
+  PerfStats& st = stats[probe];
+  st.count++;
+  st.totalUs += us;
+  if (us > st.maxUs) st.maxUs = us;
+  st.buckets[bucketFor(us)]++;
+}
+
+const PerfStats& perfStats(PerfProbe probe) {
+  return stats[probe];
+}
+
+uint32_t perfPercentileUs(PerfProbe probe, uint8_t percentile) {
+  const PerfStats& st = stats[probe];
+  if (st.count == 0) return 0;
+
+  uint32_t target = (uint32_t)(((uint64_t)st.count * percentile + 99) / 100);
+  uint32_t seen = 0;
+  for (uint8_t b = 0; b < PERF_BUCKETS; b++) {
+    seen += st.buckets[b];
+    if (seen >= target) return min(bucketUpperUs(b), st.maxUs);
+  }
+  return st.maxUs;
+}
+
+void perfReset() {
+  memset(stats, 0, sizeof(stats));
+}
+
+const char* perfProbeName(PerfProbe probe) {
+  switch (probe) {
+    case PERF_LOOP:     return "loop";
+    case PERF_SAMPLING: return "sampling";
+    case PERF_SOC:      return "soc";
+    case PERF_HTTP:     return "http";
+    case PERF_BLYNK:    return "blynk";
+    case PERF_NETWORK:  return "network";
+    case PERF_OLED:     return "oled";
+    case PERF_BUTTONS:  return "buttons";
+    case PERF_EEPROM:   return "eeprom";
+    default:            return "?";
+  }
+}
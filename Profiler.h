@@ -0,0 +1,75 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Profiler.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Profiler.cpp.
+   Always-on latency profiler. Subsystems are timed with the CPU cycle
+   counter (ESP.getCycleCount()) and each duration lands in a fixed
+   log2 histogram, so recording costs a few dozen cycles and no memory.
+
+   Exposed Functions:
+   - PERF_SCOPE(probe)      → time the enclosing block
+   - perfRecordCycles()     → record a measured duration
+   - perfStats()            → count / max / avg for a probe
+   - perfPercentileUs()     → p50 / p99 estimate from the histogram
+   - perfReset(), perfProbeName()
+
+   Notes:
+   - Bucket b holds durations in [2^(b-1), 2^b) µs (bucket 0 = below 1 µs),
+     so percentiles are upper bounds within a factor of two, capped at max
+   - Build with ENABLE_PROFILER 0 (default in the minimal memory profile)
+     to compile the probes out entirely
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "MemoryConfig.h"   // ENABLE_PROFILER default comes from the memory profile
+
+#define PERF_BUCKETS 24   // up to ~8 s
+
+enum PerfProbe {
+  PERF_LOOP = 0,     // one full scheduler pass
+  PERF_SAMPLING,     // ADS1115 / INA219 reads
+  PERF_SOC,          // coulomb counting, SOC / energy tracking
+  PERF_HTTP,         // server.handleClient()
+  PERF_BLYNK,        // Blynk.run()
+  PERF_NETWORK,      // WiFi state machine + time sync
+  PERF_OLED,         // frame render + flush request
+  PERF_BUTTONS,      // processButtons()
+  PERF_EEPROM,       // queued EEPROM page writes
+  PERF_PROBE_COUNT
+};
+
+struct PerfStats {
+  uint32_t count;
+  uint32_t maxUs;
+  uint64_t totalUs;
+  uint32_t buckets[PERF_BUCKETS];
+};
+
+void perfRecordCycles(PerfProbe probe, uint32_t cycles);
+const PerfStats& perfStats(PerfProbe probe);
+uint32_t perfPercentileUs(PerfProbe probe, uint8_t percentile);
+void perfReset();
+const char* perfProbeName(PerfProbe probe);
+
+#if ENABLE_PROFILER
+class PerfScope {
+public:
+  explicit PerfScope(PerfProbe probe) : probe_(probe), start_(ESP.getCycleCount()) {}
+  ~PerfScope() { perfRecordCycles(probe_, ESP.getCycleCount() - start_); }
+private:
+  PerfProbe probe_;
+  uint32_t start_;
+};
+#define PERF_SCOPE(probe) PerfScope perfScope_##probe(probe)
+#else
+#define PERF_SCOPE(probe) do {} while (0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,132 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Scheduler.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Cooperative priority scheduler (see Scheduler.h).
+
+   Notes:
+   - Tasks are kept sorted by priority (stable, so registration order
+     breaks ties)
+   - A periodic task keeps its nominal release grid; if it falls a whole
+     period behind, missed releases are dropped instead of run back to back
+   - A period-0 task is released again as soon as it finishes, so its
+     start latency is the gap between two consecutive runs
+*/
+
+#include "Scheduler.h"
+#include "StallWatch.h"
+
+static SchedTask tasks[SCHED_MAX_TASKS];
+static uint8_t taskCount = 0;
+static uint32_t passes = 0;
+
+// ======================= Helpers =======================
+static bool isDue(const SchedTask& t, uint32_t nowMs) {
+  return (int32_t)(nowMs - t.releaseMs) >= 0;
+}
+
+static void runTask(SchedTask& t) {
+  STALL_MARK(t.name);
+  uint32_t startMs = millis();
+  uint32_t lateMs = startMs - t.releaseMs;
+
+  uint32_t startUs = micros();
+  t.fn();
+  uint32_t runUs = micros() - startUs;
+
+  TaskStats& st = t.stats;
+  st.runs++;
+  st.lastRunUs = runUs;
+  if (runUs > st.maxRunUs) st.maxRunUs = runUs;
+  if (lateMs > st.maxLateMs) st.maxLateMs = lateMs;
+  if (lateMs > t.deadlineMs) st.deadlineMisses++;
+  if (runUs > t.budgetUs) st.overBudget++;
+
+  uint32_t endMs = millis();
+  if (t.periodMs == 0) {
+    t.releaseMs = endMs;
+  } else {
+    t.releaseMs += t.periodMs;
+    if ((int32_t)(endMs - t.releaseMs) >= 0) t.releaseMs = endMs + t.periodMs;
+  }
+}
+
+static void runDueHardTasks() {
+  for (uint8_t i = 0; i < taskCount && tasks[i].priority == TASK_PRIO_HARD; i++) {
+    if (isDue(tasks[i], millis())) runTask(tasks[i]);
+  }
+}
+
+// ======================= Public API =======================
+int schedulerAddTask(const char* name, TaskFn fn, TaskPriority priority,
+                     uint32_t periodMs, uint32_t deadlineMs, uint32_t budgetUs) {
+  if (taskCount >= SCHED_MAX_TASKS || !fn) return -1;
+
+  // Insert after every task of the same or higher priority
+  uint8_t pos = taskCount;
+  while (pos > 0 && tasks[pos - 1].priority > priority) {
+    tasks[pos] = tasks[pos - 1];
+    pos--;
+  }
+
+  SchedTask& t = tasks[pos];
+  memset(&t, 0, sizeof(t));
+  t.name = name;
+  t.fn = fn;
+  t.priority = priority;
+  t.periodMs = periodMs;
+  t.deadlineMs = deadlineMs;
+  t.budgetUs = budgetUs;
+  t.releaseMs = millis();
+  taskCount++;
+  return pos;
+}
+
+void schedulerRun() {
+  passes++;
+  uint32_t passStartUs = micros();
+
+  runDueHardTasks();
+
+  for (uint8_t i = 0; i < taskCount; i++) {
+    SchedTask& t = tasks[i];
+    if (t.priority == TASK_PRIO_HARD) continue;
+
+    uint32_t nowMs = millis();
+    if (!isDue(t, nowMs)) continue;
+
+    bool overdue = (nowMs - t.releaseMs) >= t.deadlineMs;
+    if (micros() - passStartUs > SCHED_PASS_BUDGET_US && !overdue) {
+      t.stats.deferrals++;
+      continue;
+    }
+
+    runTask(t);
+    runDueHardTasks(); // sampling gets the CPU back between soft tasks
+  }
+}
+
+uint8_t schedulerTaskCount() {
+  return taskCount;
+}
+
+const SchedTask& schedulerTask(uint8_t index) {
+  return tasks[index < taskCount ? index : 0];
+}
+
+uint32_t schedulerPasses() {
+  return passes;
+}
+
+const char* schedulerPriorityName(TaskPriority priority) {
+  switch (priority) {
+    case TASK_PRIO_HARD:   return "hard";
+    case TASK_PRIO_HIGH:   return "high";
+    case TASK_PRIO_NORMAL: return "normal";
+    case TASK_PRIO_LOW:    return "low";
+    default:               return "?";
+  }
+}
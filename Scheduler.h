@@ -0,0 +1,76 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Scheduler.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Scheduler.cpp.
+   Small cooperative scheduler for loop(). Each task has a priority, a
+   period (0 = every pass), a deadline (max start latency after release)
+   and a run-time budget. HARD tasks (sampling, coulomb integration) run
+   every time they are due and again between every lower-priority task;
+   HIGH/NORMAL/LOW tasks fill the rest of a pass and are deferred to the
+   next pass when the pass budget is used up, unless already past their
+   deadline.
+
+   Exposed Functions:
+   - schedulerAddTask()   → register a task (call from setup())
+   - schedulerRun()       → one dispatch pass (call from loop())
+   - schedulerTaskCount(), schedulerTask() → per-task statistics
+   - schedulerPriorityName()
+
+   Notes:
+   - Tasks are plain functions and must return quickly (no blocking waits)
+   - Statistics: runs, deadline misses, budget overruns, deferrals,
+     worst start latency and worst run time
+*/
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#define SCHED_MAX_TASKS 12
+#define SCHED_PASS_BUDGET_US 15000UL   // soft tasks stop being started after this
+
+enum TaskPriority {
+  TASK_PRIO_HARD = 0,
+  TASK_PRIO_HIGH,
+  TASK_PRIO_NORMAL,
+  TASK_PRIO_LOW
+};
+
+typedef void (*TaskFn)();
+
+struct TaskStats {
+  uint32_t runs;
+  uint32_t deadlineMisses;   // started later than release + deadline
+  uint32_t overBudget;       // ran longer than its budget
+  uint32_t deferrals;        // skipped in a pass because the pass budget was spent
+  uint32_t maxLateMs;        // worst start latency after release
+  uint32_t maxRunUs;
+  uint32_t lastRunUs;
+};
+
+struct SchedTask {
+  const char* name;
+  TaskFn fn;
+  TaskPriority priority;
+  uint32_t periodMs;
+  uint32_t deadlineMs;
+  uint32_t budgetUs;
+  uint32_t releaseMs;        // when it last became (or next becomes) due
+  TaskStats stats;
+};
+
+int schedulerAddTask(const char* name, TaskFn fn, TaskPriority priority,
+                     uint32_t periodMs, uint32_t deadlineMs, uint32_t budgetUs);
+void schedulerRun();
+
+uint8_t schedulerTaskCount();
+const SchedTask& schedulerTask(uint8_t index);
+uint32_t schedulerPasses();
+const char* schedulerPriorityName(TaskPriority priority);
+
+#endif // SCHEDULER_H
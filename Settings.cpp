@@ -0,0 +1,360 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Settings.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Table-driven settings: EEPROM load/save, validation, JSON output and
+   the streaming POST /settings parser (see Settings.h).
+*/
+
+#include "Settings.h"
+#include "AppServer.h"
+#include "EEPROMUtils.h"
+#include "Alarms.h"
+#include <stdarg.h>
+
+extern float totalCoulombs;
+extern unsigned long lastActiveStateChange;
+
+FLASH_STRING_TABLE(batteryTypes,
+  "Li-ion\0"
+  "Lead Acid\0"
+  "Li-Po\0");
+
+// ======================= Table (flash) =======================
+#define SETTING_STRINGS(id, key, label, units, var, addr, lo, hi, step, def, dec) \
+  static const char id##_KEY[] PROGMEM = key; \
+  static const char id##_LABEL[] PROGMEM = label; \
+  static const char id##_UNITS[] PROGMEM = units; \
+  static const char id##_JSON[] PROGMEM = ",\"" key "\":";
+SETTINGS_TABLE(SETTING_STRINGS)
+#undef SETTING_STRINGS
+
+#define SETTING_ROW(id, key, label, units, var, addr, lo, hi, step, def, dec) \
+  { id##_KEY, id##_LABEL, id##_UNITS, (void*)&var, addr, settingTypeOf(&var), dec, lo, hi, step, def },
+static const SettingDef SETTINGS[SETTING_COUNT] PROGMEM = {
+  SETTINGS_TABLE(SETTING_ROW)
+};
+#undef SETTING_ROW
+
+// JSON member prefixes for settingsWriteJson(), punctuation included
+#define SETTING_JSON_PREFIX(id, ...) id##_JSON,
+static const char* const SETTING_JSON[SETTING_COUNT] PROGMEM = {
+  SETTINGS_TABLE(SETTING_JSON_PREFIX)
+};
+#undef SETTING_JSON_PREFIX
+
+// settingsFind() binary-searches the keys, so the rows must stay sorted
+#define SETTING_KEY(id, key, ...) key,
+constexpr const char* SETTING_KEYS[] = { SETTINGS_TABLE(SETTING_KEY) };
+#undef SETTING_KEY
+
+constexpr int keyCompare(const char* a, const char* b) {
+  return (*a != *b || !*a) ? *a - *b : keyCompare(a + 1, b + 1);
+}
+
+constexpr bool keysSorted(int i) {
+  return i + 1 >= SETTING_COUNT || (keyCompare(SETTING_KEYS[i], SETTING_KEYS[i + 1]) < 0 && keysSorted(i + 1));
+}
+
+static_assert(keysSorted(0), "SETTINGS_TABLE rows must be sorted by key");
+
+// ======================= Helpers =======================
+static void assign(const SettingDef& d, float value) {
+  switch (d.type) {
+    case SETTING_FLOAT: *(float*)d.value = value; break;
+    case SETTING_U8:    *(uint8_t*)d.value = (uint8_t)lroundf(value); break;
+    case SETTING_UINT:  *(unsigned int*)d.value = (unsigned int)lroundf(value); break;
+  }
+}
+
+static float valueOf(const SettingDef& d) {
+  switch (d.type) {
+    case SETTING_U8:   return *(uint8_t*)d.value;
+    case SETTING_UINT: return *(unsigned int*)d.value;
+    default:           return *(float*)d.value;
+  }
+}
+
+static bool inRange(const SettingDef& d, float value) {
+  return !isnan(value) && value >= d.minValue && value <= d.maxValue;
+}
+
+// Side effects of a change (not run when loading at boot)
+static void applyChange(SettingId id) {
+  switch (id) {
+    case SETTING_SOC:
+      lastActiveStateChange = millis(); // keep voltage-based SOC from overriding it right away
+      // fall through
+    case SETTING_CAPACITY:
+      totalCoulombs = (soc / 100.0) * batteryCapacityAh * 3600.0;
+      break;
+    case SETTING_MIN_VOLTAGE:
+    case SETTING_MAX_VOLTAGE:
+      alarmsCompile(); // voltage alarm levels
+      break;
+    default:
+      break;
+  }
+}
+
+// ======================= Public API =======================
+SettingDef settingsDef(SettingId id) {
+  SettingDef d;
+  memcpy_P(&d, &SETTINGS[id], sizeof(d));
+  return d;
+}
+
+const StringTable* settingsChoices(SettingId id) {
+  return id == SETTING_BATTERY_TYPE ? &batteryTypes : nullptr;
+}
+
+void settingsLoad(SettingId id) {
+  SettingDef d = settingsDef(id);
+  float value;
+  if (d.type == SETTING_FLOAT) {
+    readFloat(d.addr, &value);
+  } else {
+    uint32_t raw;
+    readInt(d.addr, &raw);
+    value = raw;
+  }
+  assign(d, inRange(d, value) ? value : d.defaultValue); // blank/corrupt → default
+}
+
+void settingsLoadAll() {
+  for (int8_t id = 0; id < SETTING_COUNT; id++) {
+    settingsLoad((SettingId)id);
+  }
+}
+
+void settingsSave(SettingId id) {
+  SettingDef d = settingsDef(id);
+  if (d.type == SETTING_FLOAT) {
+    writeFloat(d.addr, *(float*)d.value);
+  } else {
+    writeInt(d.addr, (uint32_t)valueOf(d));
+  }
+}
+
+float settingsGet(SettingId id) {
+  return valueOf(settingsDef(id));
+}
+
+bool settingsValid(SettingId id, float value) {
+  return inRange(settingsDef(id), value);
+}
+
+float settingsMinFor(SettingId id) {
+  SettingDef d = settingsDef(id);
+  if (id == SETTING_MAX_VOLTAGE) return max(d.minValue, minVoltageThreshold + d.step);
+  return d.minValue;
+}
+
+bool settingsSet(SettingId id, float value) {
+  SettingDef d = settingsDef(id);
+  if (!inRange(d, value)) return false;
+  assign(d, value);
+  settingsSave(id);
+  applyChange(id);
+
+  char key[24];
+  strncpy_P(key, d.key, sizeof(key) - 1);
+  key[sizeof(key) - 1] = '\0';
+  addSerialLogf_P(PSTR("💾 %s = %.*f (EEPROM @ %u)"), key, d.decimals, valueOf(d), d.addr);
+  return true;
+}
+
+void settingsResetToDefault(SettingId id) {
+  SettingDef d = settingsDef(id);
+  assign(d, d.defaultValue);
+  settingsSave(id);
+  applyChange(id);
+}
+
+SettingId settingsFind(const char* key) {
+  int lo = 0, hi = SETTING_COUNT - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    int cmp = strcmp_P(key, (PGM_P)pgm_read_ptr(&SETTINGS[mid].key));
+    if (cmp == 0) return (SettingId)mid;
+    if (cmp < 0) hi = mid - 1;
+    else lo = mid + 1;
+  }
+  return SETTING_NONE;
+}
+
+// ======================= JSON =======================
+const uint8_t SETTINGS_JSON_DECIMALS = 4;   // more than the editors show, so calibrated values round-trip
+
+void settingsWriteJson(JsonWriter& json) {
+  for (int8_t id = 0; id < SETTING_COUNT; id++) {
+    SettingDef d = settingsDef((SettingId)id);
+    PGM_P prefix = (PGM_P)pgm_read_ptr(&SETTING_JSON[id]);
+    if (d.type == SETTING_FLOAT) {
+      json.field(prefix, *(float*)d.value, SETTINGS_JSON_DECIMALS);
+    } else {
+      json.field(prefix, (unsigned long)valueOf(d));
+    }
+  }
+}
+
+void settingsToJson(JsonDocument& doc) {
+  for (int8_t id = 0; id < SETTING_COUNT; id++) {
+    SettingDef d = settingsDef((SettingId)id);
+    if (d.type == SETTING_FLOAT) {
+      doc[FPSTR(d.key)] = *(float*)d.value;
+    } else {
+      doc[FPSTR(d.key)] = (uint32_t)valueOf(d);
+    }
+  }
+}
+
+// ======================= Streaming parser =======================
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool isNumberChar(char c) {
+  return (c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+void SettingsParser::begin(size_t contentLength) {
+  _state = OPEN;
+  _bytes = 0;
+  _keyLen = 0;
+  _numLen = 0;
+  _id = SETTING_NONE;
+  _count = 0;
+  _err[0] = '\0';
+  if (contentLength > SETTINGS_MAX_BODY) {
+    fail(PSTR("Body too large (max %u bytes)"), (unsigned)SETTINGS_MAX_BODY);
+  }
+}
+
+bool SettingsParser::fail(PGM_P fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf_P(_err, sizeof(_err), fmt, args);
+  va_end(args);
+  _state = FAILED;
+  return false;
+}
+
+bool SettingsParser::feed(const char* data, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    if (_state == FAILED) return false;
+    if (++_bytes > SETTINGS_MAX_BODY) {
+      return fail(PSTR("Body too large (max %u bytes)"), (unsigned)SETTINGS_MAX_BODY);
+    }
+    if (!step(data[i])) return false;
+  }
+  return _state != FAILED;
+}
+
+// One character of {"key": number, ...}
+bool SettingsParser::step(char c) {
+  switch (_state) {
+    case OPEN:
+      if (isSpace(c)) return true;
+      if (c == '{') { _state = KEY_OR_END; return true; }
+      break;
+
+    case KEY_OR_END:
+    case KEY_START:
+      if (isSpace(c)) return true;
+      if (c == '"') { _keyLen = 0; _state = KEY; return true; }
+      if (c == '}' && _state == KEY_OR_END) { _state = DONE; return true; }
+      break;
+
+    case KEY:
+      if (c == '"') {
+        _key[_keyLen] = '\0';
+        _id = settingsFind(_key);
+        if (_id == SETTING_NONE) return fail(PSTR("Unknown setting '%s'"), _key);
+        _state = COLON;
+        return true;
+      }
+      if (c == '\\' || _keyLen >= sizeof(_key) - 1) { // no registry key needs either
+        _key[_keyLen] = '\0';
+        return fail(PSTR("Unknown setting '%s...'"), _key);
+      }
+      _key[_keyLen++] = c;
+      return true;
+
+    case COLON:
+      if (isSpace(c)) return true;
+      if (c == ':') { _state = VALUE; return true; }
+      break;
+
+    case VALUE:
+      if (isSpace(c)) return true;
+      if (c == '-' || (c >= '0' && c <= '9')) {
+        _num[0] = c;
+        _numLen = 1;
+        _state = NUMBER;
+        return true;
+      }
+      return fail(PSTR("'%s' must be a number"), _key);
+
+    case NUMBER:
+      if (isNumberChar(c)) {
+        if (_numLen >= sizeof(_num) - 1) return fail(PSTR("'%s' must be a number"), _key);
+        _num[_numLen++] = c;
+        return true;
+      }
+      if (!endNumber()) return false;
+      _state = AFTER_VALUE;
+      return step(c);
+
+    case AFTER_VALUE:
+      if (isSpace(c)) return true;
+      if (c == ',') { _state = KEY_START; return true; }
+      if (c == '}') { _state = DONE; return true; }
+      break;
+
+    case DONE:
+      if (isSpace(c)) return true;
+      break;
+
+    default:
+      return false;
+  }
+  return fail(PSTR("Invalid JSON at byte %u"), (unsigned)_bytes);
+}
+
+// Value complete: parse, range-check and stage it (a repeated key overwrites)
+bool SettingsParser::endNumber() {
+  _num[_numLen] = '\0';
+  char* end;
+  float value = strtod(_num, &end);
+  if (end != _num + _numLen) return fail(PSTR("'%s' must be a number"), _key);
+
+  SettingDef d = settingsDef(_id);
+  if (!inRange(d, value)) {
+    return fail(PSTR("'%s' out of range (%.*f..%.*f)"),
+                _key, d.decimals, d.minValue, d.decimals, d.maxValue);
+  }
+
+  uint8_t i = 0;
+  while (i < _count && _ids[i] != _id) i++;
+  _ids[i] = _id;
+  _values[i] = value;
+  if (i == _count) _count++;
+  return true;
+}
+
+bool SettingsParser::finish() {
+  if (_state == FAILED) return false;
+  if (_state == IDLE || (_state == OPEN && _bytes == 0)) return fail(PSTR("Body missing"));
+  if (_state != DONE) return fail(PSTR("Invalid JSON (truncated)"));
+  return true;
+}
+
+void SettingsParser::apply() {
+  for (uint8_t i = 0; i < _count; i++) {
+    settingsSet(_ids[i], _values[i]);
+  }
+}
@@ -0,0 +1,155 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Settings.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Settings.cpp.
+   Declarative settings registry. Every user setting is one row of
+   SETTINGS_TABLE (JSON key, OLED label, units, variable, EEPROM offset,
+   range, step, default, decimals); load, save, validation, the /settings
+   JSON and the OLED value editor are generic code driven by that table.
+
+   Exposed Functions:
+   - settingsLoadAll()          → read every setting, out-of-range → default
+   - settingsSet(id, value)     → validate, assign, persist, apply side effects
+   - settingsGet(id), settingsSave(id), settingsResetToDefault(id)
+   - settingsFind(key)          → binary search by JSON key (SETTING_NONE = unknown)
+   - settingsDef(id)            → copy of the row (labels are PGM_P)
+   - settingsMinFor(id)         → lower bound incl. cross-setting limits
+   - settingsWriteJson()        → GET /settings body (JsonWriter, keys from flash)
+   - settingsToJson()           → same object via ArduinoJson (benchmark baseline)
+   - SettingsParser             → streaming POST /settings parser (begin/feed/finish/apply)
+
+   Notes:
+   - Rows must stay sorted by key (checked at compile time)
+   - Every value takes 4 bytes of EEPROM (float or uint32)
+   - The table lives in flash; settingsDef() copies one row out
+   - Adding a setting = one row here + the variable it points at
+   - SettingsParser takes the body in chunks as they arrive; it keeps one
+     key and one number token plus the staged values (~100 bytes) and
+     never builds a document or copies the body
+*/
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "StringTable.h"
+#include "JsonWriter.h"
+
+// Variables the registry points at (BatteryMonitor.ino)
+extern uint8_t batteryType;
+extern float batteryCapacityAh;
+extern float chargingCurrentThreshold;
+extern float currentDeadzoneThreshold;
+extern float currentOffset;
+extern float dischargingCurrentThreshold;
+extern float maxVoltageThreshold;
+extern float minVoltageThreshold;
+extern float mVperAmp;
+extern unsigned int screenTimeout;
+extern float soc;
+extern float voltageOffset;
+
+// ===== Registry =====
+// X(id, key, label, units, variable, eeprom, min, max, step, default, decimals)
+#define SETTINGS_TABLE(X) \
+  X(SETTING_BATTERY_TYPE,        "battery_type",        "Battery Type",   "",     batteryType,                 80,   0,    2,    1,    0,    0) \
+  X(SETTING_CAPACITY,            "capacity_ah",         "Capacity",       "Ah",   batteryCapacityAh,           20,   0.1,  2000, 0.1,  7.0,  1) \
+  X(SETTING_CHARGE_THRESHOLD,    "charge_threshold",    "Charge Thresh",  "A",    chargingCurrentThreshold,    200,  0.1,  10,   0.1,  0.6,  2) \
+  X(SETTING_CURRENT_DEADZONE,    "current_deadzone",    "Curr Deadzone",  "A",    currentDeadzoneThreshold,    220,  0,    5,    0.01, 0.25, 2) \
+  X(SETTING_CURRENT_OFFSET,      "current_offset",      "Current Offset", "A",    currentOffset,               40,   -5,   5,    0.01, 0,    2) \
+  X(SETTING_DISCHARGE_THRESHOLD, "discharge_threshold", "Dischg Thresh",  "A",    dischargingCurrentThreshold, 210,  0.1,  10,   0.1,  1.0,  2) \
+  X(SETTING_MAX_VOLTAGE,         "max_voltage",         "Max Voltage",    "V",    maxVoltageThreshold,         70,   0.1,  100,  0.1,  14.0, 2) \
+  X(SETTING_MIN_VOLTAGE,         "min_voltage",         "Min Voltage",    "V",    minVoltageThreshold,         60,   0.1,  100,  0.1,  10.0, 2) \
+  X(SETTING_MV_PER_AMP,          "mv_per_amp",          "mV per Amp",     "mV/A", mVperAmp,                    50,   0.1,  1000, 0.1,  22,   2) \
+  X(SETTING_SCREEN_TIMEOUT,      "screen_timeout",      "Screen Timeout", "s",    screenTimeout,               90,   5,    300,  5,    30,   0) \
+  X(SETTING_SOC,                 "soc",                 "SOC",            "%",    soc,                         140,  0,    100,  1,    100,  2) \
+  X(SETTING_VOLTAGE_OFFSET,      "voltage_offset",      "Voltage Offset", "V",    voltageOffset,               30,   -5,   5,    0.01, 0,    2)
+
+#define SETTING_ENUM_ENTRY(id, key, label, units, var, addr, lo, hi, step, def, dec) id,
+enum SettingId : int8_t {
+  SETTING_NONE = -1,
+  SETTINGS_TABLE(SETTING_ENUM_ENTRY)
+  SETTING_COUNT
+};
+#undef SETTING_ENUM_ENTRY
+
+enum SettingType : uint8_t { SETTING_FLOAT, SETTING_U8, SETTING_UINT };
+
+constexpr SettingType settingTypeOf(const float*)        { return SETTING_FLOAT; }
+constexpr SettingType settingTypeOf(const uint8_t*)      { return SETTING_U8; }
+constexpr SettingType settingTypeOf(const unsigned int*) { return SETTING_UINT; }
+
+struct SettingDef {
+  PGM_P key;
+  PGM_P label;
+  PGM_P units;
+  void* value;
+  uint16_t addr;
+  SettingType type;
+  uint8_t decimals;
+  float minValue;
+  float maxValue;
+  float step;
+  float defaultValue;
+};
+
+void settingsLoadAll();
+void settingsLoad(SettingId id);
+void settingsSave(SettingId id);
+bool settingsSet(SettingId id, float value);
+float settingsGet(SettingId id);
+void settingsResetToDefault(SettingId id);
+bool settingsValid(SettingId id, float value);
+float settingsMinFor(SettingId id);
+SettingId settingsFind(const char* key);   // SETTING_NONE if unknown
+SettingDef settingsDef(SettingId id);
+
+void settingsWriteJson(JsonWriter& json);
+void settingsToJson(JsonDocument& doc);
+
+// ===== Streaming POST parser =====
+// Flat JSON object of numbers: {"key": 1.5, ...}. Every pair is looked up
+// and range-checked as soon as its value ends; the first problem stops the
+// parse, and nothing is written unless the whole body is valid.
+const size_t SETTINGS_MAX_BODY = 512;   // longer bodies fail as soon as they cross it
+
+class SettingsParser {
+public:
+  void begin(size_t contentLength = 0);     // Content-Length, if known, is checked up front
+  bool feed(const char* data, size_t len);   // false once the body is rejected
+  bool finish();                             // true = complete object, all values valid
+  void apply();                              // settingsSet() every staged value
+  void reset() { _state = IDLE; }
+  bool started() const { return _state != IDLE; }
+  uint8_t count() const { return _count; }
+  const char* error() const { return _err; }
+
+private:
+  enum State : uint8_t { IDLE, OPEN, KEY_OR_END, KEY_START, KEY, COLON, VALUE, NUMBER, AFTER_VALUE, DONE, FAILED };
+
+  bool step(char c);
+  bool endNumber();
+  bool fail(PGM_P fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  State _state = IDLE;
+  size_t _bytes = 0;
+  char _key[24];
+  uint8_t _keyLen = 0;
+  SettingId _id = SETTING_NONE;
+  char _num[16];
+  uint8_t _numLen = 0;
+  SettingId _ids[SETTING_COUNT];
+  float _values[SETTING_COUNT];
+  uint8_t _count = 0;
+  char _err[64];
+};
+
+// Choice lists for enumerated settings (battery_type); nullptr = numeric
+const StringTable* settingsChoices(SettingId id);
+
+#endif // SETTINGS_H
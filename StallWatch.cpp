@@ -0,0 +1,167 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : StallWatch.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Loop-stall watchdog with RTC-memory records (see StallWatch.h).
+
+   Notes:
+   - RTC user memory is 512 bytes; this block uses the first 264
+   - A record is only taken if no deeper marker already recorded one
+     inside the same span, so nested scopes don't double-report
+*/
+
+#include "StallWatch.h"
+#include "TimeSync.h"
+#include <Ticker.h>
+
+const uint32_t STALL_RTC_MAGIC = 0x5354414C; // "STAL"
+const uint32_t STALL_RTC_OFFSET = 0;         // in 4-byte blocks
+
+struct StallRtcBlock {
+  uint32_t magic;
+  uint8_t head;          // next slot to write
+  uint8_t count;
+  uint8_t pendingValid;  // a stall was in progress when this was saved
+  uint8_t reserved;
+  StallRecord pending;
+  StallRecord records[STALL_MAX_RECORDS];
+  uint32_t checksum;
+};
+
+static StallRtcBlock rtcBlock;
+static Ticker stallTicker;
+
+static const char* markStack[STALL_MAX_DEPTH];
+static uint8_t markDepth = 0;
+
+static uint32_t lastFeedMs = 0;
+static uint32_t seqAtLastFeed = 0;
+static uint32_t recordSeq = 0;
+
+// ======================= RTC persistence =======================
+static uint32_t blockChecksum(const StallRtcBlock& b) {
+  const uint8_t* p = (const uint8_t*)&b;
+  uint32_t sum = 0x811C9DC5;
+  for (size_t i = 0; i < offsetof(StallRtcBlock, checksum); i++) {
+    sum = (sum ^ p[i]) * 0x01000193; // FNV-1a
+  }
+  return sum;
+}
+
+static void saveBlock() {
+  rtcBlock.magic = STALL_RTC_MAGIC;
+  rtcBlock.checksum = blockChecksum(rtcBlock);
+  ESP.rtcUserMemoryWrite(STALL_RTC_OFFSET, (uint32_t*)&rtcBlock, sizeof(rtcBlock));
+}
+
+static void fillRecord(StallRecord& r, const char* name, uint32_t durationMs, uint8_t flags) {
+  memset(&r, 0, sizeof(r));
+  strncpy(r.name, name, sizeof(r.name) - 1);
+  r.flags = flags;
+  r.durationMs = durationMs;
+  r.uptimeS = millis() / 1000;
+  r.unixTime = timeSyncUnixtime();
+}
+
+static void pushRecord(const StallRecord& r) {
+  rtcBlock.records[rtcBlock.head] = r;
+  rtcBlock.head = (rtcBlock.head + 1) % STALL_MAX_RECORDS;
+  if (rtcBlock.count < STALL_MAX_RECORDS) rtcBlock.count++;
+  recordSeq++;
+}
+
+static void addRecord(const char* name, uint32_t durationMs) {
+  StallRecord r;
+  fillRecord(r, name, durationMs, 0);
+  pushRecord(r);
+  rtcBlock.pendingValid = 0;
+  saveBlock();
+}
+
+static const char* currentMarker() {
+  if (markDepth == 0) return "loop";
+  return markStack[min<uint8_t>(markDepth, STALL_MAX_DEPTH) - 1];
+}
+
+// Runs from the SDK timer while loop() is stuck in a yielding wait
+static void checkHeartbeat() {
+  uint32_t gap = millis() - lastFeedMs;
+  if (gap < STALL_THRESHOLD_MS) return;
+  fillRecord(rtcBlock.pending, currentMarker(), gap, STALL_ENDED_IN_RESET);
+  rtcBlock.pendingValid = 1;
+  saveBlock();
+}
+
+// ======================= Public API =======================
+void stallWatchBegin() {
+  bool valid = ESP.rtcUserMemoryRead(STALL_RTC_OFFSET, (uint32_t*)&rtcBlock, sizeof(rtcBlock)) &&
+               rtcBlock.magic == STALL_RTC_MAGIC &&
+               rtcBlock.checksum == blockChecksum(rtcBlock) &&
+               rtcBlock.count <= STALL_MAX_RECORDS && rtcBlock.head < STALL_MAX_RECORDS;
+  if (!valid) {
+    memset(&rtcBlock, 0, sizeof(rtcBlock));
+  } else {
+    for (uint8_t i = 0; i < rtcBlock.count; i++) {
+      rtcBlock.records[i].flags |= STALL_FROM_PREVIOUS_BOOT;
+    }
+    if (rtcBlock.pendingValid) {   // froze and never came back
+      rtcBlock.pending.flags |= STALL_FROM_PREVIOUS_BOOT;
+      pushRecord(rtcBlock.pending);
+      rtcBlock.pendingValid = 0;
+    }
+  }
+  saveBlock();
+
+  lastFeedMs = millis();
+  seqAtLastFeed = recordSeq;
+  stallTicker.attach_ms(STALL_CHECK_MS, checkHeartbeat);
+}
+
+void stallWatchFeed() {
+  uint32_t now = millis();
+  uint32_t gap = now - lastFeedMs;
+  if (gap >= STALL_THRESHOLD_MS && recordSeq == seqAtLastFeed) {
+    addRecord(rtcBlock.pendingValid ? rtcBlock.pending.name : "loop", gap);
+  } else if (rtcBlock.pendingValid) {
+    rtcBlock.pendingValid = 0;   // already recorded by a marker
+    saveBlock();
+  }
+  lastFeedMs = now;
+  seqAtLastFeed = recordSeq;
+}
+
+void stallMarkEnter(const char* name) {
+  if (markDepth < STALL_MAX_DEPTH) markStack[markDepth] = name;
+  markDepth++;
+}
+
+void stallMarkExit(const char* name, uint32_t startMs, uint32_t seqAtStart) {
+  if (markDepth > 0) markDepth--;
+  uint32_t duration = millis() - startMs;
+  if (duration >= STALL_THRESHOLD_MS && recordSeq == seqAtStart) {
+    addRecord(name, duration);
+  }
+}
+
+uint32_t stallRecordSeq() {
+  return recordSeq;
+}
+
+uint8_t stallRecordCount() {
+  return rtcBlock.count;
+}
+
+const StallRecord& stallRecord(uint8_t index) {
+  uint8_t slot = (rtcBlock.head + STALL_MAX_RECORDS - 1 - (index % STALL_MAX_RECORDS)) % STALL_MAX_RECORDS;
+  return rtcBlock.records[slot];
+}
+
+void stallClear() {
+  memset(&rtcBlock, 0, sizeof(rtcBlock));
+  recordSeq++;
+  seqAtLastFeed = recordSeq;
+  saveBlock();
+}
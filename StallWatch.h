@@ -0,0 +1,77 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : StallWatch.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for StallWatch.cpp.
+   Software loop-stall watchdog. loop() feeds it every pass; code that may
+   block is wrapped in STALL_MARK("name") scopes (every scheduler task is
+   marked automatically). A scope that runs longer than STALL_THRESHOLD_MS
+   is recorded under its own name, so a stall is charged to the innermost
+   marker that covers it. The last STALL_MAX_RECORDS stalls are kept in RTC
+   user memory and survive soft resets and watchdog resets.
+
+   Exposed Functions:
+   - stallWatchBegin()     → load records from RTC memory, start the checker
+   - stallWatchFeed()      → loop heartbeat (call once per loop pass)
+   - STALL_MARK(name)      → attribute time spent in the enclosing block
+   - stallRecordCount(), stallRecord(), stallClear()
+
+   Notes:
+   - A Ticker checks the heartbeat every STALL_CHECK_MS; while a stall is
+     in progress it keeps a "pending" record in RTC memory, so a freeze that
+     ends in a reset is still reported (flag STALL_ENDED_IN_RESET) on the
+     next boot. Ticker only fires while the blocked code yields (delay(),
+     yield(), WiFi waits); a busy spin is caught when it returns
+   - Records are newest-first; marker names are truncated to 15 chars
+*/
+
+#ifndef STALL_WATCH_H
+#define STALL_WATCH_H
+
+#include <Arduino.h>
+
+#define STALL_THRESHOLD_MS 1000UL
+#define STALL_CHECK_MS 250
+#define STALL_MAX_RECORDS 8
+#define STALL_MAX_DEPTH 6
+
+// Record flags
+#define STALL_FROM_PREVIOUS_BOOT 0x01
+#define STALL_ENDED_IN_RESET     0x02
+
+struct StallRecord {
+  char name[15];
+  uint8_t flags;
+  uint32_t durationMs;
+  uint32_t unixTime;      // local time at the end of the stall (0 = unknown)
+  uint32_t uptimeS;       // uptime when the stall ended
+};
+
+void stallWatchBegin();
+void stallWatchFeed();
+
+uint8_t stallRecordCount();
+const StallRecord& stallRecord(uint8_t index);  // 0 = newest
+void stallClear();
+
+void stallMarkEnter(const char* name);
+void stallMarkExit(const char* name, uint32_t startMs, uint32_t seqAtStart);
+uint32_t stallRecordSeq();
+
+class StallScope {
+public:
+  explicit StallScope(const char* name)
+    : name_(name), startMs_(millis()), seq_(stallRecordSeq()) { stallMarkEnter(name); }
+  ~StallScope() { stallMarkExit(name_, startMs_, seq_); }
+private:
+  const char* name_;
+  uint32_t startMs_;
+  uint32_t seq_;
+};
+
+#define STALL_MARK(name) StallScope stallScope_(name)
+
+#endif // STALL_WATCH_H
@@ -0,0 +1,23 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : StringTable.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Flash string table lookup and shared PROGMEM strings (see StringTable.h).
+*/
+
+#include "StringTable.h"
+
+const char MIME_TEXT_PLAIN[] PROGMEM = "text/plain";
+const char MIME_TEXT_HTML[] PROGMEM = "text/html";
+
+PGM_P strTableItemP(const StringTable& table, uint8_t index) {
+  if (index >= table.count) return PSTR("");
+  PGM_P p = table.text;
+  while (index--) {
+    p += strlen_P(p) + 1;
+  }
+  return p;
+}
@@ -0,0 +1,58 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : StringTable.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for StringTable.cpp.
+   Flash-resident string tables. On the ESP8266 every plain literal and
+   every `const char* x[] = {...}` array is copied into DRAM at boot; a
+   table defined here stays in flash as a single PROGMEM blob of
+   NUL-separated items, with no pointer array either.
+
+   Exposed Functions:
+   - FLASH_STRING_TABLE(name, items) → define a table: "Back\0" "Save\0"
+   - strTableItem(table, i)  → __FlashStringHelper* for print()/getTextBounds()
+   - strTableItemP(table, i) → PGM_P for the *_P string functions
+   - MIME_TEXT_PLAIN / MIME_TEXT_HTML → content types for send_P()
+
+   Notes:
+   - Every item must end with "\0"; the count is worked out at compile time
+   - Lookup walks the blob, which is fine for menu-sized tables (< 16 items)
+   - Log messages use addSerialLog(F("...")) / addSerialLogf_P(PSTR("..."), ...)
+*/
+
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <Arduino.h>
+
+struct StringTable {
+  PGM_P text;      // "item0\0item1\0...\0" in flash
+  uint8_t count;
+};
+
+constexpr uint8_t strTableCount(const char* items, size_t len) {
+  uint8_t n = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (items[i] == '\0') n++;
+  }
+  return n;
+}
+
+#define FLASH_STRING_TABLE(name, items) \
+  static const char name##Text[] PROGMEM = items; \
+  constexpr StringTable name = { name##Text, strTableCount(items, sizeof(items) - 1) }
+
+PGM_P strTableItemP(const StringTable& table, uint8_t index);
+
+inline const __FlashStringHelper* strTableItem(const StringTable& table, uint8_t index) {
+  return FPSTR(strTableItemP(table, index));
+}
+
+// Content types shared by the HTTP handlers
+extern const char MIME_TEXT_PLAIN[] PROGMEM;
+extern const char MIME_TEXT_HTML[] PROGMEM;
+
+#endif // STRING_TABLE_H
@@ -0,0 +1,288 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : TimeSync.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Software clock disciplined by SNTP, with the DS3231 as holdover.
+
+   Clock model:
+   - clock = base + (millis() - baseMillis) + slew, where the slew term is
+     limited to TIME_SLEW_RATE_PPM of the elapsed time. A negative
+     correction therefore only slows the clock down; it never runs back.
+   - A clock more than TIME_STEP_THRESHOLD_MS ahead is held instead: the
+     slew may then cancel all elapsed time, so the clock stands still
+     until real time has caught up. Only forward errors are stepped.
+   - The base is folded forward every few seconds, so the arithmetic
+     stays within 32-bit millis() range.
+
+   NTP:
+   - configTime() is called once; the core's SNTP client re-polls on its
+     own and settimeofday_cb() flags every answer. Nothing here waits.
+
+   RTC:
+   - Rewritten only when it is RTC_MAX_ERROR_S or more off NTP
+   - Drift (ppm) = growth of the RTC error since the last rewrite, once
+     the baseline is at least RTC_DRIFT_MIN_BASELINE_S long
+   - Without fresh NTP the software clock is re-anchored to the RTC every
+     hour (its TCXO is better than the ESP8266 crystal), minus the error
+     the drift estimate predicts since the last rewrite
+*/
+
+#include "TimeSync.h"
+#include "I2CBus.h"
+#include "AppServer.h"
+#include <time.h>
+#include <sys/time.h>
+#include <coredecls.h>
+
+extern RTC_DS3231 rtc;
+
+#define REBASE_INTERVAL_MS 10000UL
+#define RTC_RETRY_INTERVAL_MS 5000UL   // while there is no time source at all
+#define NTP_FRESH_MS (2UL * RTC_REANCHOR_INTERVAL_MS)
+
+static uint64_t baseMs = 0;           // local-epoch ms at baseMillis
+static uint32_t baseMillis = 0;
+static int32_t slewRemainingMs = 0;
+static bool holdClock = false;        // negative slew may cancel all elapsed time
+
+static TimeSyncStatus status = {
+  TIME_SOURCE_NONE, 0, 0, 0, false, 0, 0, 0xFFFFFFFFUL, 0, 0.0f, false, 0
+};
+
+static bool sntpStarted = false;
+static volatile bool ntpSamplePending = false;
+static uint32_t lastNtpMillis = 0;
+static uint32_t lastRtcAnchorMillis = 0;
+
+// RTC drift baseline: NTP time and RTC error right after the last rewrite
+static bool rtcBaseValid = false;
+static uint32_t rtcBaseSec = 0;
+static int32_t rtcBaseErrS = 0;
+
+// ======================= Clock arithmetic =======================
+static int32_t slewApplied(uint32_t elapsedMs) {
+  int32_t maxSlew = holdClock ? (int32_t)min(elapsedMs, (uint32_t)INT32_MAX)
+                              : (int32_t)((uint64_t)elapsedMs * TIME_SLEW_RATE_PPM / 1000000UL);
+  if (slewRemainingMs > maxSlew) return maxSlew;
+  if (slewRemainingMs < -maxSlew) return -maxSlew;
+  return slewRemainingMs;
+}
+
+static uint64_t clockNowMs() {
+  uint32_t elapsed = millis() - baseMillis;
+  return baseMs + elapsed + slewApplied(elapsed);
+}
+
+static void rebase() {
+  uint32_t nowMillis = millis();
+  uint32_t elapsed = nowMillis - baseMillis;
+  int32_t applied = slewApplied(elapsed);
+  baseMs += (int64_t)elapsed + applied;
+  slewRemainingMs -= applied;
+  baseMillis = nowMillis;
+  if (slewRemainingMs == 0) holdClock = false;
+}
+
+static void setClock(uint64_t localMs) {
+  baseMs = localMs;
+  baseMillis = millis();
+  slewRemainingMs = 0;
+  holdClock = false;
+}
+
+// Slew toward target; if the error is too large step forward or hold
+// (clock ahead), so the clock never runs back. No time yet: just set it.
+static void correctTo(uint64_t targetMs, TimeSource source) {
+  rebase();
+  int64_t err = (int64_t)(targetMs - baseMs);
+  status.lastOffsetMs = (int32_t)constrain(err, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+
+  if (status.source == TIME_SOURCE_NONE) {
+    setClock(targetMs);
+  } else if (err > TIME_STEP_THRESHOLD_MS) {
+    setClock(targetMs);
+    status.steps++;
+  } else if (err < -TIME_STEP_THRESHOLD_MS) {
+    slewRemainingMs = (int32_t)max(err, (int64_t)INT32_MIN);
+    holdClock = true;
+    status.holds++;
+  } else {
+    slewRemainingMs = (int32_t)err; // newest estimate replaces the old one
+    holdClock = false;
+  }
+  status.source = source;
+}
+
+static bool rtcPlausible(const DateTime& t) {
+  return t.year() >= 2024 && t.year() < 2100;
+}
+
+// ======================= RTC =======================
+bool timeSyncReadRtc(DateTime* out) {
+  if (!i2cDeviceAvailable(I2C_DEV_RTC)) return false;
+  I2CTransaction t(I2C_DEV_RTC);
+  Wire.beginTransmission(0x68);
+  uint8_t err = Wire.endTransmission();
+  i2cReportResult(I2C_DEV_RTC, err == 0, err);
+  if (err != 0) return false;
+  *out = rtc.now();
+  return true;
+}
+
+// RTC reading minus the error its drift estimate predicts since the last
+// rewrite (whole-second RTC: assume mid-second)
+static uint64_t rtcCompensatedMs(const DateTime& rtcNow) {
+  int64_t rtcMs = (int64_t)rtcNow.unixtime() * 1000LL + 500;
+  if (rtcBaseValid && status.rtcDriftValid) {
+    uint32_t sinceBaseS = rtcNow.unixtime() - rtcBaseSec;
+    rtcMs -= (int64_t)rtcBaseErrS * 1000LL + (int64_t)(status.rtcDriftPpm * sinceBaseS / 1000.0f);
+  }
+  return (uint64_t)rtcMs;
+}
+
+static void disciplineRtc(uint64_t ntpMs) {
+  DateTime rtcNow;
+  if (!timeSyncReadRtc(&rtcNow)) return;
+
+  uint32_t ntpSec = (uint32_t)(ntpMs / 1000);
+  int32_t errS = (int32_t)(rtcNow.unixtime() - ntpSec);
+  status.rtcErrorS = errS;
+
+  if (rtcBaseValid) {
+    uint32_t baseline = ntpSec - rtcBaseSec;
+    if (baseline >= RTC_DRIFT_MIN_BASELINE_S) {
+      status.rtcDriftPpm = (errS - rtcBaseErrS) * 1e6f / baseline;
+      status.rtcDriftValid = true;
+    }
+  }
+
+  if (!rtcPlausible(rtcNow) || errS >= RTC_MAX_ERROR_S || errS <= -RTC_MAX_ERROR_S) {
+    {
+      I2CTransaction t(I2C_DEV_RTC);
+      rtc.adjust(DateTime((uint32_t)((ntpMs + 500) / 1000)));
+    }
+    status.rtcAdjusts++;
+    rtcBaseValid = true;
+    rtcBaseSec = ntpSec;
+    rtcBaseErrS = 0;
+    addSerialLogf_P(PSTR("⚠️ RTC corrected via NTP (was %ld s off)"), (long)errS);
+  } else if (!rtcBaseValid) {
+    rtcBaseValid = true;
+    rtcBaseSec = ntpSec;
+    rtcBaseErrS = errS;
+  }
+}
+
+// ======================= NTP =======================
+static void onTimeSet(bool fromSntp) {
+  if (fromSntp) ntpSamplePending = true;
+}
+
+static void applyNtpSample() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  time_t utc = tv.tv_sec;
+  if (utc < 946684800) return;
+
+  struct tm timeinfo;
+  localtime_r(&utc, &timeinfo);
+  DateTime local(timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
+                 timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+  uint64_t ntpMs = (uint64_t)local.unixtime() * 1000ULL + tv.tv_usec / 1000;
+
+  bool firstSample = (status.ntpSamples == 0);
+  uint32_t stepsBefore = status.steps;
+  correctTo(ntpMs, TIME_SOURCE_NTP);
+  status.ntpSamples++;
+  lastNtpMillis = millis();
+  lastRtcAnchorMillis = lastNtpMillis;
+
+  if (firstSample || status.steps != stepsBefore) {
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %I:%M:%S %p", &timeinfo);
+    addSerialLogf_P(PSTR("✅ Time set via NTP (IST): %s"), buf);
+  } else {
+    addSerialLogf_P(PSTR("🕒 NTP sample, slewing %ld ms"), (long)status.lastOffsetMs);
+  }
+
+  disciplineRtc(ntpMs);
+}
+
+// ======================= Public API =======================
+void timeSyncBegin() {
+  DateTime rtcNow;
+  if (timeSyncReadRtc(&rtcNow) && rtcPlausible(rtcNow)) {
+    // RTC only counts whole seconds: assume we are mid-second
+    setClock((uint64_t)rtcNow.unixtime() * 1000ULL + 500);
+    status.source = TIME_SOURCE_RTC;
+  }
+  lastRtcAnchorMillis = millis();
+}
+
+void timeSyncStart() {
+  if (sntpStarted) return; // the core keeps re-polling by itself
+  sntpStarted = true;
+
+  settimeofday_cb(onTimeSet);
+  configTime(TIME_TZ,
+    "0.in.pool.ntp.org",
+    "1.in.pool.ntp.org",
+    "pool.ntp.org"
+  );
+  addSerialLog(F("🕒 SNTP started (background)"));
+}
+
+void timeSyncService() {
+  if (ntpSamplePending) {
+    ntpSamplePending = false;
+    applyNtpSample();
+  }
+
+  uint32_t now = millis();
+  if (now - baseMillis >= REBASE_INTERVAL_MS) rebase();
+
+  bool ntpFresh = status.ntpSamples > 0 && now - lastNtpMillis < NTP_FRESH_MS;
+  uint32_t anchorInterval = (status.source == TIME_SOURCE_NONE) ? RTC_RETRY_INTERVAL_MS
+                                                                 : RTC_REANCHOR_INTERVAL_MS;
+  if (!ntpFresh && now - lastRtcAnchorMillis >= anchorInterval) {
+    lastRtcAnchorMillis = now;
+    DateTime rtcNow;
+    if (timeSyncReadRtc(&rtcNow) && rtcPlausible(rtcNow)) {
+      uint64_t rtcMs = rtcCompensatedMs(rtcNow);
+      int64_t err = (int64_t)(rtcMs - clockNowMs());
+      // Sub-second disagreement is below the RTC's resolution
+      if (status.source == TIME_SOURCE_NONE || err > 1000 || err < -1000) {
+        correctTo(rtcMs, TIME_SOURCE_RTC);
+      }
+    }
+  }
+}
+
+bool timeSyncNow(DateTime* out) {
+  if (status.source == TIME_SOURCE_NONE) return false;
+  *out = DateTime((uint32_t)(clockNowMs() / 1000));
+  return true;
+}
+
+uint32_t timeSyncUnixtime() {
+  if (status.source == TIME_SOURCE_NONE) return 0;
+  return (uint32_t)(clockNowMs() / 1000);
+}
+
+const TimeSyncStatus& timeSyncStatus() {
+  status.slewRemainingMs = slewRemainingMs - slewApplied(millis() - baseMillis);
+  status.holding = holdClock && status.slewRemainingMs != 0;
+  status.lastNtpAgeS = status.ntpSamples ? (millis() - lastNtpMillis) / 1000 : 0xFFFFFFFFUL;
+  return status;
+}
+
+const char* timeSourceName(TimeSource source) {
+  switch (source) {
+    case TIME_SOURCE_RTC: return "rtc";
+    case TIME_SOURCE_NTP: return "ntp";
+    default:              return "none";
+  }
+}
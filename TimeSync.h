@@ -0,0 +1,75 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : TimeSync.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for TimeSync.cpp.
+   Single time source for the firmware: a software clock seeded from the
+   DS3231 at boot and disciplined by SNTP in the background. Small
+   corrections are slewed and a clock that is far ahead is held until real
+   time catches up, so timestamps never jump backwards; the RTC is only
+   rewritten when its error grows past RTC_MAX_ERROR_S, and its drift is
+   estimated between NTP samples and compensated while offline.
+
+   Exposed Functions:
+   - timeSyncBegin()     → seed the software clock from the RTC (after rtc.begin())
+   - timeSyncStart()     → start SNTP once the network is online (idempotent)
+   - timeSyncService()   → apply NTP samples / RTC re-anchoring (call from loop())
+   - timeSyncNow()       → local time (IST), false if no time source yet
+   - timeSyncUnixtime()  → local-time epoch seconds, same convention as RTClib
+   - timeSyncStatus()    → offsets, slew, RTC drift estimate
+   - timeSyncReadRtc()   → checked DS3231 read
+
+   Notes:
+   - All epochs are "local-time epochs" (DateTime(local).unixtime()), the
+     same convention the RTC and the EEPROM event log already use
+*/
+
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <Arduino.h>
+#include <RTClib.h>
+
+#define TIME_TZ "IST-5:30"
+#define TIME_SLEW_RATE_PPM 5000          // max slew: 5 ms per second
+#define TIME_STEP_THRESHOLD_MS 5000      // larger errors: step forward / hold
+#define RTC_MAX_ERROR_S 2                // rewrite the DS3231 beyond this
+#define RTC_DRIFT_MIN_BASELINE_S (6UL * 3600UL)
+#define RTC_REANCHOR_INTERVAL_MS (60UL * 60UL * 1000UL)  // offline: follow the RTC
+
+enum TimeSource {
+  TIME_SOURCE_NONE = 0,
+  TIME_SOURCE_RTC,
+  TIME_SOURCE_NTP
+};
+
+struct TimeSyncStatus {
+  TimeSource source;
+  uint32_t ntpSamples;
+  uint32_t steps;              // forward corrections too large to slew
+  uint32_t holds;              // backward ones, absorbed by holding the clock
+  bool holding;                // clock stands still until real time catches up
+  int32_t lastOffsetMs;        // NTP - software clock at the last sample
+  int32_t slewRemainingMs;
+  uint32_t lastNtpAgeS;        // 0xFFFFFFFF = never
+  int32_t rtcErrorS;           // RTC - NTP at the last sample
+  float rtcDriftPpm;           // + = RTC runs fast
+  bool rtcDriftValid;
+  uint32_t rtcAdjusts;
+};
+
+void timeSyncBegin();
+void timeSyncStart();
+void timeSyncService();
+
+bool timeSyncNow(DateTime* out);
+uint32_t timeSyncUnixtime();
+const TimeSyncStatus& timeSyncStatus();
+const char* timeSourceName(TimeSource source);
+
+bool timeSyncReadRtc(DateTime* out);
+
+#endif // TIME_SYNC_H
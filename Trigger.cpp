@@ -0,0 +1,220 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Trigger.cpp
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Pre-trigger ring, trigger conditions and capture slots (see Trigger.h).
+*/
+
+#include "Trigger.h"
+#include "MemoryConfig.h"
+#include "TimeSync.h"
+#include "AppServer.h"
+
+struct TriggerSlot {
+  CaptureHeader header;
+  TriggerSample samples[TRIGGER_SLOT_SAMPLES];
+  uint32_t seq;      // 0 = empty or being filled; 32 bits so it never wraps in practice
+};
+
+static TriggerSlot slots[MEM.triggerSlots];   // preallocated, never on the heap
+static TriggerSlot* filling = nullptr;
+static uint8_t nextSlot = 0;
+static uint32_t nextSeq = 1;
+
+static TriggerSample ring[TRIGGER_SLOT_SAMPLES];
+static uint8_t ringHead = 0;    // next write position
+static uint8_t ringCount = 0;
+
+static bool armed = false;
+static TriggerType armedType = TRIGGER_CURRENT_STEP;
+static float armedLevel = 0;
+static uint8_t armedPre = TRIGGER_SLOT_SAMPLES / 4;
+static CaptureScales scales;    // taken when armed
+
+static bool haveLast = false;
+static uint32_t lastUs = 0;
+static float lastAmps = 0;
+static float baselineAmps = 0;
+const float BASELINE_ALPHA = 0.02; // ~50 samples
+
+// ======================= Arm / disarm =======================
+bool triggerArm(TriggerType type, float level, uint8_t preSamples) {
+  if (type == TRIGGER_MANUAL || type >= TRIGGER_TYPE_COUNT) return false;
+  if (preSamples >= TRIGGER_SLOT_SAMPLES || isnan(level)) return false;
+  if (filling) return false; // previous shot still collecting post-trigger samples
+
+  armedType = type;
+  armedLevel = level;
+  armedPre = preSamples;
+  scales = captureScales();
+  ringHead = 0;
+  ringCount = 0;
+  haveLast = false;
+  armed = true;
+  return true;
+}
+
+void triggerDisarm() {
+  armed = false;
+}
+
+bool triggerArmed() {
+  return armed;
+}
+
+bool triggerActive() {
+  return armed || filling;
+}
+
+TriggerType triggerType() {
+  return armedType;
+}
+
+float triggerLevel() {
+  return armedLevel;
+}
+
+uint8_t triggerPreSamples() {
+  return armedPre;
+}
+
+// ======================= Acquisition =======================
+static void finishSlot() {
+  CaptureHeader& h = filling->header;
+  uint32_t durationUs = 0;
+  for (uint16_t i = 1; i < h.count; i++) {
+    durationUs += filling->samples[i].dt100us * 100UL;
+  }
+  h.durationUs = durationUs;
+  filling->seq = nextSeq++;
+  if (nextSeq == 0) nextSeq = 1;
+  addSerialLogf_P(PSTR("🎯 Trigger capture #%lu (%s): %u samples, %u before trigger"),
+                  (unsigned long)filling->seq, triggerTypeName(h.trigger), h.count, h.preSamples);
+  filling = nullptr;
+}
+
+static void startSlot(const TriggerSample& hit) {
+  filling = &slots[nextSlot];
+  nextSlot = (nextSlot + 1) % MEM.triggerSlots;
+
+  filling->seq = 0;
+  CaptureHeader& h = filling->header;
+  fillCaptureHeader(&h, timeSyncUnixtime(), armedType, sizeof(TriggerSample));
+  h.currentScale = scales.currentScale; // the scales the trigger level was evaluated with
+  h.currentOffset = scales.currentOffset;
+  h.voltageOffset = scales.voltageOffset;
+
+  // Oldest of the last `pre` ring entries first
+  uint8_t pre = min(armedPre, ringCount);
+  uint8_t idx = (ringHead + TRIGGER_SLOT_SAMPLES - pre) % TRIGGER_SLOT_SAMPLES;
+  for (uint8_t i = 0; i < pre; i++) {
+    filling->samples[i] = ring[idx];
+    idx = (idx + 1) % TRIGGER_SLOT_SAMPLES;
+  }
+  filling->samples[pre] = hit;
+  h.preSamples = pre;
+  h.count = pre + 1;
+  armed = false; // single shot
+}
+
+void triggerAddSample(int16_t currentRaw, uint16_t voltageRaw, uint32_t nowUs) {
+  if (!armed && !filling) return;
+
+  uint32_t dtUs = haveLast ? nowUs - lastUs : 0;
+  lastUs = nowUs;
+  TriggerSample s = { currentRaw, voltageRaw, (uint16_t)min(dtUs / 100, (uint32_t)0xFFFF) };
+
+  if (filling) {
+    CaptureHeader& h = filling->header;
+    filling->samples[h.count++] = s;
+    if (h.count >= TRIGGER_SLOT_SAMPLES) finishSlot();
+    return;
+  }
+
+  float amps = currentRaw * scales.currentScale + scales.currentOffset;
+  float volts = voltageRaw * scales.voltageScale + scales.voltageOffset;
+
+  bool hit = false;
+  if (haveLast) {
+    switch (armedType) {
+      case TRIGGER_CURRENT_STEP: hit = fabsf(amps - baselineAmps) >= armedLevel; break;
+      case TRIGGER_VOLTAGE_SAG:  hit = volts <= armedLevel; break;
+      case TRIGGER_DIDT:         hit = dtUs > 0 && fabsf(amps - lastAmps) * 1e6f / dtUs >= armedLevel; break;
+      default: break;
+    }
+    baselineAmps += BASELINE_ALPHA * (amps - baselineAmps);
+  } else {
+    baselineAmps = amps;
+  }
+  lastAmps = amps;
+  haveLast = true;
+
+  if (hit) {
+    startSlot(s);
+    return;
+  }
+
+  ring[ringHead] = s;
+  ringHead = (ringHead + 1) % TRIGGER_SLOT_SAMPLES;
+  if (ringCount < TRIGGER_SLOT_SAMPLES) ringCount++;
+}
+
+// ======================= Slots =======================
+// i = 0 is the newest completed capture
+static int slotIndex(uint8_t i) {
+  uint32_t below = 0xFFFFFFFFUL;   // seq must be lower than the previous pick
+  int pick = -1;
+  for (uint8_t n = 0; n <= i; n++) {
+    pick = -1;
+    uint32_t best = 0;
+    for (uint8_t k = 0; k < MEM.triggerSlots; k++) {
+      uint32_t seq = slots[k].seq;
+      if (seq && seq < below && seq > best) {
+        best = seq;
+        pick = k;
+      }
+    }
+    if (pick < 0) return -1;
+    below = best;
+  }
+  return pick;
+}
+
+uint8_t triggerSlotCount() {
+  uint8_t n = 0;
+  for (uint8_t k = 0; k < MEM.triggerSlots; k++) {
+    if (slots[k].seq) n++;
+  }
+  return n;
+}
+
+const CaptureHeader* triggerSlotHeader(uint8_t i) {
+  int k = slotIndex(i);
+  return k < 0 ? nullptr : &slots[k].header;
+}
+
+const TriggerSample* triggerSlotSamples(uint8_t i) {
+  int k = slotIndex(i);
+  return k < 0 ? nullptr : slots[k].samples;
+}
+
+uint32_t triggerSlotSeq(uint8_t i) {
+  int k = slotIndex(i);
+  return k < 0 ? 0 : slots[k].seq;
+}
+
+static const char* const TRIGGER_NAMES[TRIGGER_TYPE_COUNT] = { "manual", "step", "sag", "didt" };
+
+const char* triggerTypeName(uint8_t type) {
+  return type < TRIGGER_TYPE_COUNT ? TRIGGER_NAMES[type] : "?";
+}
+
+TriggerType triggerTypeFromName(const char* name) {
+  for (uint8_t t = TRIGGER_CURRENT_STEP; t < TRIGGER_TYPE_COUNT; t++) {
+    if (strcmp(name, TRIGGER_NAMES[t]) == 0) return (TriggerType)t;
+  }
+  return TRIGGER_TYPE_COUNT;
+}
@@ -0,0 +1,71 @@
+/*
+   Project   : Smart Battery Monitor (ESP8266 V1.0)
+   File      : Trigger.h
+   Author    : Akshit Singh (github.com/akshit-singhh)
+   License   : MIT License
+
+   Description:
+   Header file for Trigger.cpp.
+   Triggered waveform capture, like an oscilloscope's single-shot mode.
+   While armed, every raw ADS1115 read of the normal acquisition
+   (sampleSensors(), ~100 per second) goes into a pre-trigger ring together
+   with the INA219 bus voltage. When the trigger condition hits, the ring
+   and the following samples are frozen into a capture slot and the
+   trigger disarms.
+
+   Exposed Functions:
+   - triggerArm(type, level, pre) / triggerDisarm()  → POST /trigger
+   - triggerAddSample()      → one raw sample (called from sampleSensors())
+   - triggerActive()         → armed or still filling a slot
+   - triggerSlotCount(), triggerSlotHeader(), triggerSlotSamples() → /captures, /capture?slot=N
+   - triggerTypeName()
+
+   Notes:
+   - Triggers: current step (|I - baseline| >= level A, baseline = slow
+     average), voltage sag (V <= level V), dI/dt (|dI/dt| >= level A/s)
+   - A slot holds TRIGGER_SLOT_SAMPLES: `pre` before the trigger (fewer if
+     the ring had not filled yet), the trigger sample and the rest after it
+   - Slots are reused oldest first; slot count comes from the memory profile
+   - Sample spacing follows the loop, so every record carries its own dt
+*/
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <Arduino.h>
+#include "Capture.h"
+
+#define TRIGGER_SLOT_SAMPLES 128
+
+enum TriggerType : uint8_t {
+  TRIGGER_MANUAL = 0,     // burst captures (Capture.h)
+  TRIGGER_CURRENT_STEP,
+  TRIGGER_VOLTAGE_SAG,
+  TRIGGER_DIDT,
+  TRIGGER_TYPE_COUNT
+};
+
+struct __attribute__((packed)) TriggerSample {
+  int16_t currentRaw;   // ADS1115 conversion register
+  uint16_t voltageRaw;  // INA219 bus voltage register >> 3 (4 mV LSB)
+  uint16_t dt100us;     // time since the previous sample, 0.1 ms (saturates)
+};
+
+bool triggerArm(TriggerType type, float level, uint8_t preSamples);
+void triggerDisarm();
+bool triggerArmed();
+bool triggerActive();
+TriggerType triggerType();
+float triggerLevel();
+uint8_t triggerPreSamples();
+
+void triggerAddSample(int16_t currentRaw, uint16_t voltageRaw, uint32_t nowUs);
+
+uint8_t triggerSlotCount();                       // filled slots, newest first below
+const CaptureHeader* triggerSlotHeader(uint8_t i);   // nullptr if empty
+const TriggerSample* triggerSlotSamples(uint8_t i);
+uint32_t triggerSlotSeq(uint8_t i);               // increases with every capture
+const char* triggerTypeName(uint8_t type);
+TriggerType triggerTypeFromName(const char* name); // TRIGGER_TYPE_COUNT if unknown
+
+#endif // TRIGGER_H
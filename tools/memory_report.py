@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+Project   : Smart Battery Monitor (ESP8266 V1.0)
+File      : tools/memory_report.py
+Author    : Akshit Singh (github.com/akshit-singhh)
+License   : MIT License
+
+Description:
+Static RAM / flash budget per module, read from the linker map of an
+ESP8266 Arduino build.
+
+Usage:
+  python3 tools/memory_report.py <build>/BatteryMonitor.ino.map [--json] [--top N]
+
+  Arduino IDE: enable "Show verbose output during compilation", the build
+  directory is printed at the end. arduino-cli: --build-path <dir>.
+
+Notes:
+- DRAM   = .data + .rodata + .bss (what the heap loses before setup() runs)
+- IRAM   = .text / .iram* (instruction RAM, 32 KB on the ESP8266)
+- FLASH  = .irom0.text / .irom.text / .flash.* (code + PROGMEM)
+- Modules: sketch files by name, Arduino libraries as lib:<Name>, the
+  ESP8266 core as "core", SDK archives as sdk:<archive>
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+from collections import defaultdict
+
+REGIONS = (
+    ("dram", (".data", ".rodata", ".bss", "COMMON")),
+    ("iram", (".text", ".iram", ".literal")),
+    ("flash", (".irom0.text", ".irom.text", ".flash.", ".irom0.literal")),
+)
+
+# " .bss.serialLogBuffer  0x3ffef000  0x1c20 /path/AppServer.cpp.o"
+# or the same split over two lines when the section name is long.
+INPUT_LINE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+NAME_ONLY = re.compile(r"^ (\.\S+|COMMON)\s*$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def region_of(section):
+    # flash prefixes first: ".irom0.text" would otherwise match ".text"
+    for region, prefixes in (REGIONS[2], REGIONS[0], REGIONS[1]):
+        if any(section.startswith(p) for p in prefixes):
+            return region
+    return None
+
+
+def module_of(path):
+    path = path.replace("\\", "/")
+    m = re.search(r"/libraries/([^/]+)/", path)
+    if m:
+        return "lib:" + m.group(1)
+    if "/sketch/" in path:
+        base = os.path.basename(path)
+        return re.sub(r"(\.ino)?\.cpp\.o$|\.c\.o$|\.S\.o$", "", base)
+    if "/core/" in path or "core.a" in path or "/cores/" in path:
+        return "core"
+    m = re.search(r"/lib([^/]+?)\.a\(", path)
+    if m:
+        return "sdk:" + m.group(1)
+    return "other:" + os.path.basename(path.split("(")[0])
+
+
+def symbol_of(section):
+    # -ffunction-sections / -fdata-sections put the symbol in the name
+    for prefix in (".irom0.text.", ".text.", ".bss.", ".data.", ".rodata."):
+        if section.startswith(prefix):
+            return section[len(prefix):]
+    return section
+
+
+def parse_map(path):
+    totals = defaultdict(lambda: defaultdict(int))
+    symbols = []
+    in_map = False
+    pending = None
+    with open(path, errors="replace") as f:
+        for line in f:
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            line = line.rstrip("\n")
+            entry = None
+            m = INPUT_LINE.match(line)
+            if m:
+                entry = (m.group(1), int(m.group(3), 16), m.group(4))
+                pending = None
+            elif pending:
+                c = CONTINUATION.match(line)
+                if c:
+                    entry = (pending, int(c.group(2), 16), c.group(3))
+                pending = None
+            else:
+                n = NAME_ONLY.match(line)
+                pending = n.group(1) if n else None
+            if not entry:
+                continue
+            section, size, obj = entry
+            region = region_of(section)
+            if not region or size == 0 or not obj.endswith((".o", ")")):
+                continue
+            module = module_of(obj)
+            totals[module][region] += size
+            symbols.append((size, region, module, symbol_of(section)))
+    return totals, symbols
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("Usage:")[0])
+    ap.add_argument("map", help="linker map file (<sketch>.ino.map)")
+    ap.add_argument("--json", action="store_true", help="machine-readable output")
+    ap.add_argument("--top", type=int, default=15, help="largest DRAM symbols to list")
+    args = ap.parse_args()
+
+    totals, symbols = parse_map(args.map)
+    if not totals:
+        sys.exit("no input sections found - is this a GNU ld map file?")
+
+    rows = sorted(totals.items(), key=lambda kv: -(kv[1]["dram"] * 4 + kv[1]["flash"]))
+    dram_syms = sorted((s for s in symbols if s[1] == "dram"), reverse=True)[:args.top]
+
+    if args.json:
+        json.dump({
+            "modules": {mod: {reg: r[reg] for reg, _ in REGIONS} for mod, r in rows},
+            "totals": {reg: sum(r[reg] for _, r in rows) for reg, _ in REGIONS},
+            "top_dram": [{"symbol": s[3], "module": s[2], "bytes": s[0]} for s in dram_syms],
+        }, sys.stdout, indent=2)
+        print()
+        return
+
+    print(f"{'module':<28}{'DRAM':>10}{'IRAM':>10}{'FLASH':>10}")
+    for mod, r in rows:
+        print(f"{mod:<28}{r['dram']:>10}{r['iram']:>10}{r['flash']:>10}")
+    print("-" * 58)
+    print(f"{'total':<28}" + "".join(f"{sum(r[reg] for _, r in rows):>10}" for reg, _ in REGIONS))
+    print("\nLargest DRAM symbols:")
+    for size, _, module, sym in dram_syms:
+        print(f"  {size:>7}  {module:<20} {sym}")
+
+
+if __name__ == "__main__":
+    main()